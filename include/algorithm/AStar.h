@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "types/Position.h"
 #include "types/Types.h"
@@ -10,4 +11,10 @@ namespace Game3 {
 	class Realm;
 
 	bool simpleAStar(const std::shared_ptr<Realm> &realm, const Position &from, const Position &to, std::vector<Position> &path, size_t loop_max = 1'000);
+
+	/** A* specialized for the tile grid. Searches a chunk-aligned window around the endpoints using per-thread dense scratch buffers
+	 *  indexed by local coordinates, and copies each path chunk's states into the window the first time the search reaches it.
+	 *  Falls back to simpleAStar if the window would be too large or if a failed search ran into the edge of the window.
+	 *  Like simpleAStar, the path includes both endpoints. */
+	bool gridAStar(const std::shared_ptr<Realm> &realm, const Position &from, const Position &to, std::vector<Position> &path, size_t loop_max = 1'000);
 }
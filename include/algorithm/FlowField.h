@@ -0,0 +1,64 @@
+#pragma once
+
+#include "types/Direction.h"
+#include "types/Position.h"
+#include "types/Types.h"
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace Game3 {
+	class TileProvider;
+
+	/** A breadth-first distance map toward a single goal, covering a square window around it. Meant to be shared by every
+	 *  entity heading for the same goal, such as monsters chasing a player. The field is only expanded as far as the farthest
+	 *  entity that has asked for a path. When the goal moves, the expansion restarts in place: the window's path states are
+	 *  only copied again once the goal has drifted away from the window's center, and distances are reset by a stamp. */
+	class FlowField {
+		public:
+			constexpr static Index DEFAULT_RADIUS = 32;
+
+			/** Positions within radius tiles of the goal on both axes are always covered by the field. */
+			FlowField(Index radius_ = DEFAULT_RADIUS);
+
+			/** Marks the window's path states as out of date, e.g. because a tile's path state changed. */
+			void invalidate();
+			inline Index getRadius() const { return radius; }
+
+			/** Appends the steps of a shortest path from start to a tile next to the goal. Moves the field to the goal first if
+			 *  necessary. Returns false if start is outside the field or can't reach the goal. */
+			bool getPath(const TileProvider &, const Position &goal, const Position &start, std::list<Direction> &);
+
+		private:
+			const Index radius;
+			/** How far the goal may move from the window's center before the window is moved. */
+			const Index slack;
+			const Index width;
+			std::mutex mutex;
+			std::atomic_bool stale = true;
+			bool hasGoal = false;
+			Position goal;
+			/** The window's top left corner. */
+			Position origin;
+			std::vector<uint16_t> distances;
+			/** A distance is only valid if its stamp matches the current stamp. */
+			std::vector<uint32_t> stamps;
+			uint32_t stamp = 0;
+			std::vector<uint8_t> pathStates;
+			/** The BFS queue. Entries before queueHead have been expanded. */
+			std::vector<uint32_t> queue;
+			size_t queueHead = 0;
+
+			/** Copies the path states of a window centered on the given position. */
+			void load(const TileProvider &, const Position &center);
+			void restart(const Position &new_goal);
+			/** Expands the field until the tile at the given index has a distance or the window is exhausted. */
+			bool expandTo(uint32_t index);
+			bool contains(const Position &) const;
+			uint32_t toIndex(const Position &) const;
+			inline bool visited(uint32_t index) const { return stamps[index] == stamp; }
+	};
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "types/ChunkPosition.h"
+#include "types/Position.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace Game3 {
+	class TileProvider;
+
+	/** A chunk-level abstraction of a realm's pathmap for finding long paths cheaply (HPA*). Each chunk border is split into
+	 *  portals wherever both sides are walkable, and the walking distances between a chunk's portals are cached until a tile in
+	 *  the chunk changes. Routes are found over the portals and returned as waypoints that can be refined into tile paths
+	 *  one leg at a time. Thread-safe. */
+	class PathGraph {
+		public:
+			/** The default maximum number of portals expanded by findWaypoints. */
+			constexpr static size_t DEFAULT_MAX_EXPANSIONS = 20'000;
+
+			PathGraph(const TileProvider &);
+
+			/** Forgets cached data for a chunk whose pathmap has changed, along with the portals its neighbors share with it. */
+			void invalidate(ChunkPosition);
+			/** Forgets cached data affected by a change to a single tile's path state. */
+			void invalidate(const Position &);
+			void clear();
+
+			/** Finds a route from start to goal. On success, the waypoints are the first tile of each chunk the route enters,
+			 *  followed by the goal; consecutive waypoints are never more than a chunk apart. */
+			bool findWaypoints(const Position &start, const Position &goal, std::vector<Position> &waypoints, size_t max_expansions = DEFAULT_MAX_EXPANSIONS);
+
+		private:
+			struct ChunkGraph {
+				/** Portal tiles inside the chunk. */
+				std::vector<Position> nodes;
+				std::unordered_map<Position, uint16_t> nodeIndices;
+				/** distances[i * nodes.size() + j] is the walking distance between nodes i and j within the chunk, or UNREACHABLE. */
+				std::vector<uint16_t> distances;
+			};
+
+			const TileProvider &provider;
+			/** Guards chunks and generation. Only held to look up, cache or forget a graph, never while building one or
+			 *  searching, so concurrent searches don't wait on each other. */
+			std::mutex mutex;
+			/** Cached graphs are immutable once built. A search holds on to the ones it uses, so invalidating a chunk
+			 *  mid-search only affects later searches. */
+			std::unordered_map<ChunkPosition, std::shared_ptr<const ChunkGraph>> chunks;
+			/** Bumped whenever anything is invalidated, so that a graph built from pathmaps that changed during the build
+			 *  isn't cached. */
+			uint64_t generation = 0;
+
+			/** Returns the chunk's graph, building it first if it isn't cached. The mutex must not be held. */
+			std::shared_ptr<const ChunkGraph> getGraph(ChunkPosition);
+			std::shared_ptr<const ChunkGraph> build(ChunkPosition) const;
+			/** The mutex must be held. */
+			void invalidateUnlocked(ChunkPosition);
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "Constants.h"
+#include "threading/Lockable.h"
+#include "threading/ThreadPool.h"
+#include "types/Position.h"
+#include "types/Types.h"
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <vector>
+
+namespace Game3 {
+	class Realm;
+
+	struct PathSearch {
+		Position start;
+		Position goal;
+		PathResult result = PathResult::Invalid;
+		/** The tiles from the start to the goal or, for routes found over the realm's path graph, to the first waypoint. */
+		std::vector<Position> positions;
+		/** The waypoints left after the first leg of a route found over the realm's path graph. */
+		std::vector<Position> waypoints;
+	};
+
+	/** Runs entities' path searches on worker threads so that realms don't have to wait for them while ticking.
+	 *  Identical requests made while a search is still running share its result. */
+	class PathfindingPool {
+		public:
+			/** Called on a worker thread once the search is done. */
+			using Callback = std::function<void(const std::shared_ptr<const PathSearch> &)>;
+
+			/** Loops given to gridAStar when refining a single leg of a long route. */
+			constexpr static size_t LEG_LOOP_MAX = 4 * CHUNK_SIZE * CHUNK_SIZE;
+
+			PathfindingPool(size_t thread_count);
+
+			void start();
+			void join();
+
+			/** Returns false if the pool isn't running, in which case the callback won't be called. */
+			bool request(const std::shared_ptr<Realm> &, const Position &start, const Position &goal, size_t loop_max, Callback);
+
+			inline size_t getSearchCount() const { return searchCount; }
+			inline size_t getSharedCount() const { return sharedCount; }
+
+			/** Searches synchronously. Distant goals that gridAStar can't reach within loop_max are routed over the realm's
+			 *  path graph instead, with only the first leg refined into tiles. */
+			static PathSearch search(const std::shared_ptr<Realm> &, const Position &start, const Position &goal, size_t loop_max);
+
+		private:
+			using Key = std::tuple<RealmID, Position, Position, size_t>;
+
+			ThreadPool pool;
+			Lockable<std::map<Key, std::vector<Callback>>> pending;
+			std::atomic_size_t searchCount = 0;
+			/** The number of requests that were given the result of a search requested by someone else. */
+			std::atomic_size_t sharedCount = 0;
+	};
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "types/Direction.h"
+#include "types/Position.h"
+#include "types/Types.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace Game3 {
+	/** A uniform grid of small square cells for finding entities near a position. Each cell keeps the GIDs and positions of
+	 *  its entities in parallel arrays, so queries only scan the cells they overlap and never touch the entities themselves.
+	 *  Visitors return true to stop a query early. Not synchronized. */
+	class SpatialHash {
+		public:
+			constexpr static Index DEFAULT_CELL_SIZE = 8;
+
+			SpatialHash(Index cell_size = DEFAULT_CELL_SIZE);
+
+			/** Adds the entity, or moves it if it's already present. */
+			void insert(GlobalID, const Position &);
+			/** Returns false if the entity isn't present. */
+			bool move(GlobalID, const Position &);
+			/** Returns false if the entity isn't present. */
+			bool remove(GlobalID);
+			void clear();
+			inline size_t size() const { return positions.size(); }
+			inline bool contains(GlobalID gid) const { return positions.contains(gid); }
+
+			/** Visits entities whose maximum axis distance from the center is less than the radius, the way
+			 *  Realm::findEntitiesSquare measures it. Returns true if the visitor stopped the query. */
+			template <typename Fn>
+			bool visitSquare(const Position &center, uint64_t radius, Fn &&visitor) const {
+				if (radius == 0)
+					return false;
+
+				const Index extent = static_cast<Index>(radius) - 1;
+				return visitRange(center.row - extent, center.column - extent, center.row + extent, center.column + extent, visitor);
+			}
+
+			/** Visits entities whose Euclidean distance from the center is at most the radius. */
+			template <typename Fn>
+			bool visitCircle(const Position &center, double radius, Fn &&visitor) const {
+				if (radius < 0)
+					return false;
+
+				const Index extent = static_cast<Index>(radius);
+				const double radius_squared = radius * radius;
+				return visitRange(center.row - extent, center.column - extent, center.row + extent, center.column + extent, [&](GlobalID gid, const Position &position) {
+					const double row = position.row - center.row;
+					const double column = position.column - center.column;
+					return row * row + column * column <= radius_squared && visitor(gid, position);
+				});
+			}
+
+			/** Visits entities on the length tiles after the origin in the given direction, nearest first. */
+			template <typename Fn>
+			bool visitRay(const Position &origin, Direction direction, uint64_t length, Fn &&visitor) const {
+				const Position step = toPosition(direction);
+				const Cell *cell = nullptr;
+				uint64_t cell_key = 0;
+				bool have_cell = false;
+
+				Position position = origin;
+				for (uint64_t i = 0; i < length; ++i) {
+					position += step;
+
+					if (const uint64_t key = getKey(position); !have_cell || key != cell_key) {
+						have_cell = true;
+						cell_key = key;
+						auto iter = cells.find(key);
+						cell = iter == cells.end()? nullptr : &iter->second;
+					}
+
+					if (cell)
+						for (size_t j = 0; j < cell->gids.size(); ++j)
+							if (cell->positions[j] == position && visitor(cell->gids[j], cell->positions[j]))
+								return true;
+				}
+
+				return false;
+			}
+
+		private:
+			struct Cell {
+				std::vector<GlobalID> gids;
+				std::vector<Position> positions;
+			};
+
+			Index cellSize;
+			std::unordered_map<uint64_t, Cell> cells;
+			std::unordered_map<GlobalID, Position> positions;
+
+			inline Index toCell(Index coordinate) const {
+				return coordinate < 0? -((-coordinate - 1) / cellSize) - 1 : coordinate / cellSize;
+			}
+
+			inline static uint64_t packKey(Index cell_row, Index cell_column) {
+				return (static_cast<uint64_t>(static_cast<uint32_t>(cell_row)) << 32) | static_cast<uint32_t>(cell_column);
+			}
+
+			inline uint64_t getKey(const Position &position) const {
+				return packKey(toCell(position.row), toCell(position.column));
+			}
+
+			void eraseFromCell(GlobalID, const Position &);
+
+			/** Visits entities in the inclusive tile rectangle. */
+			template <typename Fn>
+			bool visitRange(Index top, Index left, Index bottom, Index right, Fn &&visitor) const {
+				auto visit_cell = [&](const Cell &cell) {
+					for (size_t i = 0; i < cell.gids.size(); ++i) {
+						const Position &position = cell.positions[i];
+						if (top <= position.row && position.row <= bottom && left <= position.column && position.column <= right)
+							if (visitor(cell.gids[i], position))
+								return true;
+					}
+					return false;
+				};
+
+				const uint64_t cell_rows = toCell(bottom) - toCell(top) + 1;
+				const uint64_t cell_columns = toCell(right) - toCell(left) + 1;
+
+				// For huge ranges it's cheaper to go through the occupied cells than to look up every cell in range.
+				if (cells.size() < cell_rows * cell_columns) {
+					for (const auto &[key, cell]: cells)
+						if (visit_cell(cell))
+							return true;
+					return false;
+				}
+
+				for (Index cell_row = toCell(top), max_row = toCell(bottom); cell_row <= max_row; ++cell_row) {
+					for (Index cell_column = toCell(left), max_column = toCell(right); cell_column <= max_column; ++cell_column) {
+						auto iter = cells.find(packKey(cell_row, cell_column));
+						if (iter == cells.end())
+							continue;
+
+						if (visit_cell(iter->second))
+							return true;
+					}
+				}
+
+				return false;
+			}
+	};
+}
@@ -1,22 +1,182 @@
 #pragma once
 
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
 #include <memory>
-#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace Game3 {
+	/** A set of weak pointers keyed by the address of the object each one pointed to when it was inserted. Lookups with a
+	 *  shared pointer don't touch any reference counts, and lookups with a weak pointer lock it once. Entries are kept in a
+	 *  dense array for iteration; erasing moves the last entry into the erased entry's place, so order isn't preserved.
+	 *  Expired entries stay in the set (and are still visited) until they're erased or swept. Inserting sweeps them
+	 *  automatically whenever the set has doubled in size since the last sweep. Not synchronized. */
 	template <typename T>
-	struct WeakCompare {
-		bool operator()(std::weak_ptr<T> left, std::weak_ptr<T> right) const {
-			auto llock = left.lock();
-			auto rlock = right.lock();
-			if (!rlock)
+	class WeakSet {
+		public:
+			using value_type = std::weak_ptr<T>;
+			using iterator = typename std::vector<std::weak_ptr<T>>::const_iterator;
+			using const_iterator = iterator;
+
+			constexpr static size_t MIN_SWEEP_SIZE = 16;
+
+			WeakSet() = default;
+
+			inline iterator begin() const { return entries.begin(); }
+			inline iterator end() const { return entries.end(); }
+			inline size_t size() const { return entries.size(); }
+			inline bool empty() const { return entries.empty(); }
+
+			/** Returns true if the pointer wasn't already present. */
+			template <typename U> requires std::convertible_to<U *, T *>
+			bool insert(const std::shared_ptr<U> &pointer) {
+				if (!pointer)
+					return false;
+				return insertKeyed(static_cast<const T *>(pointer.get()), pointer);
+			}
+
+			template <typename U> requires std::convertible_to<U *, T *>
+			bool insert(const std::weak_ptr<U> &weak) {
+				if (auto locked = weak.lock())
+					return insert(locked);
 				return false;
-			if (!llock)
+			}
+
+			template <typename U> requires std::convertible_to<U *, T *>
+			iterator find(const std::shared_ptr<U> &pointer) const {
+				if (!pointer)
+					return end();
+				return begin() + findIndex(static_cast<const T *>(pointer.get()), pointer);
+			}
+
+			/** Expired weak pointers can't be hashed, so looking one up falls back to comparing owners one by one. */
+			template <typename U> requires std::convertible_to<U *, T *>
+			iterator find(const std::weak_ptr<U> &weak) const {
+				if (auto locked = weak.lock())
+					return find(locked);
+
+				return std::find_if(begin(), end(), [&](const std::weak_ptr<T> &entry) {
+					return !entry.owner_before(weak) && !weak.owner_before(entry);
+				});
+			}
+
+			template <typename P>
+			inline bool contains(const P &pointer) const {
+				return find(pointer) != end();
+			}
+
+			/** Returns an iterator to the entry that took the erased entry's place. */
+			iterator erase(iterator iter) {
+				const size_t index = iter - begin();
+				removeAt(index);
+				return begin() + index;
+			}
+
+			template <typename P>
+			size_t erase(const P &pointer) {
+				if (auto iter = find(pointer); iter != end()) {
+					erase(iter);
+					return 1;
+				}
+				return 0;
+			}
+
+			template <typename Predicate>
+			size_t eraseIf(Predicate &&predicate) {
+				size_t erased = 0;
+				for (size_t index = 0; index < entries.size();) {
+					if (predicate(std::as_const(entries[index]))) {
+						removeAt(index);
+						++erased;
+					} else {
+						++index;
+					}
+				}
+				return erased;
+			}
+
+			/** Removes every expired entry. Returns how many were removed. */
+			size_t sweep() {
+				const size_t erased = eraseIf([](const std::weak_ptr<T> &entry) {
+					return entry.expired();
+				});
+				sweepSize = std::max(MIN_SWEEP_SIZE, 2 * entries.size());
+				return erased;
+			}
+
+			void clear() {
+				entries.clear();
+				keys.clear();
+				indices.clear();
+				sweepSize = MIN_SWEEP_SIZE;
+			}
+
+		private:
+			std::vector<std::weak_ptr<T>> entries;
+			/** keys[i] is the address entries[i] pointed to when it was inserted. */
+			std::vector<const T *> keys;
+			std::unordered_map<const T *, size_t> indices;
+			size_t sweepSize = MIN_SWEEP_SIZE;
+
+			/** Returns entries.size() if the object isn't present. An expired entry whose address has been reused by a new
+			 *  object has a different owner, so it doesn't count as a match. */
+			template <typename P>
+			size_t findIndex(const T *key, const P &owner) const {
+				auto iter = indices.find(key);
+				if (iter == indices.end())
+					return entries.size();
+
+				const std::weak_ptr<T> &entry = entries[iter->second];
+				if (entry.owner_before(owner) || owner.owner_before(entry))
+					return entries.size();
+
+				return iter->second;
+			}
+
+			template <typename U>
+			bool insertKeyed(const T *key, const std::shared_ptr<U> &pointer) {
+				if (auto iter = indices.find(key); iter != indices.end()) {
+					std::weak_ptr<T> &entry = entries[iter->second];
+					if (!entry.owner_before(pointer) && !pointer.owner_before(entry))
+						return false;
+					// The old object at this address is gone.
+					entry = pointer;
+					return true;
+				}
+
+				if (sweepSize <= entries.size())
+					sweep();
+
+				indices.emplace(key, entries.size());
+				entries.emplace_back(pointer);
+				keys.push_back(key);
 				return true;
-			return llock.get() < rlock.get();
-		}
+			}
+
+			void removeAt(size_t index) {
+				indices.erase(keys[index]);
+
+				if (const size_t last = entries.size() - 1; index != last) {
+					entries[index] = std::move(entries[last]);
+					keys[index] = keys[last];
+					indices[keys[index]] = index;
+				}
+
+				entries.pop_back();
+				keys.pop_back();
+			}
 	};
 
 	template <typename T>
-	using WeakSet = std::set<std::weak_ptr<T>, WeakCompare<T>>;
+	std::unordered_set<std::shared_ptr<T>> filterWeak(const WeakSet<T> &set) {
+		std::unordered_set<std::shared_ptr<T>> out;
+		for (const auto &weak: set)
+			if (auto locked = weak.lock())
+				out.insert(locked);
+		return out;
+	}
 }
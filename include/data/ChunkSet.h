@@ -25,6 +25,7 @@ namespace Game3 {
 			ChunkSet(std::vector<TileChunk>, BiomeChunk, FluidChunk, PathChunk);
 			ChunkSet(std::span<const uint8_t>);
 			ChunkSet(std::span<const char>);
+			/** If the pathmap span is empty, the pathmap will be zeroed and will need to be remade. */
 			ChunkSet(std::span<const char> terrain_, std::span<const char> biomes_, std::span<const char> fluids_, std::span<const char> pathmap_);
 
 			template <typename C>
@@ -12,6 +12,7 @@
 #include <optional>
 #include <span>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include <SQLiteCpp/SQLiteCpp.h>
@@ -30,8 +31,19 @@ namespace Game3 {
 			std::filesystem::path path;
 
 			void bind(SQLite::Statement &, const std::shared_ptr<Player> &);
+			/** Whether autosave() is running. Guarded by the database lock. */
+			bool autosaving = false;
+			/** Global IDs of entities and tile entities deleted while autosave() is running, which it mustn't write back.
+			 *  Guarded by the database lock. */
+			std::unordered_set<GlobalID> deletedDuringAutosave;
+
+			/** Adds the format column to old chunk tables and compresses chunks stored in older formats. */
+			void migrateChunks();
 
 		public:
+			/** The maximum number of rows autosave() writes in a single transaction. */
+			constexpr static size_t AUTOSAVE_BATCH_SIZE = 64;
+
 			Lockable<std::unique_ptr<SQLite::Database>, std::recursive_mutex> database;
 
 			GameDB(ServerGame &);
@@ -42,6 +54,11 @@ namespace Game3 {
 			void writeAll();
 			void readAll();
 
+			/** Writes the rules, realm metadata, players, entities, tile entities and dirty chunks without pausing ticking.
+			 *  Anything that isn't safe to read off the tick thread is encoded on the tick thread, but all database access
+			 *  happens on the calling thread in transactions of at most AUTOSAVE_BATCH_SIZE rows. Shouldn't be called on the tick thread. */
+			void autosave();
+
 			void writeRules();
 			void readRules();
 
@@ -52,8 +69,19 @@ namespace Game3 {
 
 			void writeChunk(const std::shared_ptr<Realm> &, ChunkPosition, bool use_transaction = true);
 
+			/** Writes multiple chunks of a realm in a single transaction. Chunks are compressed before the database is locked. */
+			void writeChunks(const std::shared_ptr<Realm> &, const std::vector<ChunkPosition> &);
+
+			/** Writes every chunk of a realm that has changed since it was last saved, in transactions of at most AUTOSAVE_BATCH_SIZE chunks. */
+			void writeDirtyChunks(const std::shared_ptr<Realm> &);
+
+			/** Loads every realm that has stored chunks. Chunks themselves are paged in on demand by each realm's tile provider,
+			 *  except in realms whose tiles need to be migrated to a new tileset. */
 			void readAllRealms();
 
+			/** Loads every stored chunk of a realm into memory. */
+			void readAllChunks(const std::shared_ptr<Realm> &, bool do_lock = true);
+
 			/** Reads metadata from the database and returns an empty realm based on the metadata. */
 			std::shared_ptr<Realm> loadRealm(RealmID, bool do_lock);
 
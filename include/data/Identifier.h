@@ -1,58 +1,84 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 
 #include <nlohmann/json_fwd.hpp>
 
 namespace Game3 {
 	class Buffer;
 
-	struct Identifier {
-		std::string space;
-		std::string name;
+	/** A namespaced name like "base:item/stone". Identifiers are interned in a global table that's never cleared, so an
+	 *  Identifier is just a 32-bit handle: copying, equality and hashing don't touch the strings, which are only looked up
+	 *  when they're asked for. Handles are process-local; serialization always goes through the strings. Decoding an
+	 *  identifier from a Buffer only looks it up, so peers can't grow the table. */
+	class Identifier {
+		public:
+			using Handle = uint32_t;
 
-		Identifier() = default;
-		Identifier(const char *space_, const char *name_): space(space_), name(name_) {}
-		Identifier(std::string_view);
-		Identifier(const char *);
+			Identifier() = default;
+			Identifier(std::string_view space_, std::string_view name_);
+			Identifier(std::string_view);
+			Identifier(const char *);
 
-		inline explicit operator bool() const {
-			return !empty();
-		}
+			inline explicit operator bool() const {
+				return !empty();
+			}
 
-		inline bool empty() const {
-			if (space.empty() != name.empty())
-				throw std::runtime_error("Partially empty identifier");
-			return space.empty();
-		}
+			/** Throws if only one of the space and the name is empty. */
+			bool empty() const;
 
-		inline explicit operator std::string() const {
-			return space + ':' + name;
-		}
+			inline explicit operator std::string() const {
+				return str();
+			}
 
-		inline std::string str() const {
-			return static_cast<std::string>(*this);
-		}
+			/** The combined "space:name" string. */
+			const std::string & str() const;
 
-		inline bool inSpace(std::string_view check) const {
-			return std::string_view(space) == check;
-		}
+			std::string_view getSpace() const;
+			std::string_view getName() const;
+
+			inline bool inSpace(std::string_view check) const {
+				return getSpace() == check;
+			}
+
+			inline Handle getHandle() const {
+				return handle;
+			}
+
+			/** Returns "foo/bar" for "base:foo/bar/baz". */
+			std::string getPath() const;
+
+			/** Returns "foo" for "base:foo/bar/baz". */
+			std::string getPathStart() const;
+
+			/** Returns "baz" for "base:foo/bar/baz". */
+			std::string getPostPath() const;
+
+			/** Returns the identifier for a "space:name" string if it's already been interned. Never grows the table,
+			 *  so it's what untrusted input should go through. */
+			static std::optional<Identifier> find(std::string_view);
+
+			/** Returns the number of distinct identifiers interned so far, including the empty identifier. */
+			static size_t getInternedCount();
 
-		/** Returns "foo/bar" for "base:foo/bar/baz". */
-		std::string getPath() const;
+			bool operator==(const char *) const;
+			bool operator==(std::string_view) const;
 
-		/** Returns "foo" for "base:foo/bar/baz". */
-		std::string getPathStart() const;
+			inline bool operator==(const Identifier &other) const {
+				return handle == other.handle;
+			}
 
-		/** Returns "baz" for "base:foo/bar/baz". */
-		std::string getPostPath() const;
+			/** Orders by space, then by name, so ordered containers iterate the same way in every process. */
+			bool operator<(const Identifier &) const;
 
-		bool operator==(const char *) const;
-		bool operator==(std::string_view) const;
-		bool operator==(const Identifier &) const;
-		bool operator<(const Identifier &) const;
+		private:
+			/** 0 is the empty identifier. */
+			Handle handle = 0;
 	};
 
 	void from_json(const nlohmann::json &, Identifier &);
@@ -73,7 +99,7 @@ namespace std {
 	template <>
 	struct hash<Game3::Identifier> {
 		size_t operator()(const Game3::Identifier &identifier) const {
-			return std::hash<std::string>()(static_cast<std::string>(identifier));
+			return std::hash<Game3::Identifier::Handle>()(identifier.getHandle());
 		}
 	};
 }
@@ -6,7 +6,6 @@
 #include <random>
 
 #include "entity/LivingEntity.h"
-#include "threading/ThreadPool.h"
 
 namespace Game3 {
 	class Building;
@@ -23,7 +22,6 @@ namespace Game3 {
 			bool onInteractNextTo(const std::shared_ptr<Player> &, Modifiers, ItemStack *, Hand) override;
 			void toJSON(nlohmann::json &) const override;
 			void absorbJSON(Game &, const nlohmann::json &) override;
-			void init(Game &) override;
 			void tick(Game &, float) override;
 			float getMovementSpeed() const override { return 5.f; }
 			HitPoints getMaxHealth() const override;
@@ -36,7 +34,5 @@ namespace Game3 {
 
 			std::optional<std::list<Direction>> wanderPath;
 			std::atomic_bool attemptingWander = false;
-
-			static ThreadPool threadPool;
 	};
 }
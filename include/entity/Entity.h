@@ -41,6 +41,7 @@ namespace Game3 {
 	class Realm;
 	class RemoteClient;
 	class TileEntity;
+	struct PathSearch;
 	struct RendererContext;
 
 	struct EntityTexture: NamedRegisterable {
@@ -134,6 +135,12 @@ namespace Game3 {
 			void queueDestruction();
 			PathResult pathfind(const Position &start, const Position &goal, std::list<Direction> &, size_t loop_max = 1'000);
 			bool pathfind(const Position &goal, size_t loop_max = 1'000);
+			/** Queues a search on the server's pathfinding pool. The path is applied on the first tick after the search is
+			 *  done unless the entity has moved or asked for another path since then. Searches synchronously on clients. */
+			void pathfindAsync(const Position &goal, size_t loop_max = 1'000);
+			inline bool isAwaitingPath() const { return awaitingPath; }
+			/** Replaces the path with one computed elsewhere, e.g. from a flow field, and tells players about it. */
+			void setPath(std::list<Direction>, const Position &goal);
 			virtual float getMovementSpeed() const { return MAX_SPEED; }
 			Game & getGame();
 			Game & getGame() const;
@@ -197,6 +204,12 @@ namespace Game3 {
 			Entity(EntityType);
 
 			bool canMoveTo(const Position &) const;
+			/** If the teleport would move the entity to a different realm while realms are being ticked in parallel,
+			 *  defers the teleport until all realms are done ticking and returns true. */
+			bool deferRealmChange(const Position &, const std::shared_ptr<Realm> &, MovementContext);
+			/** If the teleport would reach further than Realm::PARALLEL_TICK_REACH chunks or into another realm while the
+			 *  entity's realm is ticking chunks in parallel, queues it on the realm and returns true. */
+			bool deferFarTeleport(const Position &, const std::shared_ptr<Realm> &, MovementContext);
 			/** A list of functions to call the next time the entity moves. Each function returns whether it should be removed from the queue. */
 			Lockable<std::list<std::function<bool(const std::shared_ptr<Entity> &)>>> moveQueue;
 			std::shared_ptr<Texture> getTexture();
@@ -223,8 +236,26 @@ namespace Game3 {
 			Held heldRight{false};
 			/** The set of all players who have been sent a packet about the entity's current path. Governed by pathSeersMutex */
 			Lockable<WeakSet<Player>> pathSeers;
+			/** The remaining waypoints of a long route found with the realm's path graph. Each is refined into a path only
+			 *  once the entity has walked to the one before it. */
+			Lockable<std::list<Position>> waypoints;
+			/** Incremented for every path request so that results of superseded searches can be ignored. */
+			Atomic<uint64_t> pathRequestID = 0;
+			Atomic<bool> awaitingPath = false;
+			/** The result of the latest asynchronous search, waiting to be applied on the next tick. */
+			Lockable<std::shared_ptr<const PathSearch>> pendingPath;
+			/** The request ID pendingPath belongs to. Governed by pendingPath's mutex. */
+			uint64_t pendingPathID = 0;
 
 			bool setHeld(Slot, Held &);
+			/** Replaces the path with one to the next waypoint. Returns false if there are no more waypoints or the next one
+			 *  can't be reached anymore, in which case the remaining waypoints are discarded. */
+			bool followWaypoint();
+			/** Replaces the path and waypoints with the result of a search. Returns whether the goal is reachable. */
+			bool applyPath(const PathSearch &);
+			void applyPendingPath();
+			/** Sends the entity's path to all players who can see it. */
+			void broadcastPath();
 	};
 
 	void to_json(nlohmann::json &, const Entity &);
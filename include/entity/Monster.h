@@ -2,10 +2,14 @@
 
 #include "entity/LivingEntity.h"
 
+#include <memory>
+
 // When attacked, monsters will attack their attacker and move towards them if the attacker tries to escape.
 // If they go a certain duration of time without landing a hit, they give up chasing the attacker.
 
 namespace Game3 {
+	class FlowField;
+
 	class Monster: public LivingEntity {
 		public:
 			void tick(Game &, float) override;
@@ -24,6 +28,8 @@ namespace Game3 {
 			float timeSinceSearch = 0;
 			float timeSinceAdjustment = 0;
 			std::weak_ptr<LivingEntity> weakTarget;
+			/** Shared with every other monster chasing the same target. */
+			std::shared_ptr<FlowField> flowField;
 
 			Monster();
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "entity/Player.h"
+#include "net/FramedPacket.h"
 #include "threading/Lockable.h"
 #include "container/WeakSet.h"
 
@@ -20,6 +21,10 @@ namespace Game3 {
 			bool ensureEntity(const std::shared_ptr<Entity> &);
 			std::shared_ptr<RemoteClient> getClient() const;
 
+			using Player::send;
+			/** Sends an already framed packet, e.g. one being broadcast to many players. Returns false if the player has no client. */
+			bool send(const FramedPacket &);
+
 			void handleMessage(const std::shared_ptr<Agent> &source, const std::string &name, std::any &data) final;
 
 			void kill() override;
@@ -3,11 +3,188 @@
 #include "types/Types.h"
 #include "threading/Lockable.h"
 
+#include <atomic>
+#include <optional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace Game3 {
+	/** A chunk's worth of per-tile data. Single elements can be read without locking: writers that hold the chunk's unique
+	 *  lock keep a sequence counter odd for the duration of the write, and readers retry (eventually falling back to the
+	 *  shared lock) if the counter changed while they were reading. Writers that might overlap optimistic readers have to
+	 *  go through store. Changing a chunk's size or storage while other threads might be reading it optimistically is not
+	 *  allowed; TileProvider only does that while its chunk record is uniquely locked, which its readers exclude by
+	 *  holding the record shared. */
 	template <typename T>
-	using Chunk = Lockable<std::vector<T>>;
+	class Chunk: public Lockable<std::vector<T>> {
+		public:
+			using Base = Lockable<std::vector<T>>;
+
+			/** Elements of types that can't be loaded atomically without a lock are always read under the shared lock. */
+			constexpr static bool OPTIMISTIC = std::is_trivially_copyable_v<T> && std::atomic_ref<T>::is_always_lock_free;
+			/** How many times an optimistic read is retried before waiting for the writer with the shared lock. */
+			constexpr static size_t MAX_OPTIMISTIC_ATTEMPTS = 16;
+
+			/** Holds the chunk's unique lock and marks a write as being in progress until it's released. */
+			class UniqueLock {
+				public:
+					UniqueLock() = default;
+
+					explicit UniqueLock(const Chunk &chunk_):
+						chunk(&chunk_),
+						lock(chunk_.mutex) {
+							chunk->beginWrite();
+						}
+
+					UniqueLock(const UniqueLock &) = delete;
+					UniqueLock(UniqueLock &&other) noexcept:
+						chunk(std::exchange(other.chunk, nullptr)),
+						lock(std::move(other.lock)) {}
+
+					~UniqueLock() {
+						unlock();
+					}
+
+					UniqueLock & operator=(const UniqueLock &) = delete;
+					UniqueLock & operator=(UniqueLock &&other) noexcept {
+						if (this != &other) {
+							unlock();
+							chunk = std::exchange(other.chunk, nullptr);
+							lock = std::move(other.lock);
+						}
+						return *this;
+					}
+
+					void unlock() {
+						if (chunk != nullptr) {
+							std::exchange(chunk, nullptr)->endWrite();
+							lock.unlock();
+						}
+					}
+
+					bool owns_lock() const {
+						return chunk != nullptr;
+					}
+
+					explicit operator bool() const {
+						return owns_lock();
+					}
+
+				private:
+					const Chunk *chunk = nullptr;
+					std::unique_lock<DefaultMutex> lock;
+			};
+
+			using Base::Base;
+
+			Chunk() = default;
+			Chunk(const Chunk &other): Base(other.copyBase()) {}
+			Chunk(Chunk &&other): Base(std::move(other.getBase())) {}
+
+			Chunk & operator=(const Chunk &other) {
+				if (this != &other) {
+					auto other_lock = other.sharedLock();
+					*this = other.getBase();
+				}
+				return *this;
+			}
+
+			Chunk & operator=(Chunk &&other) {
+				if (this != &other) {
+					auto other_lock = other.uniqueLock();
+					*this = std::move(other.getBase());
+				}
+				return *this;
+			}
+
+			/** Copies into the existing storage when it's large enough, so chunks that are overwritten wholesale with
+			 *  same-sized data (for example, by chunk packets) stay safe to read optimistically. */
+			Chunk & operator=(const std::vector<T> &values) {
+				auto lock = uniqueLock();
+				if (this->size() == values.size())
+					storeAll(values);
+				else
+					this->assign(values.begin(), values.end());
+				return *this;
+			}
+
+			Chunk & operator=(std::vector<T> &&values) {
+				auto lock = uniqueLock();
+				if (this->size() == values.size())
+					storeAll(values);
+				else
+					this->getBase() = std::move(values);
+				return *this;
+			}
+
+			inline UniqueLock uniqueLock() const { return UniqueLock(*this); }
+
+			/** Returns the number of writes that have completed, plus one if a write is in progress. */
+			inline uint64_t getVersion() const { return (sequence.load(std::memory_order_acquire) + 1) / 2; }
+
+			/** Reads a single element without taking the chunk's lock unless a writer is active. Returns nothing if the
+			 *  chunk hasn't been initialized. The caller must make sure the chunk's storage can't be replaced meanwhile. */
+			std::optional<T> tryLoad(size_t index) const {
+				if constexpr (OPTIMISTIC) {
+					for (size_t attempt = 0; attempt < MAX_OPTIMISTIC_ATTEMPTS; ++attempt) {
+						const uint64_t before = sequence.load(std::memory_order_acquire);
+						if (before % 2 == 1)
+							continue;
+
+						std::optional<T> out;
+						if (index < this->size())
+							out = std::atomic_ref<T>(const_cast<T &>(this->data()[index])).load(std::memory_order_relaxed);
+
+						std::atomic_thread_fence(std::memory_order_acquire);
+						if (sequence.load(std::memory_order_relaxed) == before)
+							return out;
+					}
+				}
+
+				auto lock = this->sharedLock();
+				if (index < this->size())
+					return (*this)[index];
+				return std::nullopt;
+			}
+
+			/** Like tryLoad, but the chunk must be initialized. */
+			T load(size_t index) const {
+				return *tryLoad(index);
+			}
+
+			/** Writes a single element. The caller must hold the chunk's unique lock. Optimistic readers load elements
+			 *  atomically, so a plain assignment would race with them. */
+			void store(size_t index, const T &value) {
+				if constexpr (OPTIMISTIC)
+					std::atomic_ref<T>((*this)[index]).store(value, std::memory_order_relaxed);
+				else
+					(*this)[index] = value;
+			}
+
+		private:
+			mutable std::atomic_uint64_t sequence{0};
+			/** The mutex is recursive, so nested unique locks only mark the outermost write. Only accessed while the
+			 *  mutex is uniquely locked. */
+			mutable uint32_t writeDepth = 0;
+
+			void beginWrite() const {
+				if (writeDepth++ == 0) {
+					sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_release);
+				}
+			}
+
+			void endWrite() const {
+				if (--writeDepth == 0)
+					sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+			}
+
+			void storeAll(const std::vector<T> &values) {
+				for (size_t index = 0; index < values.size(); ++index)
+					store(index, values[index]);
+			}
+	};
 
 	using TileChunk  = Chunk<TileID>;
 	using BiomeChunk = Chunk<BiomeType>;
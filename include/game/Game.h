@@ -43,6 +43,8 @@ namespace Game3 {
 
 			/** Seconds since the last tick */
 			float delta = 0.f;
+			/** If positive, every tick advances the game by exactly this many seconds instead of the measured time. */
+			float fixedDelta = 0.f;
 			std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
 			bool debugMode = true;
 			/** 12 because the game starts at noon */
@@ -183,6 +183,19 @@ namespace Game3 {
 			virtual void replace(const Inventory &) = 0;
 			virtual void replace(Inventory &&) = 0;
 
+			/** Starts recording the original contents of every slot that changes, so that the changes can be undone with
+			 *  rollback() or kept with commit(). Notifications are suppressed until the transaction ends. The inventory has to
+			 *  stay locked for the whole transaction. Transactions don't nest, and side effects like dropped items aren't undone. */
+			virtual void beginTransaction() = 0;
+
+			/** Keeps the changes made during the transaction and notifies the owner if anything changed. */
+			virtual void commit() = 0;
+
+			/** Restores every slot changed during the transaction. Doesn't notify the owner. */
+			virtual void rollback() = 0;
+
+			virtual bool inTransaction() const = 0;
+
 			static std::shared_ptr<Inventory> create(Side side, std::shared_ptr<Agent> owner, Slot slot_count, InventoryID index = 0, Slot active_slot = 0, std::map<Slot, ItemStack> storage = {});
 			static std::shared_ptr<Inventory> create(std::shared_ptr<Agent> owner, Slot slot_count, InventoryID index = 0, Slot active_slot = 0, std::map<Slot, ItemStack> storage = {});
 
@@ -218,6 +231,35 @@ namespace Game3 {
 				return Suppressor(*this);
 			}
 
+			/** Rolls back the transaction it began unless it's committed first. */
+			struct Transaction {
+				Inventory &parent;
+				bool active = true;
+
+				explicit Transaction(Inventory &parent_): parent(parent_) {
+					parent.beginTransaction();
+				}
+
+				Transaction(const Transaction &) = delete;
+				Transaction & operator=(const Transaction &) = delete;
+
+				~Transaction() {
+					if (active)
+						parent.rollback();
+				}
+
+				void commit() {
+					if (active) {
+						active = false;
+						parent.commit();
+					}
+				}
+			};
+
+			Transaction transaction() {
+				return Transaction(*this);
+			}
+
 		friend class InventoryWrapper;
 	};
 
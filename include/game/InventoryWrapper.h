@@ -63,6 +63,10 @@ namespace Game3 {
 			bool empty() const override;
 			void replace(const Inventory &) override;
 			void replace(Inventory &&) override;
+			void beginTransaction() override;
+			void commit() override;
+			void rollback() override;
+			bool inTransaction() const override;
 
 			using Inventory::add;
 
@@ -1,15 +1,24 @@
 #pragma once
 
+#include "algorithm/PathfindingPool.h"
 #include "data/GameDB.h"
 #include "entity/ServerPlayer.h"
 #include "game/Fluids.h"
 #include "game/Game.h"
+#include "game/SimulationOptions.h"
+#include "game/TickScheduler.h"
+#include "net/FramedPacket.h"
 #include "net/RemoteClient.h"
+#include "realm/TickBudget.h"
 #include "threading/Lockable.h"
 #include "threading/MTQueue.h"
 #include "threading/ThreadPool.h"
+#include "util/Profiler.h"
+
+#include <atomic>
 
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -26,6 +35,9 @@ namespace Game3 {
 	class ServerGame: public Game {
 		public:
 			constexpr static float GARBAGE_COLLECTION_TIME = 60.f;
+			constexpr static float CHUNK_EVICTION_TIME = 10.f;
+			/** How long a chunk has to go unseen before it's unloaded if the chunkEvictionSeconds rule isn't set. */
+			constexpr static ssize_t DEFAULT_CHUNK_EVICTION_SECONDS = 300;
 
 			Lockable<std::unordered_set<ServerPlayerPtr>> players;
 			Lockable<std::unordered_map<std::string, ServerPlayerPtr>> playerMap;
@@ -33,6 +45,8 @@ namespace Game3 {
 			std::weak_ptr<Server> weakServer;
 			GameDB database{*this};
 			float lastGarbageCollection = 0.f;
+			float lastChunkEviction = 0.f;
+			float lastProfileExport = 0.f;
 
 			ServerGame(const std::shared_ptr<Server> &, size_t pool_size);
 
@@ -41,11 +55,20 @@ namespace Game3 {
 			void addEntityFactories() override;
 			bool tick() final;
 			void garbageCollect();
+			/** Saves and unloads chunks that no player has needed for a while. Disabled if the chunkEvictionSeconds rule is 0. */
+			void evictChunks();
+			/** Logs how long each tick phase has taken on average since the last export. Runs every profileExportSeconds
+			 *  seconds if that rule is set. */
+			void exportProfile();
 			void broadcastTileUpdate(RealmID, Layer, const Position &, TileID);
 			void broadcastFluidUpdate(RealmID, const Position &, FluidTile);
 			Side getSide() const override { return Side::Server; }
 			void queuePacket(std::shared_ptr<RemoteClient>, std::shared_ptr<Packet>);
 			void runCommand(RemoteClient &, const std::string &, GlobalID);
+			/** If realms are currently being ticked in parallel, queues the function to run on the tick thread after every
+			 *  realm has finished ticking and returns true. Otherwise, returns false without doing anything. */
+			bool deferCrossRealm(std::function<void()>);
+			/** Never called while realms are being ticked in parallel; realm changes are deferred via deferCrossRealm. */
 			void entityChangingRealms(Entity &, const RealmPtr &new_realm, const Position &new_position);
 			void entityTeleported(Entity &, MovementContext);
 			void entityDestroyed(const Entity &);
@@ -61,27 +84,69 @@ namespace Game3 {
 			void setRule(const std::string &, ssize_t);
 			std::optional<ssize_t> getRule(const std::string &) const;
 
+			inline ThreadPool & getChunkPool() { return chunkPool; }
+			inline ThreadPool & getChunkLoadPool() { return chunkLoadPool; }
+			inline PathfindingPool & getPathfindingPool() { return pathfindingPool; }
+			inline TickScheduler & getTickScheduler() { return tickScheduler; }
+			inline const TickBudgets & getTickBudgets() const { return tickBudgets; }
+
 			inline auto getServer() const {
 				auto out = weakServer.lock();
 				assert(out);
 				return out;
 			}
 
+			/** Sends a packet to every player that can see the given place. The packet is encoded at most once. */
 			template <typename P>
 			void broadcast(const Place &place, const P &packet) {
+				FramedPacket framed;
 				auto lock = players.sharedLock();
-				for (const ServerPlayerPtr &player: players)
-					if (player->canSee(place.realm->id, place.position))
-						if (std::shared_ptr<RemoteClient> client = player->toServer()->weakClient.lock())
-							client->send(packet);
+				for (const ServerPlayerPtr &player: players) {
+					if (player->canSee(place.realm->id, place.position)) {
+						if (std::shared_ptr<RemoteClient> client = player->toServer()->weakClient.lock()) {
+							if (!framed && !(framed = framePacket(*this, packet)))
+								return;
+							client->send(framed);
+						}
+					}
+				}
 			}
 
 		private:
 			MTQueue<std::pair<std::weak_ptr<RemoteClient>, std::shared_ptr<Packet>>> packetQueue;
 			MTQueue<std::weak_ptr<ServerPlayer>> playerRemovalQueue;
+			/** Cross-realm operations (e.g., entities changing realms) queued while realms were ticking in parallel. */
+			MTQueue<std::function<void()>> crossRealmQueue;
+			std::atomic_bool tickingRealmsInParallel = false;
 			double timeSinceTimeUpdate = 0.;
 			ThreadPool pool;
+			/** Used by realms to tick their visible chunks in parallel when the parallelChunkTicks rule is set. */
+			ThreadPool chunkPool;
+			/** Used by realms to page chunks in from the database off the tick thread. GameDB serializes its queries, so
+			 *  more than one thread wouldn't help. */
+			ThreadPool chunkLoadPool{1};
+			PathfindingPool pathfindingPool;
+			Profiler::Snapshot lastProfile;
+			/** Drives the server's tick thread. The maxCatchUpTicks rule sets how far behind it may fall before dropping ticks. */
+			TickScheduler tickScheduler{std::chrono::milliseconds(SERVER_TICK_PERIOD)};
+			/** Refreshed from the tickBudget rules at the start of every tick. */
+			TickBudgets tickBudgets;
 
+			/** Ticks each realm on the thread pool and waits for all of them to finish before running deferred cross-realm operations.
+			 *  Enabled by the parallelRealmTicks rule. If a realm's tick throws, the first exception is rethrown on the tick thread
+			 *  once every realm is done.
+			 *
+			 *  While realms tick concurrently, they may share only this game state:
+			 *  - registries, interactionSets and itemsByAttribute, which aren't modified after the game is initialized;
+			 *  - allAgents, players, playerMap and gameRules, which are Lockable and must be locked;
+			 *  - packetQueue, playerRemovalQueue and crossRealmQueue, which are MTQueues;
+			 *  - the database, whose GameDB methods lock its handle (a recursive mutex) before using it;
+			 *  - time, which is atomic, and delta, currentTick and tickBudgets, which only the tick thread writes, between ticks.
+			 *  Anything else, such as cavesGenerated or the realm map itself, may only be touched from the tick thread outside of
+			 *  this function, and realm changes have to go through deferCrossRealm. */
+			void tickRealmsInParallel();
+			/** Everything tick does inside the Tick profile zone. Returns false if the game has stopped. */
+			bool tickProfiled();
 			void handlePacket(RemoteClient &, Packet &);
 			std::tuple<bool, std::string> commandHelper(RemoteClient &, const std::string &);
 	};
@@ -6,6 +6,8 @@
 #include <map>
 #include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace Game3 {
 	class StorageInventory: public Inventory {
@@ -21,7 +23,9 @@ namespace Game3 {
 			StorageInventory(StorageInventory &&);
 
 		public:
+			/** Throws if a transaction is in progress. */
 			StorageInventory & operator=(const StorageInventory &);
+			/** Throws if a transaction is in progress. */
 			StorageInventory & operator=(StorageInventory &&);
 
 			ItemStack * operator[](Slot) override;
@@ -90,6 +94,11 @@ namespace Game3 {
 			void replace(const Inventory &) override;
 			void replace(Inventory &&) override;
 
+			void beginTransaction() override;
+			void commit() override;
+			void rollback() override;
+			bool inTransaction() const override;
+
 			inline auto & getStorage() { return storage; }
 			inline const auto & getStorage() const { return storage; }
 			inline void setStorage(Lockable<Storage> &&new_storage) { storage = std::move(new_storage); }
@@ -100,5 +109,23 @@ namespace Game3 {
 
 			/** Removes every slot whose item count is zero from the storage map. */
 			void compact() override;
+
+			/** Must be called before a slot is changed or handed out for changing, so that a transaction can undo it. */
+			inline void record(Slot slot) {
+				if (transactionActive)
+					recordOriginal(slot);
+			}
+
+		private:
+			bool transactionActive = false;
+			bool suppressedBeforeTransaction = false;
+			/** The contents of every slot changed during the current transaction from before the change. Kept between
+			 *  transactions so that its capacity is reused. */
+			std::vector<std::pair<Slot, std::optional<ItemStack>>> journal;
+			/** Which slots already have an entry in the journal. */
+			std::vector<bool> recorded;
+
+			void recordOriginal(Slot);
+			void endTransaction();
 	};
 }
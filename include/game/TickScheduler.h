@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace Game3 {
+	/** Runs a tick function at a fixed period, sleeping until each tick's deadline instead of for a whole period after each
+	 *  tick. If ticks fall behind schedule, the missed ticks are run back to back until the scheduler has caught up, unless
+	 *  it's more than maxCatchUp ticks behind. In that case the missed ticks are dropped and the schedule starts over from the
+	 *  current time. A maxCatchUp of zero drops missed ticks right away. */
+	class TickScheduler {
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			constexpr static size_t DEFAULT_MAX_CATCH_UP = 10;
+			/** The width of each histogram bucket. */
+			constexpr static std::chrono::microseconds HISTOGRAM_BUCKET{100};
+			/** How many recent ticks MSPT and TPS are measured over. */
+			constexpr static size_t WINDOW_SIZE = 100;
+
+			struct Stats {
+				size_t ticks = 0;
+				/** Ticks that took longer than the period. */
+				size_t overruns = 0;
+				/** Ticks skipped because the scheduler was too far behind to catch up. */
+				size_t dropped = 0;
+				/** Average milliseconds per tick over the recent window. */
+				double mspt = 0.;
+				/** The longest tick in the recent window, in milliseconds. */
+				double maxMspt = 0.;
+				/** Ticks per second over the recent window. */
+				double tps = 0.;
+			};
+
+			TickScheduler(std::chrono::nanoseconds period_, size_t max_catch_up = DEFAULT_MAX_CATCH_UP);
+
+			/** Calls the tick function at every deadline until running is false. */
+			void run(const std::atomic_bool &running, const std::function<void()> &tick);
+
+			inline std::chrono::nanoseconds getPeriod() const { return period; }
+			inline size_t getMaxCatchUp() const { return maxCatchUp; }
+			inline void setMaxCatchUp(size_t max_catch_up) { maxCatchUp = max_catch_up; }
+
+			Stats getStats() const;
+			/** Maps n to the number of ticks that took less than n histogram buckets but at least n - 1. Can be passed to
+			 *  printHistogram. */
+			std::map<uint64_t, size_t> getHistogram() const;
+			void resetStats();
+
+		private:
+			const std::chrono::nanoseconds period;
+			std::atomic_size_t maxCatchUp;
+
+			mutable std::mutex statsMutex;
+			size_t ticks = 0;
+			size_t overruns = 0;
+			size_t dropped = 0;
+			std::map<uint64_t, size_t> histogram;
+			/** Ring buffers of the most recent ticks' start times and durations. */
+			std::vector<Clock::time_point> recentStarts;
+			std::vector<std::chrono::nanoseconds> recentDurations;
+			size_t recentIndex = 0;
+
+			void record(Clock::time_point start, std::chrono::nanoseconds duration, size_t dropped_ticks);
+	};
+}
@@ -1,8 +1,16 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
 #include <nlohmann/json_fwd.hpp>
@@ -22,16 +30,57 @@ namespace Game3 {
 	class Tileset;
 
 	struct ChunkMeta {
-		uint64_t updateCount = 0;
+		constexpr static uint64_t NEVER_SAVED = std::numeric_limits<uint64_t>::max();
+
+		/** Bumped once per logical update, after the chunk data has been written. Unlike the chunks' own write versions,
+		 *  which only exist to validate optimistic reads, this is what clients and the database compare against. */
+		std::atomic_uint64_t updateCount = 0;
+		/** The value of updateCount when the chunk was last loaded from or saved to the database. */
+		std::atomic_uint64_t savedCount = NEVER_SAVED;
+	};
+
+	/** All the data stored for a single chunk position. Data that hasn't been initialized yet
+	 *  (for example, a layer of a chunk that only exists in another layer) is an empty vector. */
+	struct ChunkRecord {
+		std::array<TileChunk, LAYER_COUNT> terrain;
+		BiomeChunk biomes;
+		PathChunk pathmap;
+		FluidChunk fluids;
+		ChunkMeta meta;
+
+		/** Held shared while reading or writing single elements of the chunks and uniquely while replacing their storage
+		 *  or writing through references that optimistic readers don't know about. Also guards position and resident. */
+		mutable std::shared_mutex mutex;
+		/** Records are reused for other positions after being evicted, so anything that found a record without holding
+		 *  the record map's lock has to check these after locking the record. */
+		ChunkPosition position;
+		bool resident = false;
+
+		/** Returns whether every kind of data has been initialized. */
+		bool isComplete() const;
+	};
+
+	/** A reference to some of a chunk's data along with a shared lock on its record, which keeps the chunk from being
+	 *  evicted or having its storage replaced while the handle is alive. Writes through a handle have to go through the
+	 *  chunk's own unique lock and mustn't resize it. */
+	template <typename C>
+	class ChunkHandle {
+		public:
+			ChunkHandle(std::shared_lock<std::shared_mutex> record_lock, C &chunk_):
+				recordLock(std::move(record_lock)),
+				chunk(&chunk_) {}
+
+			C & operator*() const { return *chunk; }
+			C * operator->() const { return chunk; }
+
+		private:
+			std::shared_lock<std::shared_mutex> recordLock;
+			C *chunk;
 	};
 
 	class TileProvider {
 		public:
-			using ChunkMap = std::unordered_map<ChunkPosition, TileChunk>;
-			using BiomeMap = std::unordered_map<ChunkPosition, BiomeChunk>;
-			using PathMap  = std::unordered_map<ChunkPosition, PathChunk>;
-			using FluidMap = std::unordered_map<ChunkPosition, FluidChunk>;
-			using MetaMap  = std::unordered_map<ChunkPosition, ChunkMeta>;
+			using RecordMap = std::unordered_map<ChunkPosition, ChunkRecord *>;
 
 			/** Behavior when accessing a tile in an out-of-bounds chunk.
 			 *  The Create mode will cause a nonexistent chunk to be created on access. */
@@ -40,31 +89,64 @@ namespace Game3 {
 			enum class PathMode  {Throw, Create};
 			enum class FluidMode {Throw, Create};
 
-			std::array<ChunkMap, LAYER_COUNT> chunkMaps;
-			BiomeMap biomeMap;
-			PathMap pathMap;
-			FluidMap fluidMap;
 			Identifier tilesetID;
 			MTQueue<ChunkPosition> generationQueue;
-
-			mutable std::array<std::shared_mutex, LAYER_COUNT> chunkMutexes;
-			mutable std::shared_mutex biomeMutex;
-			mutable std::shared_mutex pathMutex;
-			mutable std::shared_mutex fluidMutex;
-			mutable std::shared_mutex metaMutex;
-
-			TileProvider() = default;
+			/** Called without any locks held when a chunk that isn't in memory is about to be created or when a chunk that was
+			 *  evicted is read. If it returns a ChunkSet, that data is loaded instead of a blank chunk being created.
+			 *  Can be called on any thread that reads an evicted chunk. */
+			std::function<std::optional<ChunkSet>(ChunkPosition)> chunkLoader;
+			/** Called without any locks held after data from the chunk loader has been stored, on the same thread. */
+			std::function<void(ChunkPosition)> onChunkLoaded;
+
+			TileProvider();
 			TileProvider(Identifier tileset_id);
 
 			void clear();
 			bool contains(ChunkPosition) const;
 
+			/** Returns the positions of all chunks that have terrain. */
+			std::vector<ChunkPosition> getChunkPositions() const;
+
+			/** Loads a chunk with the chunk loader if it isn't in memory. Returns whether the chunk is in memory afterward. */
+			bool ensureLoaded(ChunkPosition);
+
+			/** Returns whether a chunk's terrain is in memory. Unlike ensureLoaded, this never runs the chunk loader. */
+			bool isLoaded(ChunkPosition) const;
+
+			/** Stores chunk data that was read from storage elsewhere (e.g., on a loader thread) unless the chunk was loaded or
+			 *  created in the meantime, then calls onChunkLoaded. Returns whether the data was stored. */
+			bool storeLoaded(ChunkPosition, ChunkSet);
+
+			/** Removes all of a chunk's data from memory. The chunk should be saved first if it's dirty. Reading any of the
+			 *  chunk's data afterward pages it back in with the chunk loader instead of treating the chunk as absent. */
+			void evict(ChunkPosition);
+
+			/** Returns whether a chunk has changed since it was last loaded or saved. */
+			bool isDirty(ChunkPosition) const;
+
+			/** Records that a chunk was saved as of the given update counter. */
+			void markSaved(ChunkPosition, uint64_t update_counter);
+
+			/** Calls a function with every chunk position and record while holding a unique lock on that record.
+			 *  The function must not call back into the TileProvider. */
+			template <typename F>
+			void visitRecords(F &&function) {
+				for (ChunkRecord *candidate: getRecords()) {
+					std::unique_lock<std::shared_mutex> lock(candidate->mutex);
+					if (candidate->resident)
+						function(candidate->position, *candidate);
+				}
+			}
+
 			uint64_t updateChunk(ChunkPosition);
 			/** If the chunk position isn't present in the meta map, this returns 0 without adding the chunk position to the meta map. */
 			uint64_t getUpdateCounter(ChunkPosition);
 			void setUpdateCounter(ChunkPosition, uint64_t);
+			/** Returns whether a client that requested a chunk with the given counter threshold (one more than the counter of
+			 *  its copy, or 0 to always send) already has the chunk's current contents. Evicted chunks never count as current. */
+			bool isUpToDate(ChunkPosition, uint64_t counter_threshold);
 
-			/** Copies the data from a ChunkSet object into this TileProvider object's terrain, biome and fluid data, then remakes the path map.
+			/** Copies the data from a ChunkSet object into this TileProvider object's terrain, biome, fluid and path data.
 			 *  Doesn't lock any of the ChunkSet object's mutexes. */
 			void absorb(ChunkPosition, ChunkSet);
 
@@ -74,7 +156,6 @@ namespace Game3 {
 
 			/** Returns a copy of the given tile. The Create mode will be treated as Throw. */
 			TileID copyTile(Layer, Position, bool &was_empty, TileMode = TileMode::Throw) const;
-			TileID copyTileUnsafe(Layer, Position, bool &was_empty, TileMode = TileMode::Throw) const;
 
 			/** Returns a copy of the given tile. The Create mode will be treated as Throw. */
 			TileID copyTile(Layer, Position, TileMode = TileMode::Throw) const;
@@ -87,6 +168,10 @@ namespace Game3 {
 			/** Returns a copy of the path state at a given tile position. */
 			std::optional<uint8_t> copyPathState(Position) const;
 
+			/** Copies a chunk's path states into rows of CHUNK_SIZE bytes that start stride bytes apart.
+			 *  Returns false without writing anything if the chunk or its pathmap isn't present. */
+			bool copyPathChunk(ChunkPosition, uint8_t *out, size_t stride) const;
+
 			/** Returns a copy of the fluid ID/amount at a given tile position. */
 			std::optional<FluidTile> copyFluidTile(Position) const;
 
@@ -107,10 +192,10 @@ namespace Game3 {
 			/** An empty vector indicates failure. */
 			std::string getRawFluids(ChunkPosition) const;
 
-			/** Returns a reference to the given tile and sets up a shared lock. The ReturnEmpty mode will be treated as Throw. */
+			/** Returns a reference to the given tile and sets up a shared lock on its chunk's record. The ReturnEmpty mode will be treated as Throw. */
 			TileID & findTile(Layer, Position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, TileMode = TileMode::Create);
 
-			/** Returns a reference to the given tile and sets up a unique lock. The ReturnEmpty mode will be treated as Throw. */
+			/** Returns a reference to the given tile and sets up a unique lock on its chunk's record. The ReturnEmpty mode will be treated as Throw. */
 			TileID & findTile(Layer, Position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, TileMode = TileMode::Create);
 
 			template <typename T>
@@ -133,10 +218,10 @@ namespace Game3 {
 				return findBiomeType(position, created, lock_out, mode);
 			}
 
-			/** Returns a reference to the path state at a given tile position and sets up a shared lock. */
+			/** Returns a reference to the path state at a given tile position and sets up a shared lock on its chunk's record. */
 			uint8_t & findPathState(Position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, PathMode = PathMode::Create);
 
-			/** Returns a reference to the path state at a given tile position and sets up a unique lock. */
+			/** Returns a reference to the path state at a given tile position and sets up a unique lock on its chunk's record. */
 			uint8_t & findPathState(Position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, PathMode = PathMode::Create);
 
 			/** Returns a reference to the path state at a given tile position. */
@@ -150,20 +235,21 @@ namespace Game3 {
 
 			FluidTile & findFluid(Position, std::unique_lock<std::shared_mutex> *lock_out, FluidMode mode = FluidMode::Create);
 
-			const TileChunk & getTileChunk(Layer, ChunkPosition) const;
-			TileChunk & getTileChunk(Layer, ChunkPosition);
+			/** The const getters throw std::out_of_range if the chunk doesn't exist. The others create it. */
+			ChunkHandle<const TileChunk> getTileChunk(Layer, ChunkPosition) const;
+			ChunkHandle<TileChunk> getTileChunk(Layer, ChunkPosition);
 
-			std::optional<std::reference_wrapper<const TileChunk>> tryTileChunk(Layer, ChunkPosition) const;
-			std::optional<std::reference_wrapper<TileChunk>> tryTileChunk(Layer, ChunkPosition);
+			std::optional<ChunkHandle<const TileChunk>> tryTileChunk(Layer, ChunkPosition) const;
+			std::optional<ChunkHandle<TileChunk>> tryTileChunk(Layer, ChunkPosition);
 
-			const Chunk<BiomeType> & getBiomeChunk(ChunkPosition) const;
-			Chunk<BiomeType> & getBiomeChunk(ChunkPosition);
+			ChunkHandle<const BiomeChunk> getBiomeChunk(ChunkPosition) const;
+			ChunkHandle<BiomeChunk> getBiomeChunk(ChunkPosition);
 
-			const Chunk<uint8_t> & getPathChunk(ChunkPosition) const;
-			Chunk<uint8_t> & getPathChunk(ChunkPosition);
+			ChunkHandle<const PathChunk> getPathChunk(ChunkPosition) const;
+			ChunkHandle<PathChunk> getPathChunk(ChunkPosition);
 
-			const Chunk<FluidTile> & getFluidChunk(ChunkPosition) const;
-			Chunk<FluidTile> & getFluidChunk(ChunkPosition);
+			ChunkHandle<const FluidChunk> getFluidChunk(ChunkPosition) const;
+			ChunkHandle<FluidChunk> getFluidChunk(ChunkPosition);
 
 			/** Creates missing tile chunks at a given chunk position in every layer. */
 			void ensureTileChunk(ChunkPosition);
@@ -187,12 +273,21 @@ namespace Game3 {
 			void toJSON(nlohmann::json &, bool full_data = false) const;
 			void absorbJSON(const nlohmann::json &, bool full_data = false);
 
+			/** Returns nothing if the chunk hasn't been initialized. Reads optimistically instead of locking the chunk,
+			 *  so the chunk's record has to be locked (at least shared) to keep the chunk's storage from being replaced. */
+			template <typename T>
+			static std::optional<T> tryAccess(const Chunk<T> &chunk, int64_t row, int64_t column) {
+				assert(0 <= row);
+				assert(0 <= column);
+				return chunk.tryLoad(row * CHUNK_SIZE + column);
+			}
+
+			/** Like tryAccess, but the chunk must be initialized. */
 			template <typename T>
 			static T access(const Chunk<T> &chunk, int64_t row, int64_t column) {
 				assert(0 <= row);
 				assert(0 <= column);
-				auto lock = chunk.sharedLock();
-				return chunk[row * CHUNK_SIZE + column];
+				return chunk.load(row * CHUNK_SIZE + column);
 			}
 
 			/** You need to lock the chunk yourself when using this method. */
@@ -221,7 +316,59 @@ namespace Game3 {
 
 		private:
 			std::shared_ptr<Tileset> cachedTileset;
-			MetaMap metaMap;
+			/** Maps chunk positions to the records resident there. */
+			RecordMap records;
+			/** Every record this provider has allocated. Records are only freed along with the provider, so a record
+			 *  pointer that's gone stale because of an eviction can still be locked and checked. Guarded by recordMutex. */
+			std::vector<std::unique_ptr<ChunkRecord>> allRecords;
+			/** Evicted records waiting to be reused. Guarded by recordMutex. */
+			std::vector<ChunkRecord *> freeRecords;
+			/** Positions of chunks that were evicted and haven't been loaded again since, along with their update counters at
+			 *  the time. A new record at one of these positions starts from that counter. Guarded by recordMutex. */
+			std::unordered_map<ChunkPosition, uint64_t> evictedChunks;
+			/** Guards the record map and the record pool, but not the records themselves. A record's lock may be taken
+			 *  before this one but never while holding it: records are looked up with the map locked and locked after. */
+			mutable std::shared_mutex recordMutex;
+			/** Distinguishes this provider from others in the per-thread record cache. */
+			const uint64_t serial;
+
+			/** Returns the record that was most recently resident at a position without locking it. The result has to be
+			 *  locked and checked before being used. Uses the calling thread's record cache if possible. */
+			ChunkRecord * findRecord(ChunkPosition) const;
+
+			/** Looks up and locks a resident record, retrying if it's evicted in the meantime. Returns null with the lock
+			 *  released if there's no record at the position. */
+			template <typename L>
+			ChunkRecord * lockRecord(ChunkPosition, L &lock) const;
+
+			/** Like lockRecord with a shared lock, but pages the chunk back in first if it was evicted. */
+			const ChunkRecord * lockForReading(ChunkPosition, std::shared_lock<std::shared_mutex> &lock) const;
+
+			/** Like lockRecord with a unique lock, but creates an empty record if there isn't one. */
+			ChunkRecord & lockOrCreateRecord(ChunkPosition, std::unique_lock<std::shared_mutex> &lock);
+
+			/** Removes a uniquely locked record from the map, frees its data and makes it available for reuse.
+			 *  If evicted is true, later reads of the position will page the chunk back in. */
+			void releaseRecord(ChunkRecord &, bool evicted);
+
+			/** Like lockRecord with a shared lock, but throws std::out_of_range if there's no record. */
+			const ChunkRecord & requireRecord(ChunkPosition, std::shared_lock<std::shared_mutex> &lock) const;
+
+			/** Returns every resident record as of the call, without locking any of them. */
+			std::vector<ChunkRecord *> getRecords() const;
+
+			/** Returns a pointer to some data of a chunk, creating it with init if it doesn't exist and create is true.
+			 *  Returns null if the data doesn't exist and create is false. Sets up a lock on the chunk's record. */
+			template <typename C, typename L, typename S, typename I>
+			C * findChunk(ChunkPosition, L *lock_out, bool create, bool &created, S &&select, I &&init);
+
+			/** Runs the chunk loader if the chunk has no terrain in memory. Returns whether the chunk has terrain afterward.
+			 *  Must be called without holding any record locks. */
+			bool loadIfMissing(ChunkPosition);
+
+			/** Loads a chunk again if it was evicted. Returns whether the chunk has terrain afterward. Reading paged-out data
+			 *  doesn't change the provider's contents, so this is const. Must be called without holding any record locks. */
+			bool pageIn(ChunkPosition) const;
 
 			void validateLayer(Layer) const;
 			void initTileChunk(Layer, TileChunk &, ChunkPosition);
@@ -10,6 +10,7 @@
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include <nlohmann/json_fwd.hpp>
 
@@ -38,6 +39,9 @@ namespace Game3 {
 
 	class Tileset: public NamedRegisterable {
 		public:
+			/** A dense index for a category, for checking membership by tile ID without hashing the category's name. */
+			using CategoryIndex = uint16_t;
+
 			bool isLand(const Identifier &) const;
 			bool isLand(TileID) const;
 			bool isWalkable(const Identifier &) const;
@@ -48,20 +52,23 @@ namespace Game3 {
 			TileID getEmptyID() const;
 			const Identifier & getMissing() const;
 			const std::unordered_set<Identifier> & getBrightNames() const;
-			std::vector<TileID> getBrightIDs();
+			const std::vector<TileID> & getBrightIDs() const;
+			bool isBright(TileID) const;
 			std::string getName() const;
 			std::shared_ptr<Texture> getTexture(const Game &);
 			const Identifier & getTextureName() const { return textureName; }
 			bool getItemStack(const Game &, const Identifier &, ItemStack &) const;
-			bool isMarchable(TileID);
+			bool isMarchable(TileID) const;
 			bool isCategoryMarchable(const Identifier &category) const;
 			const MarchableInfo * getMarchableInfo(const Identifier &tilename) const;
-			void clearCache();
 			const std::unordered_set<Identifier> & getCategories(const Identifier &) const;
-			const std::unordered_set<TileID> getCategoryIDs(const Identifier &) const;
+			/** Returns the IDs of the tiles in a category. Throws std::out_of_range if the category doesn't exist. */
+			const std::unordered_set<TileID> & getCategoryIDs(const Identifier &) const;
 			const std::unordered_set<Identifier> & getTilesByCategory(const Identifier &) const;
+			std::optional<CategoryIndex> getCategoryIndex(const Identifier &category) const;
 			bool isInCategory(const Identifier &tilename, const Identifier &category) const;
 			bool isInCategory(TileID, const Identifier &category) const;
+			bool isInCategory(TileID, CategoryIndex) const;
 			bool hasName(const Identifier &) const;
 			bool hasCategory(const Identifier &) const;
 			inline auto getTileSize() const { return tileSize; }
@@ -102,7 +109,6 @@ namespace Game3 {
 			mutable std::optional<TileID> emptyID;
 
 			std::shared_ptr<Texture> cachedTexture;
-			// TODO: consider making the sets store TileIDs instead, for performance perhaps
 			std::unordered_set<Identifier> land;
 			std::unordered_set<Identifier> walkable;
 			std::unordered_set<Identifier> solid;
@@ -119,9 +125,6 @@ namespace Game3 {
 			std::unordered_map<Identifier, std::unordered_set<Identifier>> categories;
 			/** Maps tile names to sets of category names. */
 			std::unordered_map<Identifier, std::unordered_set<Identifier>> inverseCategories;
-			std::unordered_set<TileID> marchableCache;
-			std::unordered_set<TileID> unmarchableCache;
-			std::optional<std::vector<TileID>> brightCache;
 			/** Maps autotile identifiers to autotile set pointers. */
 			std::unordered_map<Identifier, std::shared_ptr<AutotileSet>> autotileSets;
 			/** Maps tilenames to autotile set pointers. */
@@ -129,7 +132,30 @@ namespace Game3 {
 			/** Maps base tile IDs for the lower portions of tall tiles to the tile IDs for the upper portions. */
 			std::unordered_map<TileID, TileID> uppers;
 
+			/** Bits in tileFlags. */
+			enum TileFlag: uint8_t {
+				KNOWN_TILE     = 1 << 0,
+				LAND_TILE      = 1 << 1,
+				WALKABLE_TILE  = 1 << 2,
+				SOLID_TILE     = 1 << 3,
+				BRIGHT_TILE    = 1 << 4,
+				MARCHABLE_TILE = 1 << 5,
+			};
+
+			/** The tables below are indexed by TileID (or CategoryIndex) and built by buildTables once the tileset is
+			 *  complete, so that per-tile queries don't have to hash tilenames. */
+			std::vector<uint8_t> tileFlags;
+			/** Each tile's categories as a bitset, tileCategoryWords words per tile. */
+			std::vector<uint64_t> tileCategories;
+			size_t tileCategoryWords = 0;
+			std::unordered_map<Identifier, CategoryIndex> categoryIndices;
+			std::vector<std::unordered_set<TileID>> categoryTileIDs;
+			std::vector<TileID> brightIDs;
+
 			void setAutotile(const Identifier &tilename, const Identifier &autotile_name);
+			void buildTables();
+			/** Throws std::out_of_range if the tile ID isn't in the tileset. */
+			uint8_t getFlags(TileID) const;
 
 		friend Tileset tileStitcher(const std::filesystem::path &, Identifier, std::string *);
 	};
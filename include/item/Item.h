@@ -2,6 +2,7 @@
 
 #include "types/Types.h"
 #include "data/Identifier.h"
+#include "item/ItemData.h"
 #include "registry/Registerable.h"
 #include "ui/Modifiers.h"
 
@@ -76,14 +77,14 @@ namespace Game3 {
 		public:
 			std::shared_ptr<Item> item;
 			ItemCount count = 1;
-			nlohmann::json data;
+			ItemData data;
 
 			ItemStack() = default;
 			ItemStack(const Game &);
 			ItemStack(const Game &, std::shared_ptr<Item> item_, ItemCount count_ = 1);
-			ItemStack(const Game &, std::shared_ptr<Item> item_, ItemCount count_, nlohmann::json data_);
+			ItemStack(const Game &, std::shared_ptr<Item> item_, ItemCount count_, ItemData data_);
 			ItemStack(const Game &, const ItemID &, ItemCount = 1);
-			ItemStack(const Game &, const ItemID &, ItemCount, nlohmann::json data_);
+			ItemStack(const Game &, const ItemID &, ItemCount, ItemData data_);
 
 			bool canMerge(const ItemStack &) const;
 			Glib::RefPtr<Gdk::Pixbuf> getImage() const;
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace Game3 {
+	class Buffer;
+
+	/** An ItemStack's metadata: a small map from keys to typed values, kept sorted by key. Its hash is updated on every
+	 *  change, so comparing the data of two stacks that don't match usually costs one integer comparison. Values that
+	 *  aren't a scalar, a string or a pair of integers (like durability) are kept as JSON. Otherwise, JSON is only used to
+	 *  read and write item data. */
+	class ItemData {
+		public:
+			using IntegerPair = std::pair<int64_t, int64_t>;
+			using Value = std::variant<bool, int64_t, double, std::string, IntegerPair, nlohmann::json>;
+			using Entry = std::pair<std::string, Value>;
+
+			ItemData() = default;
+			ItemData(std::initializer_list<Entry>);
+			/** Null converts to empty data. Throws if the JSON is anything else that isn't an object. */
+			ItemData(const nlohmann::json &);
+
+			inline bool empty() const { return entries.empty(); }
+			inline size_t size() const { return entries.size(); }
+			inline size_t getHash() const { return hash; }
+
+			inline bool contains(std::string_view key) const {
+				return find(key) != nullptr;
+			}
+
+			/** Returns nullptr if there's no value for the key. */
+			const Value * find(std::string_view key) const;
+
+			/** Returns nullptr if there's no value for the key or if it has a different type. */
+			template <typename T>
+			const T * get(std::string_view key) const {
+				if (const Value *value = find(key))
+					return std::get_if<T>(value);
+				return nullptr;
+			}
+
+			/** Throws std::out_of_range if there's no value for the key or std::bad_variant_access if it has a different type. */
+			template <typename T>
+			const T & at(std::string_view key) const {
+				if (const Value *value = find(key))
+					return std::get<T>(*value);
+				throw std::out_of_range("No item data for key \"" + std::string(key) + '"');
+			}
+
+			void set(std::string key, Value value);
+			/** Returns whether a value was removed. */
+			bool erase(std::string_view key);
+			void clear();
+
+			/** Returns null if the data is empty. */
+			nlohmann::json toJSON() const;
+
+			bool operator==(const ItemData &) const;
+			/** Orders by hash first. The order is consistent but otherwise meaningless. */
+			bool operator<(const ItemData &) const;
+
+		private:
+			std::vector<Entry> entries;
+			size_t hash = 0;
+
+			void rehash();
+	};
+
+	void to_json(nlohmann::json &, const ItemData &);
+	void from_json(const nlohmann::json &, ItemData &);
+
+	template <typename T>
+	T popBuffer(Buffer &);
+	template <>
+	ItemData popBuffer<ItemData>(Buffer &);
+	/** Item data is sent as JSON text. */
+	Buffer & operator+=(Buffer &, const ItemData &);
+	Buffer & operator<<(Buffer &, const ItemData &);
+	Buffer & operator>>(Buffer &, ItemData &);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "types/Types.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Game3 {
+	/** Splits a byte stream into packet frames: a little-endian 2-byte packet ID and 4-byte payload size followed by the payload.
+	 *  Frames that arrive whole are handed out as views into the input; only frames split across reads are assembled in an internal
+	 *  buffer, whose storage is reused so that decoding doesn't allocate once it's warmed up. */
+	class FrameDecoder {
+		public:
+			constexpr static size_t HEADER_SIZE = 6;
+
+			explicit FrameDecoder(size_t max_payload_size);
+
+			/** Calls the handler with the packet ID and payload of every frame completed by the input. The payload view is only valid during
+			 *  the call. Stops early if the handler returns false. Returns false if a frame declared a payload larger than the maximum, after
+			 *  which the decoder shouldn't be fed again. */
+			template <typename F>
+			bool feed(std::span<const uint8_t> input, F &&handler) {
+				for (;;) {
+					if (state == State::Header) {
+						if (input.empty())
+							return true;
+
+						if (!readHeader(input))
+							return true;
+
+						if (maxPayloadSize < payloadSize)
+							return false;
+					}
+
+					if (pending.empty() && payloadSize <= input.size()) {
+						const std::span<const uint8_t> payload = input.first(payloadSize);
+						input = input.subspan(payloadSize);
+						state = State::Header;
+						if (!handler(packetID, payload))
+							return true;
+						continue;
+					}
+
+					if (input.empty())
+						return true;
+
+					const size_t to_take = std::min<size_t>(payloadSize - pending.size(), input.size());
+					pending.insert(pending.end(), input.begin(), input.begin() + to_take);
+					input = input.subspan(to_take);
+
+					if (pending.size() == payloadSize) {
+						state = State::Header;
+						const bool keep_going = handler(packetID, std::span<const uint8_t>(pending));
+						pending.clear();
+						if (!keep_going)
+							return true;
+					}
+				}
+			}
+
+			/** Discards any partially received frame. */
+			void reset();
+
+			inline PacketID getPacketID() const { return packetID; }
+			inline uint32_t getPayloadSize() const { return payloadSize; }
+			/** Returns the number of bytes of the current frame (header included) that have been received so far. */
+			inline size_t getBufferedSize() const { return state == State::Header? headerFill : HEADER_SIZE + pending.size(); }
+
+		private:
+			enum class State {Header, Payload};
+
+			State state = State::Header;
+			size_t maxPayloadSize;
+			std::array<uint8_t, HEADER_SIZE> header{};
+			size_t headerFill = 0;
+			PacketID packetID = 0;
+			uint32_t payloadSize = 0;
+			std::vector<uint8_t> pending;
+
+			/** Consumes header bytes from the input. Returns true once the header is complete, at which point the decoder expects a payload. */
+			bool readHeader(std::span<const uint8_t> &input);
+			void parseHeader(const uint8_t *bytes);
+	};
+}
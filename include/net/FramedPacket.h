@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Game3 {
+	class Game;
+	class Packet;
+
+	/** A packet's header and encoded payload, ready to be written to a socket. Immutable so that a single encoding can be shared
+	 *  between every client a packet is broadcast to. */
+	using FramedPacket = std::shared_ptr<const std::vector<uint8_t>>;
+
+	/** The size of the packet ID and payload size that precede every payload. */
+	constexpr size_t PACKET_HEADER_SIZE = 6;
+
+	/** Encodes a packet directly after space reserved for its header, then fills the header in, so the payload is never copied.
+	 *  Returns null if the packet is invalid. */
+	FramedPacket framePacket(Game &, const Packet &);
+}
@@ -1,12 +1,15 @@
 #pragma once
 
+#include "net/FramedPacket.h"
 #include "net/SendBuffer.h"
 #include "threading/Lockable.h"
 
 #include <condition_variable>
 #include <cstddef>
+#include <deque>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <asio.hpp>
 #include <asio/ssl.hpp>
@@ -24,7 +27,11 @@ namespace Game3 {
 			std::mutex networkMutex;
 			asio::ssl::stream<asio::ip::tcp::socket> socket;
 			asio::io_context::strand strand;
-			Lockable<std::deque<std::string>, std::shared_mutex> outbox;
+			/** Messages waiting to be written. Shared so that broadcast packets aren't copied per client. */
+			Lockable<std::deque<FramedPacket>, std::shared_mutex> outbox;
+
+			/** The maximum number of queued messages handed to a single vectored write. */
+			constexpr static size_t MAX_WRITE_BATCH = 64;
 
 			GenericClient() = delete;
 			GenericClient(const GenericClient &) = delete;
@@ -38,6 +45,8 @@ namespace Game3 {
 
 			void start();
 			void queue(std::string);
+			void queue(FramedPacket);
+			void queue(std::vector<FramedPacket>);
 
 			virtual void handleInput(std::string_view) = 0;
 			virtual void onMaxLineSizeExceeded() {}
@@ -53,7 +62,7 @@ namespace Game3 {
 			bool closed = false;
 
 			void write();
-			void writeHandler(const asio::error_code &, size_t);
+			void writeHandler(const asio::error_code &, size_t, size_t count);
 			void doHandshake();
 			void doRead();
 	};
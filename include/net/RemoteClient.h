@@ -1,8 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <span>
 
 #include "net/Buffer.h"
+#include "net/FrameDecoder.h"
+#include "net/FramedPacket.h"
 #include "net/GenericClient.h"
 #include "packet/Packet.h"
 
@@ -39,6 +42,8 @@ namespace Game3 {
 
 			void handleInput(std::string_view) override;
 			bool send(const Packet &);
+			/** Sends a packet that has already been framed, e.g. one being broadcast to many clients. */
+			bool send(const FramedPacket &);
 			void sendChunk(Realm &, ChunkPosition, bool can_request = true, uint64_t counter_threshold = 0);
 			inline auto getPlayer() const { return weakPlayer.lock(); }
 			inline void setPlayer(const std::shared_ptr<ServerPlayer> &shared) { weakPlayer = shared; }
@@ -56,14 +61,15 @@ namespace Game3 {
 			void removeSelf() override;
 
 		private:
-			enum class State {Begin, Data};
-			State state = State::Begin;
-			std::vector<uint8_t> headerBytes;
-			uint16_t packetType = 0;
-			uint32_t payloadSize = 0;
+			/** Clients have no reason to send anything larger. */
+			constexpr static size_t MAX_PAYLOAD_SIZE = 32768;
+
+			FrameDecoder decoder{MAX_PAYLOAD_SIZE};
 			std::weak_ptr<ServerPlayer> weakPlayer;
 			Buffer receiveBuffer;
 
+			/** Decodes a received packet and queues it for the tick thread. Returns false if the packet was malformed and the client was dropped. */
+			bool handlePacket(PacketID, std::span<const uint8_t> payload);
 			void mock();
 	};
 }
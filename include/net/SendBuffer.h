@@ -1,5 +1,7 @@
 #pragma once
 
+#include "net/FramedPacket.h"
+
 #include <atomic>
 #include <cassert>
 #include <mutex>
@@ -10,7 +12,8 @@ namespace Game3 {
 	struct SendBuffer {
 		std::shared_mutex mutex;
 		std::atomic_size_t depth = 0;
-		std::string bytes;
+		/** Messages held back while buffering. They're handed to the client's outbox together when the buffer is flushed. */
+		std::vector<FramedPacket> messages;
 		SendBuffer() = default;
 
 		inline auto sharedLock() { return std::shared_lock(mutex); }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types/Types.h"
+#include "net/FramedPacket.h"
 #include "threading/Lockable.h"
 
 #include <atomic>
@@ -72,6 +73,10 @@ namespace Game3 {
 			void handleMessage(RemoteClient &, std::string_view);
 			void mainLoop();
 			void send(RemoteClient &, std::string, bool force = false);
+			/** Sends a shared message without copying it. If the client is buffering and force is false, the message is held until the buffer is flushed. */
+			void send(RemoteClient &, FramedPacket, bool force = false);
+			/** Queues multiple messages at once, bypassing the client's send buffer. */
+			void send(RemoteClient &, std::vector<FramedPacket>);
 			void run();
 			void stop();
 			bool close(RemoteClient &);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "data/Identifier.h"
+#include "item/ItemData.h"
 #include "threading/Lockable.h"
 
 #include <map>
@@ -22,11 +23,11 @@ namespace Game3 {
 			enum class Comparator: uint8_t {None = 0, Less, Greater};
 
 			struct Config {
-				nlohmann::json data;
+				ItemData data;
 				Comparator comparator{};
 				ItemCount count{};
 
-				Config(nlohmann::json data_ = {}, Comparator comparator_ = {}, ItemCount count_ = {}):
+				Config(ItemData data_ = {}, Comparator comparator_ = {}, ItemCount count_ = {}):
 					data(std::move(data_)), comparator(comparator_), count(count_) {}
 
 				bool operator()(const ItemStack &, const Inventory &, bool strict) const;
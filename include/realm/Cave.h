@@ -23,6 +23,7 @@ namespace Game3 {
 			void onRemove() override;
 			void reveal(const Position &, bool force = false);
 			void generateChunk(const ChunkPosition &) override;
+			bool canGenerateInBackground() const override { return true; }
 			bool canSpawnMonsters() const override { return true; }
 
 			friend class Realm;
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "data/ChunkSet.h"
+#include "types/ChunkPosition.h"
+
+#include <optional>
+#include <unordered_set>
+
+namespace Game3 {
+	class Realm;
+
+	/** Pages a realm's stored chunks in from the database off the tick thread. Each chunk is read and decompressed on
+	 *  ServerGame's chunk load pool and stored through the realm's queue, so the tick thread never waits on SQLite. */
+	class ChunkPrefetcher {
+		public:
+			/** The maximum number of chunks that can be loading at once for a single realm. */
+			constexpr static size_t MAX_IN_FLIGHT = 16;
+
+			ChunkPrefetcher(Realm &);
+
+			/** Starts loading a chunk unless it's already loading, too many chunks are loading or it was found to be missing
+			 *  from the database. Requests that are turned away should be repeated later. Should be called on the tick thread. */
+			void request(ChunkPosition);
+			/** Returns whether a chunk is being loaded. Should be called on the tick thread. */
+			bool isPending(ChunkPosition) const;
+			/** Returns whether a chunk was requested before and turned out not to be in the database. Should be called on the tick thread. */
+			bool isUnavailable(ChunkPosition) const;
+			/** Forgets that a chunk couldn't be loaded, e.g. because it has since been saved. Should be called on the tick thread. */
+			void reset(ChunkPosition);
+
+		private:
+			Realm &realm;
+			/** Only accessed from the tick thread. */
+			std::unordered_set<ChunkPosition> inFlight;
+			/** Chunks that couldn't be loaded. They aren't requested again so that the database isn't queried every tick.
+			 *  Only accessed from the tick thread. */
+			std::unordered_set<ChunkPosition> unavailable;
+
+			void finish(ChunkPosition, std::optional<ChunkSet>);
+	};
+}
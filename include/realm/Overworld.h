@@ -13,6 +13,7 @@ namespace Game3 {
 			using Realm::Realm;
 
 			void generateChunk(const ChunkPosition &) override;
+			bool canGenerateInBackground() const override { return true; }
 
 		protected:
 			void absorbJSON(const nlohmann::json &, bool full_data) override;
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "types/Types.h"
+#include "algorithm/FlowField.h"
+#include "algorithm/PathGraph.h"
 #include "entity/EntityZCompare.h"
 #include "error/MultipleFoundError.h"
 #include "error/NoneFoundError.h"
@@ -13,6 +15,8 @@
 #include "packet/RealmNoticePacket.h"
 #include "packet/TileEntityPacket.h"
 #include "pipes/PipeLoader.h"
+#include "realm/ChunkPrefetcher.h"
+#include "realm/TickBudget.h"
 #include "threading/Lockable.h"
 #include "threading/MTQueue.h"
 #include "threading/SharedRecursiveMutex.h"
@@ -20,10 +24,13 @@
 #include "types/TileUpdateContext.h"
 #include "ui/Modifiers.h"
 #include "util/RWLock.h"
+#include "worldgen/GenerationPipeline.h"
+#include "container/SpatialHash.h"
 #include "container/WeakSet.h"
 
 #include <nlohmann/json_fwd.hpp>
 
+#include <chrono>
 #include <climits>
 #include <memory>
 #include <mutex>
@@ -33,6 +40,7 @@
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace Game3 {
 	constexpr int64_t REALM_DIAMETER = 3;
@@ -70,9 +78,16 @@ namespace Game3 {
 			};
 
 		public:
+			/** How many chunks away from the chunk being ticked a chunk tick may read or write while chunks tick in parallel.
+			 *  Entity search radii, flow fields, worker ranges and neighbor updates all stay within CHUNK_SIZE tiles of the
+			 *  entity or tile entity, so one chunk covers them. Anything that reaches further has to go through queue(). */
+			constexpr static ChunkPosition::IntType PARALLEL_TICK_REACH = 1;
+
 			RealmID id = -1;
 			RealmType type;
 			TileProvider tileProvider;
+			/** Chunk-level pathfinding graph for long routes. Kept up to date by remakePathMap. */
+			PathGraph pathGraph{tileProvider};
 			PipeLoader pipeLoader;
 			std::optional<std::array<std::array<ElementBufferedRenderer, REALM_DIAMETER>, REALM_DIAMETER>> baseRenderers;
 			std::optional<std::array<std::array<UpperRenderer, REALM_DIAMETER>, REALM_DIAMETER>> upperRenderers;
@@ -81,10 +96,15 @@ namespace Game3 {
 			Lockable<std::unordered_set<EntityPtr>, SharedRecursiveMutex> entities;
 			Lockable<std::unordered_map<GlobalID, EntityPtr>> entitiesByGID;
 			Lockable<WeakSet<Player>> players;
+			/** The positions of attached entities, for range queries. Kept in sync by attach, detach and onMoved. */
+			Lockable<SpatialHash> entityIndex;
 			nlohmann::json extraData;
 			Position randomLand;
 			/** Whether the realm's rendering should be affected by the day-night cycle. */
 			bool outdoors = true;
+			/** Whether this is a scratch realm that a chunk is being generated into in the background. Tile entities added to
+			 *  a scratch realm aren't spawned until absorbGenerated moves them into the live realm. */
+			bool scratch = false;
 			int64_t seed = 0;
 			std::unordered_set<ChunkPosition> generatedChunks;
 			Lockable<std::unordered_set<ChunkPosition>> visibleChunks;
@@ -96,6 +116,9 @@ namespace Game3 {
 
 			std::atomic_bool staticLightingQueued = false;
 
+			/** How much work each budgeted tick phase has done and how often it ran out of time. */
+			std::array<TickPhaseStats, TICK_PHASE_COUNT> tickPhaseStats;
+
 			Realm(const Realm &) = delete;
 			Realm(Realm &&) = delete;
 
@@ -131,6 +154,8 @@ namespace Game3 {
 			std::vector<EntityPtr> findEntitiesSquare(const Position &, uint64_t radius) const;
 			std::vector<EntityPtr> findEntitiesSquare(const Position &, uint64_t radius, const std::function<bool(const EntityPtr &)> &filter) const;
 			bool hasEntitiesSquare(const Position &, uint64_t radius, const std::function<bool(const EntityPtr &)> &predicate) const;
+			/** Calls the visitor on each entity within the square until it returns true. Returns whether it did. */
+			bool visitEntitiesSquare(const Position &, uint64_t radius, const std::function<bool(const EntityPtr &)> &visitor) const;
 			std::vector<EntityPtr> findEntities(const Position &, const EntityPtr &except);
 			EntityPtr findEntity(const Position &);
 			EntityPtr findEntity(const Position &, const EntityPtr &except);
@@ -180,6 +205,9 @@ namespace Game3 {
 			bool hasTileEntity(GlobalID);
 			bool hasEntity(GlobalID);
 			EntityPtr getEntity(GlobalID);
+			/** Returns the flow field shared by everything heading for the entity with the given GID, creating it if necessary.
+			 *  The field lives as long as someone holds on to it. */
+			std::shared_ptr<FlowField> getFlowField(GlobalID);
 			TileEntityPtr getTileEntity(GlobalID);
 			Side getSide() const;
 			/** Client-side. */
@@ -202,6 +230,9 @@ namespace Game3 {
 			void sendToMany(const std::unordered_set<std::shared_ptr<RemoteClient>> &, ChunkPosition);
 			void sendToOne(RemoteClient &, ChunkPosition);
 			void recalculateVisibleChunks();
+			/** Unloads chunks that haven't been visible to any player for at least the given duration, skipping those with unsaved changes.
+			 *  Server only; should be called on the tick thread. Returns the number of chunks unloaded. */
+			size_t evictInactiveChunks(std::chrono::seconds timeout);
 			void queueReupload();
 			void autotile(const Position &, Layer, TileUpdateContext = {});
 			/** Should be called in the UI thread. */
@@ -221,6 +252,9 @@ namespace Game3 {
 			virtual bool rightClick(const Position &, double x, double y);
 			/** Generates additional chunks for the infinite map after the initial worldgen of the realm. */
 			virtual void generateChunk(const ChunkPosition &) {}
+			/** Whether generateChunk can be run on a scratch copy of the realm off the tick thread.
+			 *  If false, requested chunks are generated synchronously during the tick. */
+			virtual bool canGenerateInBackground() const { return false; }
 			virtual bool canSpawnMonsters() const;
 
 			/** Full data doesn't include terrain, entities or tile entities. */
@@ -315,6 +349,13 @@ namespace Game3 {
 			std::atomic_int generationDepth = 0;
 			bool isGenerating() const { return generationDepth > 0; }
 
+		public:
+			/** Whether tickChunksInParallel is running. While it is, effects that reach further than PARALLEL_TICK_REACH
+			 *  chunks, like long teleports, have to be queued with queue() instead. */
+			bool isTickingChunksInParallel() const { return tickingChunksInParallel; }
+
+		protected:
+
 			Realm(Game &);
 			Realm(Game &, RealmID, RealmType, Identifier tileset_id, int64_t seed_);
 
@@ -332,6 +373,7 @@ namespace Game3 {
 
 			Game &game;
 			std::atomic_bool ticking = false;
+			std::atomic_bool tickingChunksInParallel = false;
 			MTQueue<std::weak_ptr<Entity>> entityRemovalQueue;
 			MTQueue<std::weak_ptr<Entity>> entityDestructionQueue;
 			MTQueue<std::pair<std::shared_ptr<Entity>, Position>> entityAdditionQueue;
@@ -345,19 +387,71 @@ namespace Game3 {
 			Lockable<std::unordered_map<ChunkPosition, std::shared_ptr<Lockable<std::unordered_set<TileEntityPtr>>>>> tileEntitiesByChunk;
 			ChunkPosition lastPlayerChunk{INT32_MIN, INT32_MIN};
 
+			GenerationPipeline generationPipeline{*this};
+			ChunkPrefetcher chunkPrefetcher{*this};
+
+			friend class ChunkPrefetcher;
+			friend class GenerationPipeline;
 			friend class ServerGame;
 
 			Lockable<std::map<ChunkPosition, WeakSet<RemoteClient>>> chunkRequests;
+			/** When each resident chunk was last visible to a player or otherwise needed. Only accessed from the tick thread. */
+			std::unordered_map<ChunkPosition, std::chrono::steady_clock::time_point> chunkLastNeeded;
 
 			SharedRecursiveMutex tileEntityMutex;
 
+			Lockable<std::unordered_map<GlobalID, std::weak_ptr<FlowField>>> flowFields;
+
+			/** What's left of the current tick's random tick budget. Shared by every chunk, which may be ticking in parallel. */
+			std::atomic<int64_t> randomTickNanosLeft = 0;
+			/** Random ticks skipped in the current tick because the budget ran out. */
+			std::atomic<uint64_t> randomTicksSkipped = 0;
+
 			void initRendererRealms();
 			void initRendererTileProviders();
+			/** On the server, makes the tile provider page chunks in from the database when they're accessed. */
+			void initChunkLoader();
 			bool isWalkable(Index row, Index column, const Tileset &);
+			/** Recomputes a chunk's pathmap without invalidating anything built from it. */
+			void fillPathChunk(ChunkPosition);
+			void invalidateFlowFields();
 			void setLayerHelper(Index row, Index col, Layer, TileUpdateContext = {});
 			ChunkPackets getChunkPackets(ChunkPosition);
 			void initEntity(const EntityPtr &, const Position &);
 			bool isActive() const;
+			/** Feeds the generation queue into the generation pipeline, absorbs finished chunks and answers chunk requests. */
+			void tickGeneration();
+			/** Moves a chunk generated in a scratch realm into this realm. */
+			void absorbGenerated(ChunkPosition, Realm &scratch);
+			/** Returns whether a generated chunk can be used without the tick thread waiting on the database: it's in memory
+			 *  or isn't stored at all. Otherwise, starts paging it in on the chunk load pool and returns false. */
+			bool prefetchChunk(ChunkPosition);
+			/** Sends a chunk to every client that requested it and clears the request. */
+			void sendRequestedChunk(ChunkPosition);
+			/** Ticks the non-player entities, tile entities and random ticks of a single chunk. */
+			void tickChunk(ChunkPosition, float delta);
+			/** Ticks chunks on the server's chunk pool in phases. Chunks in the same phase are at least 2 * PARALLEL_TICK_REACH
+			 *  chunks apart, so the areas two concurrent chunk ticks can touch never overlap. Anything that changes realm-wide
+			 *  containers should keep going through the realm's queues. If a chunk tick throws, the remaining phases are
+			 *  skipped and the first exception is rethrown on the calling thread. */
+			void tickChunksInParallel(std::vector<ChunkPosition>, float delta);
+			/** The server's budgets, or the defaults on the client. */
+			const TickBudgets & getTickBudgets() const;
+			/** Resets the random tick budget at the start of a tick. */
+			void startRandomTicks();
+			/** Records random ticks skipped during the tick that just finished. */
+			void finishRandomTicks();
+
+			/** Drains a queue until it's empty or the phase's budget runs out. Whatever's left is handled next tick. */
+			template <typename T, typename Fn>
+			void drainBudgeted(TickPhase phase, MTQueue<T> &queue, Fn &&function) {
+				TickPhaseStats &stats = tickPhaseStats[static_cast<size_t>(phase)];
+				stats.processed += queue.drainUntil(getTickBudgets().getDeadline(phase), std::forward<Fn>(function));
+				if (const size_t left = queue.size(); left != 0) {
+					++stats.starvedTicks;
+					stats.deferred += left;
+				}
+			}
 
 			static BiomeType getBiome(int64_t seed);
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+namespace Game3 {
+	class ServerGame;
+
+	/** The parts of Realm::tick that get their own time budget. */
+	enum class TickPhase: uint8_t {EntityRemoval, EntityDestruction, TileEntityRemoval, TileEntityDestruction, PlayerRemoval, General, RandomTicks};
+
+	constexpr size_t TICK_PHASE_COUNT = 7;
+	constexpr std::array<TickPhase, TICK_PHASE_COUNT> ALL_TICK_PHASES{TickPhase::EntityRemoval, TickPhase::EntityDestruction,
+		TickPhase::TileEntityRemoval, TickPhase::TileEntityDestruction, TickPhase::PlayerRemoval, TickPhase::General, TickPhase::RandomTicks};
+
+	std::string_view toString(TickPhase);
+	std::ostream & operator<<(std::ostream &, TickPhase);
+
+	/** How long each phase may run in one realm's tick. Queue phases that run out of time leave the rest of their queue for
+	 *  the next tick; random ticks that run out of time are skipped for the remaining chunks. On the server, each budget can
+	 *  be set in microseconds with a rule named "tickBudget" followed by the phase's name. Negative budgets are unlimited. */
+	class TickBudgets {
+		public:
+			constexpr static std::chrono::microseconds DEFAULT_QUEUE_BUDGET{2'000};
+			constexpr static std::chrono::microseconds DEFAULT_RANDOM_TICK_BUDGET{10'000};
+
+			TickBudgets();
+
+			inline std::chrono::microseconds get(TickPhase phase) const {
+				return std::chrono::microseconds(budgets[static_cast<size_t>(phase)].load(std::memory_order_relaxed));
+			}
+
+			inline void set(TickPhase phase, std::chrono::microseconds budget) {
+				budgets[static_cast<size_t>(phase)].store(budget.count(), std::memory_order_relaxed);
+			}
+
+			/** Returns the time a phase starting now has to finish by. */
+			std::chrono::steady_clock::time_point getDeadline(TickPhase) const;
+			/** Reads each phase's budget from the game rules, falling back to the defaults. */
+			void update(const ServerGame &);
+
+			static std::chrono::microseconds getDefault(TickPhase);
+
+		private:
+			/** Realms ticking in parallel read these while the tick thread updates them. */
+			std::array<std::atomic<int64_t>, TICK_PHASE_COUNT> budgets;
+	};
+
+	/** Totals for one phase across every tick so far. */
+	struct TickPhaseStats {
+		std::atomic<uint64_t> processed{0};
+		/** Ticks in which the phase ran out of time with work left. */
+		std::atomic<uint64_t> starvedTicks{0};
+		/** Work left for later ticks (or skipped, for random ticks), summed over every starved tick. */
+		std::atomic<uint64_t> deferred{0};
+	};
+}
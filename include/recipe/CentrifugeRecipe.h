@@ -29,6 +29,7 @@ namespace Game3 {
 
 	struct CentrifugeRecipeRegistry: UnnamedJSONRegistry<CentrifugeRecipe> {
 		static Identifier ID() { return {"base", "centrifuge_recipe"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::CentrifugeRecipe;
 		CentrifugeRecipeRegistry(): UnnamedJSONRegistry(ID()) {}
 	};
 }
@@ -34,6 +34,7 @@ namespace Game3 {
 
 	struct CombinerRecipeRegistry: NamedRegistry<CombinerRecipe> {
 		static Identifier ID() { return {"base", "registry/combiner"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::CombinerRecipe;
 		CombinerRecipeRegistry(): NamedRegistry(ID()) {}
 	};
 }
@@ -31,6 +31,7 @@ namespace Game3 {
 
 	struct CraftingRecipeRegistry: UnnamedJSONRegistry<CraftingRecipe> {
 		static Identifier ID() { return {"base", "registry/crafting_recipe"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::CraftingRecipe;
 		CraftingRecipeRegistry(): UnnamedJSONRegistry(ID()) {}
 	};
 }
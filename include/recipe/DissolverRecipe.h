@@ -36,6 +36,7 @@ namespace Game3 {
 
 	struct DissolverRecipeRegistry: NamedRegistry<DissolverRecipe> {
 		static Identifier ID() { return {"base", "registry/dissolver"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::DissolverRecipe;
 		DissolverRecipeRegistry(): NamedRegistry(ID()) {}
 	};
 }
@@ -34,6 +34,7 @@ namespace Game3 {
 			std::unordered_set<FluidID> fluidIDs;
 
 			static Identifier ID() { return {"base", "geothermal_recipe"}; }
+			constexpr static RegistrySlot SLOT = RegistrySlot::GeothermalRecipe;
 
 			GeothermalRecipeRegistry(): UnnamedJSONRegistry(ID()) {}
 
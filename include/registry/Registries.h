@@ -3,6 +3,11 @@
 #include "types/Types.h"
 #include "registry/Registry.h"
 
+#include <array>
+#include <concepts>
+#include <stdexcept>
+#include <string>
+
 namespace Game3 {
 	class Crop;
 	class EntityFactory;
@@ -24,83 +29,156 @@ namespace Game3 {
 	struct RealmDetails;
 	struct SoundPath;
 
-	struct RegistryRegistry: NamedRegistry<Registry> {
-		static Identifier ID() { return {"base", "registry/registry"}; }
-		RegistryRegistry(): NamedRegistry(ID()) {}
+	/** Fixed positions in the RegistryRegistry for the registries the engine itself defines. */
+	enum class RegistrySlot: uint8_t {
+		CraftingRecipe, Item, ItemTexture, Texture, EntityTexture, EntityFactory, Tileset, TileEntityFactory, Ore, RealmFactory,
+		RealmType, RealmDetails, PacketFactory, LocalCommandFactory, Fluid, Tile, Crop, CentrifugeRecipe, GeothermalRecipe,
+		ModuleFactory, ItemSet, DissolverRecipe, CombinerRecipe, Sound,
+		Count
+	};
+
+	template <typename T>
+	concept Slotted = requires {
+		{ T::SLOT } -> std::convertible_to<RegistrySlot>;
+	};
+
+	/** Registries that declare a SLOT are also kept in a fixed array, so looking them up by type is an array load instead
+	 *  of an identifier lookup and a dynamic cast. Registries without one are still found by identifier. */
+	class RegistryRegistry: public NamedRegistry<Registry> {
+		public:
+			static Identifier ID() { return {"base", "registry/registry"}; }
+			RegistryRegistry(): NamedRegistry(ID()) {}
+
+			template <typename S>
+			inline void add() {
+				std::shared_ptr<Registry> registry = NamedRegistry::add(S::ID(), std::make_shared<S>());
+				if constexpr (Slotted<S>) {
+					Registry *&slot = bySlot.at(static_cast<size_t>(S::SLOT));
+					if (slot != nullptr)
+						throw std::logic_error("Registry slot " + std::to_string(static_cast<size_t>(S::SLOT)) + " is already taken by " + slot->identifier.str());
+					slot = registry.get();
+				}
+			}
+
+			template <typename S>
+			inline S & get() {
+				if constexpr (Slotted<S>)
+					return *static_cast<S *>(getSlot(S::SLOT));
+				else
+					return NamedRegistry::get<S>();
+			}
+
+			template <typename S>
+			inline const S & get() const {
+				if constexpr (Slotted<S>)
+					return *static_cast<const S *>(getSlot(S::SLOT));
+				else
+					return NamedRegistry::get<S>();
+			}
+
+			inline void clear() {
+				NamedRegistry::clear();
+				bySlot.fill(nullptr);
+			}
+
+		private:
+			/** Owned by the shared pointers in the base registry. */
+			std::array<Registry *, static_cast<size_t>(RegistrySlot::Count)> bySlot{};
+
+			inline Registry * getSlot(RegistrySlot slot) const {
+				if (Registry *registry = bySlot[static_cast<size_t>(slot)])
+					return registry;
+				throw std::out_of_range("Registry slot " + std::to_string(static_cast<size_t>(slot)) + " is empty");
+			}
 	};
 
 	struct ItemRegistry: NamedRegistry<Item> {
 		static Identifier ID() { return {"base", "registry/item"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Item;
 		ItemRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct ItemTextureRegistry: NamedRegistry<ItemTexture> {
 		static Identifier ID() { return {"base", "registry/item_texture"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::ItemTexture;
 		ItemTextureRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct TextureRegistry: NamedRegistry<Texture> {
 		static Identifier ID() { return {"base", "registry/texture"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Texture;
 		TextureRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct EntityTextureRegistry: NamedRegistry<EntityTexture> {
 		static Identifier ID() { return {"base", "registry/entity_texture"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::EntityTexture;
 		EntityTextureRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct EntityFactoryRegistry: NamedRegistry<EntityFactory> {
 		static Identifier ID() { return {"base", "registry/entity_factory"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::EntityFactory;
 		EntityFactoryRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct TilesetRegistry: NamedRegistry<Tileset> {
 		static Identifier ID() { return {"base", "registry/tileset"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Tileset;
 		TilesetRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct TileEntityFactoryRegistry: NamedRegistry<TileEntityFactory> {
 		static Identifier ID() { return {"base", "registry/tile_entity_factory"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::TileEntityFactory;
 		TileEntityFactoryRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct OreRegistry: NamedRegistry<Ore> {
 		static Identifier ID() { return {"base", "registry/ore"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Ore;
 		OreRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct RealmFactoryRegistry: NamedRegistry<RealmFactory> {
 		static Identifier ID() { return {"base", "registry/realm_factory"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::RealmFactory;
 		RealmFactoryRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct RealmTypeRegistry: IdentifierRegistry {
 		static Identifier ID() { return {"base", "registry/realm_type"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::RealmType;
 		RealmTypeRegistry(): IdentifierRegistry(ID()) {}
 	};
 
 	struct RealmDetailsRegistry: NamedRegistry<RealmDetails> {
 		static Identifier ID() { return {"base", "registry/realm_details"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::RealmDetails;
 		RealmDetailsRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct PacketFactoryRegistry: NumericRegistry<PacketFactory> {
 		static Identifier ID() { return {"base", "registry/packet_factory"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::PacketFactory;
 		PacketFactoryRegistry(): NumericRegistry(ID()) {}
 	};
 
 	struct LocalCommandFactoryRegistry: StringRegistry<LocalCommandFactory> {
 		static Identifier ID() { return {"base", "registry/local_command_factory"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::LocalCommandFactory;
 		LocalCommandFactoryRegistry(): StringRegistry(ID()) {}
 	};
 
 	struct FluidRegistry: NamedRegistry<Fluid> {
 		static Identifier ID() { return {"base", "registry/fluid"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Fluid;
 		FluidRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct TileRegistry: NamedRegistry<Tile> {
 		static Identifier ID() { return {"base", "registry/tile"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Tile;
 		TileRegistry(): NamedRegistry(ID()) {}
 		void addMineable(Identifier, const ItemStack &, bool consumable);
 		void addMineable(Identifier, ItemStack &&, bool consumable);
@@ -108,21 +186,25 @@ namespace Game3 {
 
 	struct CropRegistry: NamedRegistry<Crop> {
 		static Identifier ID() { return {"base", "registry/crop"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Crop;
 		CropRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct ModuleFactoryRegistry: NamedRegistry<ModuleFactory> {
 		static Identifier ID() { return {"base", "registry/module_factory"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::ModuleFactory;
 		ModuleFactoryRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct ItemSetRegistry: NamedRegistry<ItemSet> {
 		static Identifier ID() { return {"base", "registry/itemset"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::ItemSet;
 		ItemSetRegistry(): NamedRegistry(ID()) {}
 	};
 
 	struct SoundRegistry: NamedRegistry<SoundPath> {
 		static Identifier ID() { return {"base", "registry/sound"}; }
+		constexpr static RegistrySlot SLOT = RegistrySlot::Sound;
 		SoundRegistry(): NamedRegistry(ID()) {}
 	};
 }
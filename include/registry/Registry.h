@@ -12,6 +12,7 @@
 #include <set>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -108,7 +109,9 @@ namespace Game3 {
 #endif
 
 		public:
+			/** Ordered by name so that iteration is the same everywhere. Lookups go through byIdentifier instead. */
 			std::map<Identifier, std::shared_ptr<T>> items;
+			std::unordered_map<Identifier, std::shared_ptr<T>> byIdentifier;
 			std::vector<std::shared_ptr<T>> byCounter;
 
 			using NamedRegistryBase::NamedRegistryBase;
@@ -131,8 +134,9 @@ namespace Game3 {
 
 			inline std::shared_ptr<T> add(Identifier new_name, std::shared_ptr<T> new_item) {
 				if (auto [iter, inserted] = items.try_emplace(new_name, std::move(new_item)); inserted) {
-					iter->second->identifier = std::move(new_name);
+					iter->second->identifier = new_name;
 					iter->second->registryID = nextCounter++;
+					byIdentifier.emplace(new_name, iter->second);
 					byCounter.push_back(iter->second);
 					return iter->second;
 				}
@@ -145,22 +149,22 @@ namespace Game3 {
 			}
 
 			inline bool contains(const Identifier &id) const {
-				return items.contains(id);
+				return byIdentifier.contains(id);
 			}
 
 			template <typename S>
 			inline S & get() {
-				return *std::dynamic_pointer_cast<S>(items.at(S::ID()));
+				return *std::dynamic_pointer_cast<S>(byIdentifier.at(S::ID()));
 			}
 
 			template <typename S>
 			inline const S & get() const {
-				return *std::dynamic_pointer_cast<const S>(items.at(S::ID()));
+				return *std::dynamic_pointer_cast<const S>(byIdentifier.at(S::ID()));
 			}
 
 			inline std::shared_ptr<T> maybe(const Identifier &id) const {
-				auto iter = items.find(id);
-				if (iter == items.end())
+				auto iter = byIdentifier.find(id);
+				if (iter == byIdentifier.end())
 					return {};
 				return iter->second;
 			}
@@ -184,16 +188,15 @@ namespace Game3 {
 			}
 
 			inline std::shared_ptr<T> at(const Identifier &id) const {
-				try {
-					return items.at(id);
-				} catch (const std::out_of_range &) {
-					ERROR("Couldn't find \"" << id << "\" in registry " << identifier);
-					return {};
-				}
+				if (auto iter = byIdentifier.find(id); iter != byIdentifier.end())
+					return iter->second;
+				ERROR("Couldn't find \"" << id << "\" in registry " << identifier);
+				return {};
 			}
 
 			inline void clear() {
 				items.clear();
+				byIdentifier.clear();
 				byCounter.clear();
 				nextCounter = 0;
 			}
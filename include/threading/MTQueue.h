@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <mutex>
 #include <optional>
 #include <queue>
@@ -88,6 +89,21 @@ namespace Game3 {
 				return std::queue<T, C>::size();
 			}
 
+			/** Takes items one at a time and passes them to the function until the queue is empty or the deadline has
+			 *  passed. At least one item is handled if any are queued. Returns how many were handled; the rest stay queued. */
+			template <typename Fn>
+			size_t drainUntil(std::chrono::steady_clock::time_point deadline, Fn &&function) {
+				size_t handled = 0;
+				do {
+					std::optional<T> item = tryTake();
+					if (!item)
+						break;
+					function(std::move(*item));
+					++handled;
+				} while (std::chrono::steady_clock::now() < deadline);
+				return handled;
+			}
+
 			inline C steal() {
 				std::unique_lock lock(mutex);
 				return std::move(this->c);
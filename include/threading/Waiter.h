@@ -2,6 +2,7 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <exception>
 #include <mutex>
 
 namespace Game3 {
@@ -13,11 +14,45 @@ namespace Game3 {
 			Waiter & operator--() noexcept;
 			void wait();
 			bool isDone() const noexcept;
+			/** Also forgets any exception stored by fail(). */
 			void reset(size_t);
 
+			/** Stores an exception thrown by a job so that the waiting thread can rethrow it. Only the first one is kept. */
+			void fail(std::exception_ptr) noexcept;
+			/** Rethrows the exception stored by fail(), if any. Call after wait(). */
+			void rethrow();
+
+			/** Decrements the waiter when destroyed, so a job that throws can't leave wait() hanging. */
+			struct Guard {
+				Waiter &parent;
+
+				explicit Guard(Waiter &parent_): parent(parent_) {}
+
+				Guard(const Guard &) = delete;
+				Guard & operator=(const Guard &) = delete;
+
+				~Guard() {
+					--parent;
+				}
+			};
+
+			/** Runs one job. Exceptions are passed to fail() instead of escaping, which would terminate a thread pool
+			 *  worker, and the waiter is decremented either way. */
+			template <typename F>
+			void run(F &&function) noexcept {
+				Guard guard(*this);
+				try {
+					function();
+				} catch (...) {
+					fail(std::current_exception());
+				}
+			}
+
 		private:
 			std::condition_variable condition;
 			std::atomic_size_t remaining;
 			std::mutex mutex;
+			/** Guarded by the mutex. */
+			std::exception_ptr exception;
 	};
 }
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Game3 {
+	using ProfileZoneID = uint32_t;
+
+	/** Accumulates the time spent in named zones. Zones nest: a zone entered while another is active on the same thread is
+	 *  recorded as its child, so the same zone can show up under several parents. Each distinct path from the root is a node
+	 *  with a global ID, and every thread accumulates into its own array of per-node totals without taking any locks, so
+	 *  recording costs a clock read and a small cache lookup. Totals are only summed across threads when a snapshot is taken. */
+	class Profiler {
+		public:
+			/** Distinct zone paths past this many are all recorded in a single overflow node. */
+			constexpr static uint32_t MAX_NODES = 2048;
+			constexpr static uint32_t ROOT_NODE = 0;
+			constexpr static uint32_t OVERFLOW_NODE = MAX_NODES - 1;
+
+			struct Sample {
+				std::chrono::nanoseconds time{};
+				uint64_t count = 0;
+			};
+
+			/** Totals summed over every thread, indexed by node ID. */
+			using Snapshot = std::vector<Sample>;
+
+			struct Entry {
+				ProfileZoneID zone;
+				/** Zone names from the root down, separated by slashes. */
+				std::string path;
+				/** Top-level zones have depth 0. */
+				size_t depth;
+				Sample sample;
+			};
+
+			/** Returns the same ID for every call with the same name. Takes a lock; call sites should cache the result,
+			 *  which PROFILE_ZONE does. */
+			static ProfileZoneID intern(std::string_view name);
+			static std::string getName(ProfileZoneID);
+
+			/** Makes the given zone the current thread's active zone and returns its node. The previously active node is
+			 *  stored in parent. */
+			static uint32_t enter(ProfileZoneID, uint32_t &parent);
+			/** Adds time to a node and, if it's still the active node on this thread, makes its parent active again. */
+			static void leave(uint32_t node, uint32_t parent, std::chrono::nanoseconds);
+
+			static Snapshot snapshot();
+			/** Returns every node that was entered between the two snapshots, depth first with siblings sorted by
+			 *  descending time. */
+			static std::vector<Entry> report(const Snapshot &now, const Snapshot &before = {});
+			/** Returns a zone's totals between two snapshots, summed over every path it appears in. */
+			static Sample total(ProfileZoneID, const Snapshot &now, const Snapshot &before = {});
+
+			/** Prints everything recorded since the last clear, skipping nodes that took less than threshold seconds. */
+			static void summary(double threshold = 0.0);
+			/** Resets what summary reports. Threads keep their totals; the current snapshot becomes the new baseline. */
+			static void clear();
+	};
+
+	/** Records the time between construction and destruction (or stop) in a zone. Zones should be stopped in the reverse
+	 *  order they were started in; stopping them out of order only misattributes the zones entered afterward. */
+	class ProfileZone {
+		public:
+			explicit ProfileZone(ProfileZoneID);
+			ProfileZone(const ProfileZone &) = delete;
+			ProfileZone(ProfileZone &&) = delete;
+
+			~ProfileZone();
+
+			ProfileZone & operator=(const ProfileZone &) = delete;
+			ProfileZone & operator=(ProfileZone &&) = delete;
+
+			std::chrono::nanoseconds difference() const;
+			void stop();
+			void restart();
+
+		private:
+			ProfileZoneID zone;
+			/** Declared before node because entering the zone fills it in. */
+			uint32_t parent = Profiler::ROOT_NODE;
+			uint32_t node;
+			std::chrono::steady_clock::time_point start;
+			bool stopped = false;
+	};
+}
+
+#define GAME3_PROFILE_CONCAT_(a, b) a##b
+#define GAME3_PROFILE_CONCAT(a, b) GAME3_PROFILE_CONCAT_(a, b)
+
+/** Interns a zone name once per call site. */
+#define PROFILE_ZONE_ID(name) ([] { static const ::Game3::ProfileZoneID profile_zone_id = ::Game3::Profiler::intern(name); return profile_zone_id; }())
+
+/** Profiles the rest of the enclosing scope. */
+#define PROFILE_ZONE(name) ::Game3::ProfileZone GAME3_PROFILE_CONCAT(profile_zone_, __LINE__){PROFILE_ZONE_ID(name)}
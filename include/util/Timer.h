@@ -1,36 +1,17 @@
 #pragma once
 
-#include <chrono>
-#include <map>
-#include <mutex>
-#include <shared_mutex>
-#include <string>
-#include <vector>
+#include "util/Profiler.h"
+
+#include <string_view>
 
 namespace Game3 {
-	class Timer {
+	/** A profiler zone whose name is looked up when it's constructed. That lookup takes a lock, so hot paths should use
+	 *  PROFILE_ZONE instead, which looks its name up once per call site. */
+	class Timer: public ProfileZone {
 		public:
-			static std::map<std::string, std::chrono::nanoseconds> times;
-			static std::map<std::string, size_t> counts;
-			static std::shared_mutex mutex;
-
-			std::chrono::system_clock::time_point start;
-			const std::string name;
-
-			Timer(const std::string &name_);
-			~Timer();
-
-			std::chrono::nanoseconds difference() const;
-			void stop();
-			void restart();
+			Timer(std::string_view name);
 
 			static void summary(double threshold = 0.0);
 			static void clear();
-
-			static auto sharedLock() { return std::shared_lock(mutex); }
-			static auto uniqueLock() { return std::unique_lock(mutex); }
-
-		private:
-			bool stopped = false;
 	};
 }
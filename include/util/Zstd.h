@@ -9,7 +9,10 @@ namespace Game3 {
 	std::vector<uint16_t> decompress16(std::span<const uint8_t> span);
 	std::vector<uint32_t> decompress32(std::span<const uint8_t> span);
 	std::vector<uint64_t> decompress64(std::span<const uint8_t> span);
+	/** Compresses with the maximum compression level. */
 	std::vector<uint8_t> compress(std::span<const uint8_t > span);
+	/** Compresses with a given zstd compression level. Lower levels are much faster. */
+	std::vector<uint8_t> compress(std::span<const uint8_t > span, int level);
 	std::vector<uint8_t> compress(std::span<const uint16_t> span);
 	std::vector<uint8_t> compress(std::span<const uint32_t> span);
 	std::vector<uint8_t> compress(std::span<const uint64_t> span);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "types/ChunkPosition.h"
+#include "threading/MTQueue.h"
+
+#include <memory>
+#include <set>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace Game3 {
+	class Realm;
+
+	/** Generates a realm's chunks off the tick thread. Each chunk is generated into a scratch copy of the realm on
+	 *  WorldGen::backgroundPool and handed back to the tick thread, which absorbs it into the real realm. */
+	class GenerationPipeline {
+		public:
+			/** The maximum number of chunks that can be generated at once for a single realm. */
+			constexpr static size_t MAX_IN_FLIGHT = 2;
+
+			/** A generated chunk position and the scratch realm it was generated in. The scratch realm is null if generation failed. */
+			using Result = std::pair<ChunkPosition, std::shared_ptr<Realm>>;
+
+			GenerationPipeline(Realm &);
+
+			/** Queues a chunk for generation unless it's already queued or being generated. Should be called on the tick thread. */
+			void request(ChunkPosition);
+			/** Returns whether a chunk is queued or being generated. Should be called on the tick thread. */
+			bool isPending(ChunkPosition) const;
+			/** Starts generating the queued chunks closest to the given chunk positions (usually those of the realm's players)
+			 *  until MAX_IN_FLIGHT jobs are running, then returns the jobs that have finished since the last call.
+			 *  Should be called on the tick thread. */
+			std::vector<Result> tick(const std::vector<ChunkPosition> &focuses);
+
+		private:
+			Realm &realm;
+			/** Only accessed from the tick thread. */
+			std::set<ChunkPosition> waiting;
+			/** Only accessed from the tick thread. */
+			std::unordered_set<ChunkPosition> inFlight;
+			MTQueue<Result> finished;
+
+			void start(ChunkPosition);
+	};
+}
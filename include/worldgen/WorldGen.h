@@ -36,5 +36,7 @@ namespace Game3 {
 
 	namespace WorldGen {
 		extern ThreadPool pool;
+		/** Runs GenerationPipeline jobs. Kept apart from the main pool because those jobs wait on it. */
+		extern ThreadPool backgroundPool;
 	}
 }
@@ -3,6 +3,7 @@
 #include "algorithm/AStar.h"
 
 #include <algorithm>
+#include <array>
 #include <queue>
 #include <vector>
 
@@ -98,4 +99,167 @@ namespace Game3 {
 
 		return false;
 	}
-}
\ No newline at end of file
+
+	namespace {
+		/** How many chunks of slack the search window has around the endpoints' bounding box. */
+		constexpr int64_t WINDOW_MARGIN_CHUNKS = 1;
+		/** Searches whose window would cover more chunks than this use simpleAStar instead. */
+		constexpr size_t MAX_WINDOW_CHUNKS = 256;
+
+		/** Reusable per-thread search state. Entries are only valid when their stamp matches the current search's stamp,
+		 *  so nothing has to be cleared between searches. */
+		struct GridScratch {
+			std::vector<uint32_t> costs;
+			std::vector<uint32_t> tileStamps;
+			/** The direction each tile was reached from, as an index into OFFSETS. */
+			std::vector<uint8_t> parents;
+			std::vector<uint8_t> pathStates;
+			std::vector<uint32_t> chunkStamps;
+			std::vector<bool> chunkPresent;
+			std::vector<std::pair<uint32_t, uint32_t>> heap;
+			uint32_t stamp = 0;
+
+			void prepare(size_t tile_count, size_t chunk_count) {
+				if (costs.size() < tile_count) {
+					costs.resize(tile_count);
+					tileStamps.resize(tile_count);
+					parents.resize(tile_count);
+					pathStates.resize(tile_count);
+				}
+
+				if (chunkStamps.size() < chunk_count) {
+					chunkStamps.resize(chunk_count);
+					chunkPresent.resize(chunk_count);
+				}
+
+				if (++stamp == 0) {
+					std::fill(tileStamps.begin(), tileStamps.end(), 0);
+					std::fill(chunkStamps.begin(), chunkStamps.end(), 0);
+					stamp = 1;
+				}
+
+				heap.clear();
+			}
+		};
+
+		thread_local GridScratch gridScratch;
+
+		constexpr std::array<std::pair<int8_t, int8_t>, 4> OFFSETS{{{-1, 0}, {0, -1}, {1, 0}, {0, 1}}};
+	}
+
+	bool gridAStar(const std::shared_ptr<Realm> &realm, const Position &start, const Position &goal, std::vector<Position> &path, size_t loop_max) {
+		const TileProvider &provider = realm->tileProvider;
+
+		const int64_t min_chunk_x = TileProvider::divide(std::min(start.column, goal.column)) - WINDOW_MARGIN_CHUNKS;
+		const int64_t min_chunk_y = TileProvider::divide(std::min(start.row, goal.row)) - WINDOW_MARGIN_CHUNKS;
+		const int64_t chunk_columns = TileProvider::divide(std::max(start.column, goal.column)) + WINDOW_MARGIN_CHUNKS - min_chunk_x + 1;
+		const int64_t chunk_rows = TileProvider::divide(std::max(start.row, goal.row)) + WINDOW_MARGIN_CHUNKS - min_chunk_y + 1;
+
+		if (MAX_WINDOW_CHUNKS < static_cast<size_t>(chunk_columns * chunk_rows))
+			return simpleAStar(realm, start, goal, path, loop_max);
+
+		const Index origin_row = min_chunk_y * CHUNK_SIZE;
+		const Index origin_column = min_chunk_x * CHUNK_SIZE;
+		const Index width = chunk_columns * CHUNK_SIZE;
+		const Index height = chunk_rows * CHUNK_SIZE;
+
+		GridScratch &scratch = gridScratch;
+		scratch.prepare(static_cast<size_t>(width * height), static_cast<size_t>(chunk_columns * chunk_rows));
+		const uint32_t stamp = scratch.stamp;
+
+		auto to_index = [&](Index row, Index column) {
+			return static_cast<uint32_t>((row - origin_row) * width + (column - origin_column));
+		};
+
+		auto heuristic = [&](Index row, Index column) {
+			return static_cast<uint32_t>(std::abs(row - goal.row) + std::abs(column - goal.column));
+		};
+
+		auto is_passable = [&](Index row, Index column) {
+			const Index local_row = row - origin_row;
+			const Index local_column = column - origin_column;
+			const size_t chunk_index = (local_row / CHUNK_SIZE) * chunk_columns + local_column / CHUNK_SIZE;
+
+			if (scratch.chunkStamps[chunk_index] != stamp) {
+				scratch.chunkStamps[chunk_index] = stamp;
+				const Index chunk_row = local_row - local_row % CHUNK_SIZE;
+				const Index chunk_column = local_column - local_column % CHUNK_SIZE;
+				const ChunkPosition chunk_position(min_chunk_x + chunk_column / CHUNK_SIZE, min_chunk_y + chunk_row / CHUNK_SIZE);
+				uint8_t *destination = scratch.pathStates.data() + chunk_row * width + chunk_column;
+				scratch.chunkPresent[chunk_index] = provider.copyPathChunk(chunk_position, destination, static_cast<size_t>(width));
+			}
+
+			return scratch.chunkPresent[chunk_index] && scratch.pathStates[local_row * width + local_column] != 0;
+		};
+
+		auto push = [&](uint32_t priority, uint32_t index) {
+			scratch.heap.emplace_back(priority, index);
+			std::push_heap(scratch.heap.begin(), scratch.heap.end(), std::greater<>{});
+		};
+
+		const uint32_t start_index = to_index(start.row, start.column);
+		scratch.costs[start_index] = 0;
+		scratch.tileStamps[start_index] = stamp;
+		push(heuristic(start.row, start.column), start_index);
+
+		bool hit_edge = false;
+		size_t loops = 0;
+
+		for (; loops < loop_max && !scratch.heap.empty(); ++loops) {
+			std::pop_heap(scratch.heap.begin(), scratch.heap.end(), std::greater<>{});
+			const auto [priority, index] = scratch.heap.back();
+			scratch.heap.pop_back();
+
+			const Index row = origin_row + index / width;
+			const Index column = origin_column + index % width;
+			const uint32_t cost = scratch.costs[index];
+
+			// Skip entries superseded by a cheaper route to the same tile.
+			if (priority != cost + heuristic(row, column))
+				continue;
+
+			if (row == goal.row && column == goal.column) {
+				path.clear();
+				Position position = goal;
+				while (position != start) {
+					path.push_back(position);
+					const auto [row_offset, column_offset] = OFFSETS[scratch.parents[to_index(position.row, position.column)]];
+					position.row -= row_offset;
+					position.column -= column_offset;
+				}
+				path.push_back(start);
+				std::reverse(path.begin(), path.end());
+				return true;
+			}
+
+			for (uint8_t direction = 0; direction < OFFSETS.size(); ++direction) {
+				const Index next_row = row + OFFSETS[direction].first;
+				const Index next_column = column + OFFSETS[direction].second;
+
+				if (next_row < origin_row || next_column < origin_column || origin_row + height <= next_row || origin_column + width <= next_column) {
+					hit_edge = true;
+					continue;
+				}
+
+				if (!is_passable(next_row, next_column))
+					continue;
+
+				const uint32_t next_index = to_index(next_row, next_column);
+				const uint32_t new_cost = cost + 1;
+
+				if (scratch.tileStamps[next_index] != stamp || new_cost < scratch.costs[next_index]) {
+					scratch.tileStamps[next_index] = stamp;
+					scratch.costs[next_index] = new_cost;
+					scratch.parents[next_index] = direction;
+					push(new_cost + heuristic(next_row, next_column), next_index);
+				}
+			}
+		}
+
+		// The window may have cut off the only route.
+		if (hit_edge && loops < loop_max)
+			return simpleAStar(realm, start, goal, path, loop_max);
+
+		return false;
+	}
+}
@@ -0,0 +1,149 @@
+#include "algorithm/FlowField.h"
+#include "game/TileProvider.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace Game3 {
+	FlowField::FlowField(Index radius_):
+		radius(radius_),
+		slack(radius_ / 2),
+		width(2 * (radius_ + radius_ / 2) + 1),
+		distances(width * width),
+		stamps(width * width, 0),
+		pathStates(width * width, 0) {
+			queue.reserve(width * width);
+		}
+
+	void FlowField::invalidate() {
+		stale = true;
+	}
+
+	bool FlowField::getPath(const TileProvider &provider, const Position &new_goal, const Position &start, std::list<Direction> &out) {
+		std::unique_lock lock(mutex);
+
+		const Index center_row = origin.row + radius + slack;
+		const Index center_column = origin.column + radius + slack;
+		const bool drifted = !hasGoal || slack < std::abs(new_goal.row - center_row) || slack < std::abs(new_goal.column - center_column);
+
+		if (stale.exchange(false) || drifted) {
+			load(provider, new_goal);
+			restart(new_goal);
+		} else if (goal != new_goal) {
+			restart(new_goal);
+		}
+
+		if (!contains(start) || !expandTo(toIndex(start)))
+			return false;
+
+		// Every tile the field has reached has a neighbor one step closer to the goal.
+		Position position = start;
+		uint16_t distance = distances[toIndex(start)];
+
+		while (1 < distance) {
+			bool stepped = false;
+
+			for (const Direction direction: ALL_DIRECTIONS) {
+				const Position next = position + direction;
+				if (contains(next)) {
+					const uint32_t index = toIndex(next);
+					if (visited(index) && distances[index] == distance - 1) {
+						out.push_back(direction);
+						position = next;
+						--distance;
+						stepped = true;
+						break;
+					}
+				}
+			}
+
+			if (!stepped)
+				return false;
+		}
+
+		return true;
+	}
+
+	void FlowField::load(const TileProvider &provider, const Position &center) {
+		origin = {center.row - radius - slack, center.column - radius - slack};
+		std::fill(pathStates.begin(), pathStates.end(), 0);
+
+		const Index top = origin.row;
+		const Index left = origin.column;
+		const Index bottom = top + width - 1;
+		const Index right = left + width - 1;
+		std::array<uint8_t, CHUNK_SIZE * CHUNK_SIZE> chunk;
+
+		for (auto chunk_y = TileProvider::divide(top), max_y = TileProvider::divide(bottom); chunk_y <= max_y; ++chunk_y) {
+			for (auto chunk_x = TileProvider::divide(left), max_x = TileProvider::divide(right); chunk_x <= max_x; ++chunk_x) {
+				if (!provider.copyPathChunk(ChunkPosition(chunk_x, chunk_y), chunk.data(), CHUNK_SIZE))
+					continue;
+
+				const Index row_min = std::max<Index>(top, chunk_y * CHUNK_SIZE);
+				const Index row_max = std::min<Index>(bottom, (chunk_y + 1) * CHUNK_SIZE - 1);
+				const Index column_min = std::max<Index>(left, chunk_x * CHUNK_SIZE);
+				const Index column_max = std::min<Index>(right, (chunk_x + 1) * CHUNK_SIZE - 1);
+
+				for (Index row = row_min; row <= row_max; ++row) {
+					const uint8_t *source = chunk.data() + (row - chunk_y * CHUNK_SIZE) * CHUNK_SIZE + column_min - chunk_x * CHUNK_SIZE;
+					std::memcpy(pathStates.data() + (row - top) * width + column_min - left, source, column_max - column_min + 1);
+				}
+			}
+		}
+	}
+
+	void FlowField::restart(const Position &new_goal) {
+		goal = new_goal;
+		hasGoal = true;
+
+		if (++stamp == 0) {
+			std::fill(stamps.begin(), stamps.end(), 0);
+			stamp = 1;
+		}
+
+		queue.clear();
+		queueHead = 0;
+
+		const uint32_t goal_index = toIndex(goal);
+		distances[goal_index] = 0;
+		stamps[goal_index] = stamp;
+		queue.push_back(goal_index);
+	}
+
+	bool FlowField::expandTo(uint32_t index) {
+		while (!visited(index) && queueHead < queue.size()) {
+			const uint32_t current = queue[queueHead++];
+			const Index row = current / width;
+			const Index column = current % width;
+			const uint16_t distance = distances[current] + 1;
+
+			auto visit = [&](uint32_t neighbor) {
+				if (pathStates[neighbor] != 0 && !visited(neighbor)) {
+					distances[neighbor] = distance;
+					stamps[neighbor] = stamp;
+					queue.push_back(neighbor);
+				}
+			};
+
+			if (0 < row)
+				visit(current - width);
+			if (0 < column)
+				visit(current - 1);
+			if (row < width - 1)
+				visit(current + width);
+			if (column < width - 1)
+				visit(current + 1);
+		}
+
+		return visited(index);
+	}
+
+	bool FlowField::contains(const Position &position) const {
+		return origin.row <= position.row && position.row < origin.row + width && origin.column <= position.column && position.column < origin.column + width;
+	}
+
+	uint32_t FlowField::toIndex(const Position &position) const {
+		return static_cast<uint32_t>((position.row - origin.row) * width + position.column - origin.column);
+	}
+}
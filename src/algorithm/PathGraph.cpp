@@ -0,0 +1,321 @@
+#include "algorithm/PathGraph.h"
+#include "game/TileProvider.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <queue>
+
+namespace Game3 {
+	namespace {
+		constexpr uint16_t UNREACHABLE = std::numeric_limits<uint16_t>::max();
+		/** Border runs at least this long get a portal at each end instead of one in the middle. */
+		constexpr Index LONG_RUN = 8;
+		constexpr size_t CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+
+		using PathStates = std::array<uint8_t, CHUNK_AREA>;
+
+		/** Fills distances with the number of steps from the origin to every tile of the chunk. */
+		void breadthFirst(const PathStates &states, Index origin_row, Index origin_column, std::vector<uint16_t> &distances) {
+			distances.assign(CHUNK_AREA, UNREACHABLE);
+
+			const size_t origin = origin_row * CHUNK_SIZE + origin_column;
+			if (states[origin] == 0)
+				return;
+
+			std::vector<uint16_t> queue;
+			queue.reserve(CHUNK_AREA);
+			queue.push_back(origin);
+			distances[origin] = 0;
+
+			for (size_t next = 0; next < queue.size(); ++next) {
+				const uint16_t index = queue[next];
+				const Index row = index / CHUNK_SIZE;
+				const Index column = index % CHUNK_SIZE;
+				const uint16_t distance = distances[index] + 1;
+
+				auto visit = [&](size_t neighbor) {
+					if (states[neighbor] != 0 && distances[neighbor] == UNREACHABLE) {
+						distances[neighbor] = distance;
+						queue.push_back(static_cast<uint16_t>(neighbor));
+					}
+				};
+
+				if (0 < row)
+					visit(index - CHUNK_SIZE);
+				if (0 < column)
+					visit(index - 1);
+				if (row < CHUNK_SIZE - 1)
+					visit(index + CHUNK_SIZE);
+				if (column < CHUNK_SIZE - 1)
+					visit(index + 1);
+			}
+		}
+
+		size_t localIndex(const Position &position) {
+			return TileProvider::remainder(position.row) * CHUNK_SIZE + TileProvider::remainder(position.column);
+		}
+	}
+
+	PathGraph::PathGraph(const TileProvider &provider_):
+		provider(provider_) {}
+
+	void PathGraph::invalidate(ChunkPosition chunk_position) {
+		std::unique_lock lock(mutex);
+		invalidateUnlocked(chunk_position);
+		invalidateUnlocked({chunk_position.x - 1, chunk_position.y});
+		invalidateUnlocked({chunk_position.x + 1, chunk_position.y});
+		invalidateUnlocked({chunk_position.x, chunk_position.y - 1});
+		invalidateUnlocked({chunk_position.x, chunk_position.y + 1});
+	}
+
+	void PathGraph::invalidate(const Position &position) {
+		const ChunkPosition chunk_position = position.getChunk();
+		const auto row = TileProvider::remainder(position.row);
+		const auto column = TileProvider::remainder(position.column);
+
+		std::unique_lock lock(mutex);
+		invalidateUnlocked(chunk_position);
+
+		// Tiles on a border also decide where the neighboring chunk's portals are.
+		if (row == 0)
+			invalidateUnlocked({chunk_position.x, chunk_position.y - 1});
+		else if (row == CHUNK_SIZE - 1)
+			invalidateUnlocked({chunk_position.x, chunk_position.y + 1});
+
+		if (column == 0)
+			invalidateUnlocked({chunk_position.x - 1, chunk_position.y});
+		else if (column == CHUNK_SIZE - 1)
+			invalidateUnlocked({chunk_position.x + 1, chunk_position.y});
+	}
+
+	void PathGraph::clear() {
+		std::unique_lock lock(mutex);
+		chunks.clear();
+		++generation;
+	}
+
+	void PathGraph::invalidateUnlocked(ChunkPosition chunk_position) {
+		chunks.erase(chunk_position);
+		++generation;
+	}
+
+	std::shared_ptr<const PathGraph::ChunkGraph> PathGraph::getGraph(ChunkPosition chunk_position) {
+		uint64_t build_generation{};
+
+		{
+			std::unique_lock lock(mutex);
+			if (auto iter = chunks.find(chunk_position); iter != chunks.end())
+				return iter->second;
+			build_generation = generation;
+		}
+
+		std::shared_ptr<const ChunkGraph> graph = build(chunk_position);
+
+		std::unique_lock lock(mutex);
+		// If something was invalidated during the build, the graph might be stale. It's still fine for the current search.
+		if (generation == build_generation)
+			chunks.try_emplace(chunk_position, graph);
+		return graph;
+	}
+
+	std::shared_ptr<const PathGraph::ChunkGraph> PathGraph::build(ChunkPosition chunk_position) const {
+		auto out = std::make_shared<ChunkGraph>();
+		ChunkGraph &graph = *out;
+
+		PathStates states;
+		if (!provider.copyPathChunk(chunk_position, states.data(), CHUNK_SIZE))
+			return out;
+
+		const Position top_left = chunk_position.topLeft();
+
+		// Each side is described by the local coordinates of its first tile, the step along the border and the neighboring
+		// chunk, whose tile across from local tile (row, column) is at (row - row_offset, column - column_offset) locally.
+		struct BorderSide {
+			Index row;
+			Index column;
+			Index rowStep;
+			Index columnStep;
+			ChunkPosition neighbor;
+			Index rowOffset;
+			Index columnOffset;
+		};
+
+		const std::array<BorderSide, 4> sides{{
+			{0, 0, 0, 1, {chunk_position.x, chunk_position.y - 1}, -(CHUNK_SIZE - 1), 0},
+			{CHUNK_SIZE - 1, 0, 0, 1, {chunk_position.x, chunk_position.y + 1}, CHUNK_SIZE - 1, 0},
+			{0, 0, 1, 0, {chunk_position.x - 1, chunk_position.y}, 0, -(CHUNK_SIZE - 1)},
+			{0, CHUNK_SIZE - 1, 1, 0, {chunk_position.x + 1, chunk_position.y}, 0, CHUNK_SIZE - 1},
+		}};
+
+		PathStates neighbor_states;
+
+		auto add_node = [&](Index row, Index column) {
+			const Position position(top_left.row + row, top_left.column + column);
+			if (!graph.nodeIndices.contains(position)) {
+				graph.nodeIndices.emplace(position, static_cast<uint16_t>(graph.nodes.size()));
+				graph.nodes.push_back(position);
+			}
+		};
+
+		for (const BorderSide &side: sides) {
+			if (!provider.copyPathChunk(side.neighbor, neighbor_states.data(), CHUNK_SIZE))
+				continue;
+
+			auto is_entrance = [&](Index i) {
+				const Index row = side.row + i * side.rowStep;
+				const Index column = side.column + i * side.columnStep;
+				return states[row * CHUNK_SIZE + column] != 0 && neighbor_states[(row - side.rowOffset) * CHUNK_SIZE + column - side.columnOffset] != 0;
+			};
+
+			auto add_run = [&](Index first, Index last) {
+				if (last - first + 1 < LONG_RUN) {
+					const Index middle = (first + last) / 2;
+					add_node(side.row + middle * side.rowStep, side.column + middle * side.columnStep);
+				} else {
+					add_node(side.row + first * side.rowStep, side.column + first * side.columnStep);
+					add_node(side.row + last * side.rowStep, side.column + last * side.columnStep);
+				}
+			};
+
+			// Both chunks on a border find the same runs, so their portals always line up.
+			Index run_start = -1;
+			for (Index i = 0; i < CHUNK_SIZE; ++i) {
+				if (is_entrance(i)) {
+					if (run_start < 0)
+						run_start = i;
+				} else if (0 <= run_start) {
+					add_run(run_start, i - 1);
+					run_start = -1;
+				}
+			}
+
+			if (0 <= run_start)
+				add_run(run_start, CHUNK_SIZE - 1);
+		}
+
+		const size_t node_count = graph.nodes.size();
+		graph.distances.assign(node_count * node_count, UNREACHABLE);
+
+		std::vector<uint16_t> distances;
+		for (size_t i = 0; i < node_count; ++i) {
+			const size_t origin = localIndex(graph.nodes[i]);
+			breadthFirst(states, origin / CHUNK_SIZE, origin % CHUNK_SIZE, distances);
+			for (size_t j = 0; j < node_count; ++j)
+				graph.distances[i * node_count + j] = distances[localIndex(graph.nodes[j])];
+		}
+
+		return out;
+	}
+
+	bool PathGraph::findWaypoints(const Position &start, const Position &goal, std::vector<Position> &waypoints, size_t max_expansions) {
+		const ChunkPosition start_chunk = start.getChunk();
+		const ChunkPosition goal_chunk = goal.getChunk();
+
+		PathStates states;
+		std::vector<uint16_t> start_distances;
+		std::vector<uint16_t> goal_distances;
+
+		if (!provider.copyPathChunk(start_chunk, states.data(), CHUNK_SIZE))
+			return false;
+		breadthFirst(states, TileProvider::remainder(start.row), TileProvider::remainder(start.column), start_distances);
+
+		if (start_chunk == goal_chunk && start_distances[localIndex(goal)] != UNREACHABLE) {
+			waypoints = {goal};
+			return true;
+		}
+
+		if (!provider.copyPathChunk(goal_chunk, states.data(), CHUNK_SIZE))
+			return false;
+		breadthFirst(states, TileProvider::remainder(goal.row), TileProvider::remainder(goal.column), goal_distances);
+
+		// The graphs this search has used. Holding them here means the mutex is taken once per chunk, not per expansion.
+		std::unordered_map<ChunkPosition, std::shared_ptr<const ChunkGraph>> graphs;
+
+		auto graph_at = [&](ChunkPosition chunk_position) -> const ChunkGraph & {
+			std::shared_ptr<const ChunkGraph> &graph = graphs[chunk_position];
+			if (!graph)
+				graph = getGraph(chunk_position);
+			return *graph;
+		};
+
+		std::unordered_map<Position, size_t> costs;
+		std::unordered_map<Position, Position> parents;
+		using Entry = std::pair<size_t, Position>;
+		std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> frontier;
+
+		auto heuristic = [&](const Position &position) -> size_t {
+			return position.taxiDistance(goal);
+		};
+
+		auto relax = [&](const Position &position, size_t cost, const Position &parent) {
+			if (auto iter = costs.find(position); iter == costs.end() || cost < iter->second) {
+				costs[position] = cost;
+				parents[position] = parent;
+				frontier.emplace(cost + heuristic(position), position);
+			}
+		};
+
+		// The goal only becomes reachable through the goal chunk's portals, so it's pushed as they're expanded.
+		auto relax_goal = [&](const Position &position, size_t cost) {
+			if (position.getChunk() == goal_chunk)
+				if (const uint16_t distance = goal_distances[localIndex(position)]; distance != UNREACHABLE)
+					relax(goal, cost + distance, position);
+		};
+
+		for (const Position &node: graph_at(start_chunk).nodes)
+			if (const uint16_t distance = start_distances[localIndex(node)]; distance != UNREACHABLE)
+				relax(node, distance, start);
+
+		for (size_t expansions = 0; expansions < max_expansions && !frontier.empty(); ++expansions) {
+			const auto [priority, current] = frontier.top();
+			frontier.pop();
+
+			const size_t cost = costs.at(current);
+			if (priority != cost + heuristic(current))
+				continue;
+
+			if (current == goal) {
+				std::vector<Position> route{goal};
+				for (Position position = goal; position != start;) {
+					position = parents.at(position);
+					route.push_back(position);
+				}
+				std::reverse(route.begin(), route.end());
+
+				// Keep the first tile of each chunk entered along the route; the walk between two of them stays within a chunk.
+				waypoints.clear();
+				for (size_t i = 1; i < route.size(); ++i)
+					if (route[i].getChunk() != route[i - 1].getChunk())
+						waypoints.push_back(route[i]);
+
+				if (waypoints.empty() || waypoints.back() != goal)
+					waypoints.push_back(goal);
+				return true;
+			}
+
+			const ChunkPosition chunk_position = current.getChunk();
+			const ChunkGraph &graph = graph_at(chunk_position);
+			const auto iter = graph.nodeIndices.find(current);
+			if (iter == graph.nodeIndices.end())
+				continue;
+
+			relax_goal(current, cost);
+
+			const size_t node_count = graph.nodes.size();
+			const size_t row_offset = iter->second * node_count;
+			for (size_t j = 0; j < node_count; ++j)
+				if (const uint16_t distance = graph.distances[row_offset + j]; j != iter->second && distance != UNREACHABLE)
+					relax(graph.nodes[j], cost + distance, current);
+
+			// Portals come in pairs on either side of a border, one step apart.
+			for (const Position neighbor: {current + Position(-1, 0), current + Position(1, 0), current + Position(0, -1), current + Position(0, 1)}) {
+				const ChunkPosition neighbor_chunk = neighbor.getChunk();
+				if (neighbor_chunk != chunk_position && graph_at(neighbor_chunk).nodeIndices.contains(neighbor))
+					relax(neighbor, cost + 1, current);
+			}
+		}
+
+		return false;
+	}
+}
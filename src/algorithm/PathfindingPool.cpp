@@ -0,0 +1,98 @@
+#include "algorithm/AStar.h"
+#include "algorithm/PathfindingPool.h"
+#include "realm/Realm.h"
+
+namespace Game3 {
+	PathfindingPool::PathfindingPool(size_t thread_count):
+		pool(thread_count) {}
+
+	void PathfindingPool::start() {
+		pool.start();
+	}
+
+	void PathfindingPool::join() {
+		pool.join();
+		auto lock = pending.uniqueLock();
+		pending.clear();
+	}
+
+	bool PathfindingPool::request(const std::shared_ptr<Realm> &realm, const Position &start, const Position &goal, size_t loop_max, Callback callback) {
+		Key key(realm->id, start, goal, loop_max);
+
+		{
+			auto lock = pending.uniqueLock();
+			if (auto iter = pending.find(key); iter != pending.end()) {
+				iter->second.push_back(std::move(callback));
+				++sharedCount;
+				return true;
+			}
+			pending[key].push_back(std::move(callback));
+		}
+
+		const bool added = pool.add([this, key, weak_realm = std::weak_ptr(realm)](ThreadPool &, size_t) {
+			const auto &[realm_id, start, goal, loop_max] = key;
+			std::shared_ptr<const PathSearch> result;
+
+			if (RealmPtr realm = weak_realm.lock()) {
+				result = std::make_shared<PathSearch>(search(realm, start, goal, loop_max));
+				++searchCount;
+			} else {
+				result = std::make_shared<PathSearch>(PathSearch{start, goal});
+			}
+
+			std::vector<Callback> callbacks;
+			{
+				auto lock = pending.uniqueLock();
+				if (auto iter = pending.find(key); iter != pending.end()) {
+					callbacks = std::move(iter->second);
+					pending.erase(iter);
+				}
+			}
+
+			for (const Callback &callback: callbacks)
+				callback(result);
+		});
+
+		if (!added) {
+			auto lock = pending.uniqueLock();
+			pending.erase(key);
+		}
+
+		return added;
+	}
+
+	PathSearch PathfindingPool::search(const std::shared_ptr<Realm> &realm, const Position &start, const Position &goal, size_t loop_max) {
+		PathSearch out{start, goal};
+
+		if (start == goal) {
+			out.result = PathResult::Trivial;
+			return out;
+		}
+
+		if (gridAStar(realm, start, goal, out.positions, loop_max)) {
+			out.result = PathResult::Success;
+			return out;
+		}
+
+		out.result = PathResult::Unpathable;
+		out.positions.clear();
+
+		if (start.taxiDistance(goal) <= CHUNK_SIZE || !realm->pathGraph.findWaypoints(start, goal, out.waypoints))
+			return out;
+
+		// Refine the first leg now so the entity can start walking as soon as the result is applied.
+		auto waypoint = out.waypoints.begin();
+		while (waypoint != out.waypoints.end() && *waypoint == start)
+			++waypoint;
+
+		if (waypoint != out.waypoints.end() && gridAStar(realm, start, *waypoint, out.positions, LEG_LOOP_MAX)) {
+			out.waypoints.erase(out.waypoints.begin(), waypoint + 1);
+			out.result = PathResult::Success;
+		} else {
+			out.positions.clear();
+			out.waypoints.clear();
+		}
+
+		return out;
+	}
+}
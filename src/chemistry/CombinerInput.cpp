@@ -41,7 +41,7 @@ namespace Game3 {
 
 		for (const auto &[count, string]: inputs) {
 			if (string.find(':') == std::string::npos)
-				out.emplace_back(game, "base:item/chemical", count, nlohmann::json{{"formula", string}});
+				out.emplace_back(game, "base:item/chemical", count, ItemData{{"formula", string}});
 			else
 				out.emplace_back(game, Identifier(string), count);
 		}
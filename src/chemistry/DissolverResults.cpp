@@ -137,7 +137,7 @@ namespace Game3 {
 			return;
 
 		if (formula.find(':') == std::string::npos)
-			stacks.emplace_back(game, "base:item/chemical", 1, nlohmann::json{{"formula", formula}});
+			stacks.emplace_back(game, "base:item/chemical", 1, ItemData{{"formula", formula}});
 		else
 			stacks.emplace_back(game, Identifier(formula), 1);
 	}
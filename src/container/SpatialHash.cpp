@@ -0,0 +1,83 @@
+#include "container/SpatialHash.h"
+
+#include <cassert>
+
+namespace Game3 {
+	SpatialHash::SpatialHash(Index cell_size):
+		cellSize(cell_size) {
+			assert(0 < cellSize);
+		}
+
+	void SpatialHash::insert(GlobalID gid, const Position &position) {
+		if (move(gid, position))
+			return;
+
+		positions.emplace(gid, position);
+		Cell &cell = cells[getKey(position)];
+		cell.gids.push_back(gid);
+		cell.positions.push_back(position);
+	}
+
+	bool SpatialHash::move(GlobalID gid, const Position &position) {
+		auto iter = positions.find(gid);
+		if (iter == positions.end())
+			return false;
+
+		Position &old_position = iter->second;
+		const uint64_t old_key = getKey(old_position);
+		const uint64_t new_key = getKey(position);
+
+		if (old_key == new_key) {
+			Cell &cell = cells.at(old_key);
+			for (size_t i = 0; i < cell.gids.size(); ++i) {
+				if (cell.gids[i] == gid) {
+					cell.positions[i] = position;
+					break;
+				}
+			}
+		} else {
+			eraseFromCell(gid, old_position);
+			Cell &cell = cells[new_key];
+			cell.gids.push_back(gid);
+			cell.positions.push_back(position);
+		}
+
+		old_position = position;
+		return true;
+	}
+
+	bool SpatialHash::remove(GlobalID gid) {
+		auto iter = positions.find(gid);
+		if (iter == positions.end())
+			return false;
+
+		eraseFromCell(gid, iter->second);
+		positions.erase(iter);
+		return true;
+	}
+
+	void SpatialHash::clear() {
+		cells.clear();
+		positions.clear();
+	}
+
+	void SpatialHash::eraseFromCell(GlobalID gid, const Position &position) {
+		auto iter = cells.find(getKey(position));
+		if (iter == cells.end())
+			return;
+
+		Cell &cell = iter->second;
+		for (size_t i = 0; i < cell.gids.size(); ++i) {
+			if (cell.gids[i] == gid) {
+				cell.gids[i] = cell.gids.back();
+				cell.positions[i] = cell.positions.back();
+				cell.gids.pop_back();
+				cell.positions.pop_back();
+				break;
+			}
+		}
+
+		if (cell.gids.empty())
+			cells.erase(iter);
+	}
+}
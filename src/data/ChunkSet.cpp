@@ -74,7 +74,9 @@ namespace Game3 {
 
 		static_assert(sizeof(decltype(pathmap)::value_type) == 1);
 		pathmap.resize(CHUNK_SIZE * CHUNK_SIZE);
-		std::memcpy(pathmap.data(), pathmap_.data(), PATHMAP_BYTE_COUNT);
+		// Pathmaps aren't always stored; an empty span leaves a blank pathmap that needs to be remade.
+		if (!pathmap_.empty())
+			std::memcpy(pathmap.data(), pathmap_.data(), PATHMAP_BYTE_COUNT);
 	}
 
 	ChunkSet::FluidsArray ChunkSet::getFluids() const {
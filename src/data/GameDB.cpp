@@ -9,16 +9,248 @@
 #include "tileentity/TileEntity.h"
 #include "tileentity/TileEntityFactory.h"
 #include "util/Endian.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 #include "util/Util.h"
+#include "util/Zstd.h"
 
+#include <chrono>
 #include <filesystem>
+#include <future>
 #include <iomanip>
 #include <sstream>
 
 #include <nlohmann/json.hpp>
 
 namespace Game3 {
+	namespace {
+		/** Format 0 stores raw terrain, biome, fluid and pathmap bytes.
+		 *  Format 1 stores zstd-compressed terrain, biome and fluid bytes and no pathmap; pathmaps are remade on load. */
+		constexpr int CHUNK_FORMAT = 1;
+		constexpr int CHUNK_COMPRESSION_LEVEL = 3;
+
+		constexpr size_t TERRAIN_BYTE_COUNT = LAYER_COUNT * CHUNK_SIZE * CHUNK_SIZE * sizeof(TileID);
+		constexpr size_t BIOMES_BYTE_COUNT  = CHUNK_SIZE * CHUNK_SIZE * sizeof(BiomeType);
+		constexpr size_t FLUIDS_BYTE_COUNT  = CHUNK_SIZE * CHUNK_SIZE * sizeof(FluidInt);
+
+		std::span<const uint8_t> getBytes(const SQLite::Column &column) {
+			return {reinterpret_cast<const uint8_t *>(column.getBlob()), static_cast<size_t>(column.getBytes())};
+		}
+
+		std::span<const char> asChars(std::span<const uint8_t> bytes) {
+			return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+		}
+
+		std::vector<uint8_t> compressColumn(std::span<const uint8_t> raw) {
+			return compress(raw, CHUNK_COMPRESSION_LEVEL);
+		}
+
+		std::vector<uint8_t> compressColumn(const std::string &raw) {
+			return compressColumn(std::span<const uint8_t>(reinterpret_cast<const uint8_t *>(raw.data()), raw.size()));
+		}
+
+		std::vector<uint8_t> decompressColumn(const SQLite::Column &column, size_t expected_size, const char *name) {
+			std::vector<uint8_t> out = decompress8(getBytes(column));
+			if (out.size() != expected_size)
+				throw std::runtime_error("Invalid decompressed " + std::string(name) + " size: " + std::to_string(out.size()) + " (expected " + std::to_string(expected_size) + ')');
+			return out;
+		}
+
+		/** Decodes the terrain, biomes, fluids, pathmap and format columns starting at the given column index. */
+		ChunkSet readChunkSet(SQLite::Statement &query, int first_column) {
+			const int format = query.getColumn(first_column + 4).getInt();
+
+			if (format == 0) {
+				return ChunkSet{
+					asChars(getBytes(query.getColumn(first_column))),
+					asChars(getBytes(query.getColumn(first_column + 1))),
+					asChars(getBytes(query.getColumn(first_column + 2))),
+					asChars(getBytes(query.getColumn(first_column + 3)))
+				};
+			}
+
+			if (format == 1) {
+				const auto terrain = decompressColumn(query.getColumn(first_column), TERRAIN_BYTE_COUNT, "terrain");
+				const auto biomes  = decompressColumn(query.getColumn(first_column + 1), BIOMES_BYTE_COUNT, "biome");
+				const auto fluids  = decompressColumn(query.getColumn(first_column + 2), FLUIDS_BYTE_COUNT, "fluid");
+				return ChunkSet{asChars(terrain), asChars(biomes), asChars(fluids), {}};
+			}
+
+			throw std::runtime_error("Unknown chunk format: " + std::to_string(format));
+		}
+
+		constexpr const char *INSERT_CHUNK_SQL = "INSERT OR REPLACE INTO chunks (realmID, x, y, terrain, biomes, fluids, pathmap, format) VALUES (?, ?, ?, ?, ?, ?, NULL, ?)";
+		constexpr const char *INSERT_ENTITY_SQL = "INSERT OR REPLACE INTO entities VALUES (?, ?, ?, ?, ?, ?, ?)";
+		constexpr const char *INSERT_TILE_ENTITY_SQL = "INSERT OR REPLACE INTO tileEntities VALUES (?, ?, ?, ?, ?, ?, ?)";
+		constexpr const char *INSERT_USER_SQL = "INSERT OR REPLACE INTO users VALUES (?, ?, ?, ?, ?)";
+
+		/** How long an autosave waits for the tick thread to snapshot a realm before skipping the realm's entities. */
+		constexpr std::chrono::seconds SNAPSHOT_TIMEOUT{10};
+
+		/** A chunk's compressed columns along with the update counter it had when they were read. */
+		struct EncodedChunk {
+			ChunkPosition position;
+			uint64_t updateCounter = 0;
+			std::vector<uint8_t> terrain;
+			std::vector<uint8_t> biomes;
+			std::vector<uint8_t> fluids;
+		};
+
+		struct EncodedEntity {
+			GlobalID globalID = 0;
+			RealmID realmID = 0;
+			Position position;
+			std::string type;
+			int direction = 0;
+			std::vector<uint8_t> encoded;
+		};
+
+		struct EncodedTileEntity {
+			GlobalID globalID = 0;
+			RealmID realmID = 0;
+			Position position;
+			std::string tileID;
+			std::string tileEntityID;
+			std::vector<uint8_t> encoded;
+		};
+
+		struct EncodedUser {
+			std::string username;
+			std::string displayName;
+			std::string json;
+		};
+
+		/** Everything about a realm that has to be read on the tick thread. */
+		struct RealmSnapshot {
+			nlohmann::json meta;
+			std::vector<EncodedEntity> entities;
+			std::vector<EncodedTileEntity> tileEntities;
+			std::vector<EncodedUser> users;
+		};
+
+		EncodedChunk encodeChunk(TileProvider &provider, ChunkPosition chunk_position) {
+			EncodedChunk out;
+			out.position = chunk_position;
+			// Read before serializing so that changes made during the write leave the chunk dirty.
+			out.updateCounter = provider.getUpdateCounter(chunk_position);
+
+			{
+				PROFILE_ZONE("CompressTerrain");
+				out.terrain = compressColumn(provider.getRawTerrain(chunk_position));
+			}
+
+			{
+				PROFILE_ZONE("CompressBiomes");
+				out.biomes = compressColumn(provider.getRawBiomes(chunk_position));
+			}
+
+			{
+				PROFILE_ZONE("CompressFluids");
+				out.fluids = compressColumn(provider.getRawFluids(chunk_position));
+			}
+
+			return out;
+		}
+
+		EncodedEntity encodeEntity(Entity &entity) {
+			Buffer buffer;
+			entity.encode(buffer);
+			return {entity.getGID(), entity.realmID, entity.position.copyBase(), entity.type.str(), int(entity.direction.load()), std::move(buffer.bytes)};
+		}
+
+		EncodedTileEntity encodeTileEntity(TileEntity &tile_entity) {
+			Buffer buffer;
+			tile_entity.encode(tile_entity.getGame(), buffer);
+			return {tile_entity.getGID(), tile_entity.realmID, tile_entity.position.copyBase(), tile_entity.tileID.str(), tile_entity.tileEntityID.str(), std::move(buffer.bytes)};
+		}
+
+		void bindChunk(SQLite::Statement &statement, RealmID realm_id, const EncodedChunk &chunk) {
+			statement.bind(1, realm_id);
+			statement.bind(2, chunk.position.x);
+			statement.bind(3, chunk.position.y);
+			statement.bind(4, chunk.terrain.data(), static_cast<int>(chunk.terrain.size()));
+			statement.bind(5, chunk.biomes.data(), static_cast<int>(chunk.biomes.size()));
+			statement.bind(6, chunk.fluids.data(), static_cast<int>(chunk.fluids.size()));
+			statement.bind(7, CHUNK_FORMAT);
+		}
+
+		void bindEntity(SQLite::Statement &statement, const EncodedEntity &entity) {
+			statement.bind(1, std::make_signed_t<GlobalID>(entity.globalID));
+			statement.bind(2, entity.realmID);
+			statement.bind(3, entity.position.row);
+			statement.bind(4, entity.position.column);
+			statement.bind(5, entity.type);
+			statement.bind(6, entity.direction);
+			statement.bind(7, entity.encoded.data(), static_cast<int>(entity.encoded.size()));
+		}
+
+		void bindTileEntity(SQLite::Statement &statement, const EncodedTileEntity &tile_entity) {
+			statement.bind(1, std::make_signed_t<GlobalID>(tile_entity.globalID));
+			statement.bind(2, tile_entity.realmID);
+			statement.bind(3, tile_entity.position.row);
+			statement.bind(4, tile_entity.position.column);
+			statement.bind(5, tile_entity.tileID);
+			statement.bind(6, tile_entity.tileEntityID);
+			statement.bind(7, tile_entity.encoded.data(), static_cast<int>(tile_entity.encoded.size()));
+		}
+
+		void bindUser(SQLite::Statement &statement, const EncodedUser &user) {
+			statement.bind(1, user.username);
+			statement.bind(2, user.displayName);
+			statement.bind(3, user.json);
+			statement.bind(4);
+			statement.bind(5);
+		}
+
+		/** Queues a snapshot of the realm on the tick thread and waits for it. Returns nothing if the tick thread doesn't get to it in time,
+		 *  e.g. because ticking is paused. */
+		std::optional<RealmSnapshot> snapshotRealm(const RealmPtr &realm) {
+			auto promise = std::make_shared<std::promise<RealmSnapshot>>();
+			std::future<RealmSnapshot> future = promise->get_future();
+
+			realm->queue([weak = std::weak_ptr(realm), promise] {
+				RealmPtr realm = weak.lock();
+				if (!realm)
+					return;
+
+				try {
+					RealmSnapshot snapshot;
+					realm->toJSON(snapshot.meta, false);
+
+					{
+						auto lock = realm->entities.sharedLock();
+						snapshot.entities.reserve(realm->entities.size());
+						for (const EntityPtr &entity: realm->entities)
+							if (entity->shouldPersist() && !entity->isPlayer())
+								snapshot.entities.push_back(encodeEntity(*entity));
+					}
+
+					{
+						auto lock = realm->tileEntities.sharedLock();
+						snapshot.tileEntities.reserve(realm->tileEntities.size());
+						for (const auto &[position, tile_entity]: realm->tileEntities)
+							snapshot.tileEntities.push_back(encodeTileEntity(*tile_entity));
+					}
+
+					{
+						auto lock = realm->players.sharedLock();
+						for (const auto &weak_player: realm->players)
+							if (PlayerPtr player = weak_player.lock())
+								snapshot.users.push_back({player->username.copyBase(), player->displayName, nlohmann::json(*player).dump()});
+					}
+
+					promise->set_value(std::move(snapshot));
+				} catch (...) {
+					promise->set_exception(std::current_exception());
+				}
+			});
+
+			if (future.wait_for(SNAPSHOT_TIMEOUT) != std::future_status::ready)
+				return std::nullopt;
+
+			return future.get();
+		}
+	}
+
 	GameDB::GameDB(ServerGame &game_):
 		game(game_) {}
 
@@ -41,6 +273,7 @@ namespace Game3 {
 				biomes  VARBINARY(65535),
 				fluids  VARBINARY(65535),
 				pathmap VARBINARY(65535),
+				format INT DEFAULT 0,
 				PRIMARY KEY (realmID, x, y)
 			);
 
@@ -88,6 +321,61 @@ namespace Game3 {
 				value INT8
 			);
 		)");
+
+		migrateChunks();
+	}
+
+	void GameDB::migrateChunks() {
+		bool has_format = false;
+
+		{
+			SQLite::Statement query{*database, "PRAGMA table_info(chunks)"};
+			while (query.executeStep())
+				if (query.getColumn(1).getString() == "format")
+					has_format = true;
+		}
+
+		if (!has_format)
+			database->exec("ALTER TABLE chunks ADD COLUMN format INT DEFAULT 0");
+
+		SQLite::Statement count_query{*database, "SELECT COUNT(*) FROM chunks WHERE format < ?"};
+		count_query.bind(1, CHUNK_FORMAT);
+		if (!count_query.executeStep() || count_query.getColumn(0).getInt64() == 0)
+			return;
+
+		INFO("Compressing " << count_query.getColumn(0).getInt64() << " stored chunk(s)...");
+		PROFILE_ZONE("MigrateChunks");
+
+		{
+			SQLite::Transaction transaction{*database};
+			SQLite::Statement query{*database, "SELECT realmID, x, y, terrain, biomes, fluids, pathmap, format FROM chunks WHERE format < ?"};
+			SQLite::Statement update{*database, "UPDATE chunks SET terrain = ?, biomes = ?, fluids = ?, pathmap = NULL, format = ? WHERE realmID = ? AND x = ? AND y = ?"};
+
+			query.bind(1, CHUNK_FORMAT);
+
+			while (query.executeStep()) {
+				// Format 0 is the only older format, and its columns are already the raw bytes.
+				const auto terrain = compressColumn(getBytes(query.getColumn(3)));
+				const auto biomes  = compressColumn(getBytes(query.getColumn(4)));
+				const auto fluids  = compressColumn(getBytes(query.getColumn(5)));
+
+				update.bind(1, terrain.data(), static_cast<int>(terrain.size()));
+				update.bind(2, biomes.data(), static_cast<int>(biomes.size()));
+				update.bind(3, fluids.data(), static_cast<int>(fluids.size()));
+				update.bind(4, CHUNK_FORMAT);
+				update.bind(5, query.getColumn(0).getInt());
+				update.bind(6, query.getColumn(1).getInt());
+				update.bind(7, query.getColumn(2).getInt());
+				update.exec();
+				update.reset();
+			}
+
+			transaction.commit();
+		}
+
+		// Give the space freed by compression back to the filesystem.
+		database->exec("VACUUM");
+		SUCCESS("Finished compressing stored chunks.");
 	}
 
 	void GameDB::close() {
@@ -101,6 +389,99 @@ namespace Game3 {
 		writeUsers(game.players);
 	}
 
+	void GameDB::autosave() {
+		assert(database);
+		PROFILE_ZONE("Autosave");
+
+		writeRules();
+
+		std::vector<RealmPtr> realms;
+		game.iterateRealms([&](const RealmPtr &realm) {
+			realms.push_back(realm);
+		});
+
+		{
+			auto db_lock = database.uniqueLock();
+			autosaving = true;
+			deletedDuringAutosave.clear();
+		}
+
+		// Each batch gets its own transaction so that nothing else waits on the database lock for long.
+		auto write_batched = [this](const char *sql, const auto &rows, const auto &bind_row) {
+			for (size_t start = 0; start < rows.size(); start += AUTOSAVE_BATCH_SIZE) {
+				const size_t end = std::min(rows.size(), start + AUTOSAVE_BATCH_SIZE);
+				auto db_lock = database.uniqueLock();
+				SQLite::Transaction transaction{*database};
+				SQLite::Statement statement{*database, sql};
+				for (size_t i = start; i < end; ++i) {
+					if (bind_row(statement, rows[i])) {
+						statement.exec();
+						statement.reset();
+					}
+				}
+				transaction.commit();
+			}
+		};
+
+		// Writing back something that was deleted after the snapshot was taken would resurrect it.
+		auto was_deleted = [this](GlobalID global_id) {
+			return deletedDuringAutosave.contains(global_id);
+		};
+
+		for (const RealmPtr &realm: realms) {
+			std::optional<RealmSnapshot> snapshot;
+
+			try {
+				snapshot = snapshotRealm(realm);
+				if (!snapshot)
+					WARN("Realm " << realm->id << " wasn't snapshotted in time; its entities and tile entities won't be autosaved this time.");
+			} catch (const std::exception &err) {
+				ERROR("Couldn't snapshot realm " << realm->id << " for autosave: " << err.what());
+			}
+
+			if (snapshot) {
+				{
+					auto db_lock = database.uniqueLock();
+					SQLite::Transaction transaction{*database};
+					SQLite::Statement statement{*database, "INSERT OR REPLACE INTO realms VALUES (?, ?, ?)"};
+					const Tileset &tileset = realm->getTileset();
+					statement.bind(1, realm->id);
+					statement.bind(2, snapshot->meta.dump());
+					statement.bind(3, tileset.getHash());
+					statement.exec();
+					if (!hasTileset(tileset.getHash(), false))
+						writeTilesetMeta(tileset, false);
+					transaction.commit();
+				}
+
+				write_batched(INSERT_ENTITY_SQL, snapshot->entities, [&](SQLite::Statement &statement, const EncodedEntity &entity) {
+					if (was_deleted(entity.globalID))
+						return false;
+					bindEntity(statement, entity);
+					return true;
+				});
+
+				write_batched(INSERT_TILE_ENTITY_SQL, snapshot->tileEntities, [&](SQLite::Statement &statement, const EncodedTileEntity &tile_entity) {
+					if (was_deleted(tile_entity.globalID))
+						return false;
+					bindTileEntity(statement, tile_entity);
+					return true;
+				});
+
+				write_batched(INSERT_USER_SQL, snapshot->users, [](SQLite::Statement &statement, const EncodedUser &user) {
+					bindUser(statement, user);
+					return true;
+				});
+			}
+
+			writeDirtyChunks(realm);
+		}
+
+		auto db_lock = database.uniqueLock();
+		autosaving = false;
+		deletedDuringAutosave.clear();
+	}
+
 	void GameDB::readAll() {
 		readRules();
 		readAllRealms();
@@ -132,7 +513,7 @@ namespace Game3 {
 	}
 
 	void GameDB::writeAllRealms() {
-		Timer timer{"WriteAllRealms"};
+		PROFILE_ZONE("WriteAllRealms");
 		game.iterateRealms([this](const RealmPtr &realm) {
 			writeRealm(realm);
 		});
@@ -143,38 +524,37 @@ namespace Game3 {
 		SQLite::Transaction transaction{*database};
 
 		{
-			Timer timer{"WriteRealmMeta"};
+			PROFILE_ZONE("WriteRealmMeta");
 			writeRealmMeta(realm, false);
 		}
-		{
-			std::shared_lock lock(realm->tileProvider.chunkMutexes[0]);
-			for (const auto &[chunk_position, chunk]: realm->tileProvider.chunkMaps[0]) {
-				Timer timer{"WriteChunk"};
-				writeChunk(realm, chunk_position, false);
-			}
+		for (const ChunkPosition chunk_position: realm->tileProvider.getChunkPositions()) {
+			PROFILE_ZONE("WriteChunk");
+			writeChunk(realm, chunk_position, false);
 		}
 		{
-			Timer timer{"WriteTileEntities"};
+			PROFILE_ZONE("WriteTileEntities");
 			writeTileEntities(realm, false);
 		}
 		{
-			Timer timer{"WriteEntities"};
+			PROFILE_ZONE("WriteEntities");
 			writeEntities(realm, false);
 		}
 		{
-			Timer timer{"WriteTilesetMeta"};
+			PROFILE_ZONE("WriteTilesetMeta");
 			const Tileset &tileset = realm->getTileset();
 			if (!hasTileset(tileset.getHash(), false))
 				writeTilesetMeta(tileset, false);
 		}
 
-		Timer timer{"WriteRealmCommit"};
+		PROFILE_ZONE("WriteRealmCommit");
 		transaction.commit();
 	}
 
 	void GameDB::writeChunk(const RealmPtr &realm, ChunkPosition chunk_position, bool use_transaction) {
 		assert(database);
-		TileProvider &provider = realm->tileProvider;
+
+		// Compression happens before locking the database so that other threads aren't kept waiting on it.
+		const EncodedChunk chunk = encodeChunk(realm->tileProvider, chunk_position);
 
 		auto db_lock = database.uniqueLock();
 
@@ -182,102 +562,91 @@ namespace Game3 {
 		if (use_transaction)
 			transaction.emplace(*database);
 
-		SQLite::Statement statement{*database, "INSERT OR REPLACE INTO chunks VALUES (?, ?, ?, ?, ?, ?, ?)"};
-
-		std::string raw_terrain;
-		std::string raw_biomes;
-		std::string raw_fluids;
-		std::string raw_pathmap;
+		SQLite::Statement statement{*database, INSERT_CHUNK_SQL};
+		bindChunk(statement, realm->id, chunk);
 
 		{
-			Timer timer{"GetRawTerrain"};
-			raw_terrain = provider.getRawTerrain(chunk_position);
+			PROFILE_ZONE("ExecStatement");
+			statement.exec();
 		}
 
-		{
-			Timer timer{"GetRawBiomes"};
-			raw_biomes = provider.getRawBiomes(chunk_position);
+		if (transaction) {
+			PROFILE_ZONE("CommitTransaction");
+			transaction->commit();
 		}
 
-		{
-			Timer timer{"GetRawFluids"};
-			raw_fluids = provider.getRawFluids(chunk_position);
-		}
+		realm->tileProvider.markSaved(chunk_position, chunk.updateCounter);
+	}
 
-		{
-			Timer timer{"GetRawPathmap"};
-			raw_pathmap = provider.getRawPathmap(chunk_position);
-		}
+	void GameDB::writeChunks(const RealmPtr &realm, const std::vector<ChunkPosition> &chunk_positions) {
+		assert(database);
+		TileProvider &provider = realm->tileProvider;
 
-		statement.bind(1, realm->id);
-		statement.bind(2, chunk_position.x);
-		statement.bind(3, chunk_position.y);
-		{
-			Timer timer{"BindTerrain"};
-			statement.bind(4, raw_terrain);
-		}
-		{
-			Timer timer{"BindBiomes"};
-			statement.bind(5, raw_biomes);
-		}
-		{
-			Timer timer{"BindFluids"};
-			statement.bind(6, raw_fluids);
-		}
-		{
-			Timer timer{"BindPathmap"};
-			statement.bind(7, raw_pathmap);
+		std::vector<EncodedChunk> chunks;
+		chunks.reserve(chunk_positions.size());
+
+		for (const ChunkPosition chunk_position: chunk_positions) {
+			try {
+				chunks.push_back(encodeChunk(provider, chunk_position));
+			} catch (const std::out_of_range &) {
+				// The chunk was evicted after being saved elsewhere.
+			}
 		}
 
+		if (chunks.empty())
+			return;
+
 		{
-			Timer timer{"ExecStatement"};
-			statement.exec();
+			auto db_lock = database.uniqueLock();
+			SQLite::Transaction transaction{*database};
+			SQLite::Statement statement{*database, INSERT_CHUNK_SQL};
+
+			for (const EncodedChunk &chunk: chunks) {
+				bindChunk(statement, realm->id, chunk);
+				statement.exec();
+				statement.reset();
+			}
+
+			PROFILE_ZONE("WriteChunksCommit");
+			transaction.commit();
 		}
 
-		if (transaction) {
-			Timer timer{"CommitTransaction"};
-			transaction->commit();
+		for (const EncodedChunk &chunk: chunks)
+			provider.markSaved(chunk.position, chunk.updateCounter);
+	}
+
+	void GameDB::writeDirtyChunks(const RealmPtr &realm) {
+		std::vector<ChunkPosition> batch;
+		batch.reserve(AUTOSAVE_BATCH_SIZE);
+
+		for (const ChunkPosition chunk_position: realm->tileProvider.getChunkPositions()) {
+			if (!realm->tileProvider.isDirty(chunk_position))
+				continue;
+
+			batch.push_back(chunk_position);
+
+			if (batch.size() == AUTOSAVE_BATCH_SIZE) {
+				writeChunks(realm, batch);
+				batch.clear();
+			}
 		}
+
+		if (!batch.empty())
+			writeChunks(realm, batch);
 	}
 
 	void GameDB::readAllRealms() {
 		assert(database);
 		auto db_lock = database.uniqueLock();
 
-		SQLite::Statement query{*database, "SELECT * FROM chunks"};
-
-		Timer query_timer{"ExecuteStep"};
+		{
+			SQLite::Statement query{*database, "SELECT DISTINCT realmID FROM chunks"};
 
-		while (query.executeStep()) {
-			query_timer.stop();
-			{
-				Timer iteration_timer{"ChunkLoad"};
-				RealmID realm_id = query.getColumn(0);
-				ChunkPosition::IntType x = query.getColumn(1);
-				ChunkPosition::IntType y = query.getColumn(2);
-				const void *terrain = query.getColumn(3);
-				const void *biomes  = query.getColumn(4);
-				const void *fluids  = query.getColumn(5);
-				const void *pathmap = query.getColumn(6);
-				Timer chunk_set_timer{"ChunkSet"};
-				ChunkSet chunk_set{
-					std::span<const char>(reinterpret_cast<const char *>(terrain), query.getColumn(3).getBytes()),
-					std::span<const char>(reinterpret_cast<const char *>(biomes),  query.getColumn(4).getBytes()),
-					std::span<const char>(reinterpret_cast<const char *>(fluids),  query.getColumn(5).getBytes()),
-					std::span<const char>(reinterpret_cast<const char *>(pathmap), query.getColumn(6).getBytes())
-				};
-				chunk_set_timer.stop();
-				RealmPtr realm;
-				{
-					Timer get_realm_timer{"GetRealm"};
-					realm = game.getRealm(realm_id, [&] { return loadRealm(realm_id, false); });
-				}
-				{
-					Timer absorb_timer{"Absorb"};
-					realm->tileProvider.absorb(ChunkPosition(x, y), std::move(chunk_set));
-				}
+			while (query.executeStep()) {
+				const RealmID realm_id = query.getColumn(0);
+				ProfileZone get_realm_timer{PROFILE_ZONE_ID("GetRealm")};
+				game.getRealm(realm_id, [&] { return loadRealm(realm_id, false); });
 			}
-			query_timer.restart();
 		}
 
 		const bool force_migrate = std::filesystem::exists(".force-migrate");
@@ -307,7 +676,10 @@ namespace Game3 {
 
 			INFO("Auto-migrating tiles for realm " << realm->id);
 
-			Timer migration_timer{"TileMigration"};
+			// Migration rewrites every chunk, so page them all in. They'll be saved on the next write and evicted once they go unused.
+			readAllChunks(realm, false);
+
+			ProfileZone migration_timer{PROFILE_ZONE_ID("TileMigration")};
 			std::unordered_map<TileID, TileID> migration_map;
 
 			const std::unordered_map<Identifier, TileID> new_map = tileset.getIDs();
@@ -320,11 +692,9 @@ namespace Game3 {
 			std::unordered_set<TileID> covered;
 			std::unordered_set<TileID> warned;
 
-			for (const Layer layer: allLayers) {
-				std::unique_lock chunk_map_lock{provider.chunkMutexes.at(getIndex(layer))};
-				TileProvider::ChunkMap &chunk_map = provider.chunkMaps.at(getIndex(layer));
-				for (auto &[chunk_position, chunk]: chunk_map) {
-					std::unique_lock chunk_lock = chunk.uniqueLock();
+			provider.visitRecords([&](ChunkPosition, ChunkRecord &record) {
+				for (TileChunk &chunk: record.terrain) {
+					auto chunk_lock = chunk.uniqueLock();
 					for (TileID &tile_id: chunk) {
 						const TileID old_tile = tile_id;
 						if (auto iter = migration_map.find(tile_id); iter != migration_map.end()) {
@@ -349,12 +719,43 @@ namespace Game3 {
 						}
 					}
 				}
-			}
+			});
 
 			SUCCESS("Finished tile migration for realm " << realm->id);
 		});
 	}
 
+	void GameDB::readAllChunks(const RealmPtr &realm, bool do_lock) {
+		assert(database);
+
+		std::unique_lock<std::recursive_mutex> db_lock;
+		if (do_lock)
+			db_lock = database.uniqueLock();
+
+		SQLite::Statement query{*database, "SELECT x, y, terrain, biomes, fluids, pathmap, format FROM chunks WHERE realmID = ?"};
+
+		query.bind(1, realm->id);
+
+		ProfileZone query_timer{PROFILE_ZONE_ID("ExecuteStep")};
+
+		while (query.executeStep()) {
+			query_timer.stop();
+			{
+				ProfileZone iteration_timer{PROFILE_ZONE_ID("ChunkLoad")};
+				const ChunkPosition chunk_position(query.getColumn(0).getInt(), query.getColumn(1).getInt());
+				ProfileZone chunk_set_timer{PROFILE_ZONE_ID("ChunkSet")};
+				ChunkSet chunk_set = readChunkSet(query, 2);
+				chunk_set_timer.stop();
+				{
+					ProfileZone absorb_timer{PROFILE_ZONE_ID("Absorb")};
+					realm->tileProvider.absorb(chunk_position, std::move(chunk_set));
+				}
+				realm->remakePathMap(chunk_position);
+			}
+			query_timer.restart();
+		}
+	}
+
 	RealmPtr GameDB::loadRealm(RealmID realm_id, bool do_lock) {
 		assert(database);
 
@@ -483,24 +884,14 @@ namespace Game3 {
 
 		auto db_lock = database.uniqueLock();
 
-		SQLite::Statement query{*database, "SELECT terrain, biomes, fluids, pathmap FROM chunks WHERE realmID = ? AND x = ? AND y = ? LIMIT 1"};
+		SQLite::Statement query{*database, "SELECT terrain, biomes, fluids, pathmap, format FROM chunks WHERE realmID = ? AND x = ? AND y = ? LIMIT 1"};
 
 		query.bind(1, realm_id);
 		query.bind(2, chunk_position.x);
 		query.bind(3, chunk_position.y);
 
-		while (query.executeStep()) {
-			const void *terrain = query.getColumn(0);
-			const void *biomes  = query.getColumn(1);
-			const void *fluids  = query.getColumn(2);
-			const void *pathmap = query.getColumn(3);
-			return ChunkSet{
-				std::span<const char>(reinterpret_cast<const char *>(terrain), query.getColumn(0).getBytes()),
-				std::span<const char>(reinterpret_cast<const char *>(biomes),  query.getColumn(1).getBytes()),
-				std::span<const char>(reinterpret_cast<const char *>(fluids),  query.getColumn(2).getBytes()),
-				std::span<const char>(reinterpret_cast<const char *>(pathmap), query.getColumn(3).getBytes())
-			};
-		}
+		if (query.executeStep())
+			return readChunkSet(query, 0);
 
 		return std::nullopt;
 	}
@@ -622,18 +1013,10 @@ namespace Game3 {
 		if (use_transaction)
 			transaction.emplace(*database);
 
-		SQLite::Statement statement{*database, "INSERT OR REPLACE INTO tileEntities VALUES (?, ?, ?, ?, ?, ?, ?)"};
+		SQLite::Statement statement{*database, INSERT_TILE_ENTITY_SQL};
 
 		while (getter(tile_entity)) {
-			statement.bind(1, std::make_signed_t<GlobalID>(tile_entity->getGID()));
-			statement.bind(2, tile_entity->realmID);
-			statement.bind(3, tile_entity->position.row);
-			statement.bind(4, tile_entity->position.column);
-			statement.bind(5, tile_entity->tileID.str());
-			statement.bind(6, tile_entity->tileEntityID.str());
-			Buffer buffer;
-			tile_entity->encode(tile_entity->getGame(), buffer);
-			statement.bind(7, buffer.bytes.data(), buffer.bytes.size());
+			bindTileEntity(statement, encodeTileEntity(*tile_entity));
 			statement.exec();
 			statement.reset();
 		}
@@ -665,6 +1048,8 @@ namespace Game3 {
 		statement.bind(1, std::make_signed_t<GlobalID>(tile_entity->getGID()));
 		statement.exec();
 		transaction.commit();
+		if (autosaving)
+			deletedDuringAutosave.insert(tile_entity->getGID());
 	}
 
 	void GameDB::writeEntities(const std::function<bool(EntityPtr &)> &getter, bool use_transaction) {
@@ -676,20 +1061,12 @@ namespace Game3 {
 		if (use_transaction)
 			transaction.emplace(*database);
 
-		SQLite::Statement statement{*database, "INSERT OR REPLACE INTO entities VALUES (?, ?, ?, ?, ?, ?, ?)"};
+		SQLite::Statement statement{*database, INSERT_ENTITY_SQL};
 
 		while (getter(entity)) {
 			if (!entity->shouldPersist() || entity->isPlayer())
 				continue;
-			statement.bind(1, std::make_signed_t<GlobalID>(entity->getGID()));
-			statement.bind(2, entity->realmID);
-			statement.bind(3, entity->position.row);
-			statement.bind(4, entity->position.column);
-			statement.bind(5, entity->type.str());
-			statement.bind(6, int(entity->direction.load()));
-			Buffer buffer;
-			entity->encode(buffer);
-			statement.bind(7, buffer.bytes.data(), buffer.bytes.size());
+			bindEntity(statement, encodeEntity(*entity));
 			statement.exec();
 			statement.reset();
 		}
@@ -721,6 +1098,8 @@ namespace Game3 {
 		statement.bind(1, std::make_signed_t<GlobalID>(entity->getGID()));
 		statement.exec();
 		transaction.commit();
+		if (autosaving)
+			deletedDuringAutosave.insert(entity->getGID());
 	}
 
 	std::string GameDB::readRealmTilesetHash(RealmID realm_id, bool do_lock) {
@@ -1,39 +1,180 @@
 #include "data/Identifier.h"
 #include "net/Buffer.h"
 
+#include <array>
+#include <atomic>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
 #include <nlohmann/json.hpp>
 
 namespace Game3 {
-	Identifier::Identifier(std::string_view combined) {
-		const size_t colon = combined.find(':');
-		if (colon == std::string_view::npos)
-			throw std::invalid_argument("Not a valid identifier: " + std::string(combined));
-		space = std::string(combined.substr(0, colon));
-		name  = std::string(combined.substr(colon + 1));
-	}
+	namespace {
+		struct Entry {
+			std::string combined;
+			std::string space;
+			std::string name;
+		};
+
+		/** Entries live in fixed-size blocks that never move, so a handle can be resolved without locking. */
+		class IdentifierTable {
+			public:
+				constexpr static size_t BLOCK_SIZE = 1024;
+				constexpr static size_t MAX_BLOCKS = 4096;
+
+				IdentifierTable() {
+					Entry &empty = allocate();
+					empty.combined = ":";
+				}
+
+				Identifier::Handle intern(std::string_view combined) {
+					{
+						std::shared_lock lock(mutex);
+						if (auto iter = handles.find(combined); iter != handles.end())
+							return iter->second;
+					}
+
+					const size_t colon = combined.find(':');
+					if (colon == std::string_view::npos)
+						throw std::invalid_argument("Not a valid identifier: " + std::string(combined));
+
+					if (colon == 0 && combined.size() == 1)
+						return 0;
+
+					std::unique_lock lock(mutex);
+					if (auto iter = handles.find(combined); iter != handles.end())
+						return iter->second;
+
+					const auto handle = static_cast<Identifier::Handle>(count);
+					Entry &entry = allocate();
+					entry.combined = combined;
+					entry.space = combined.substr(0, colon);
+					entry.name = combined.substr(colon + 1);
+					handles.emplace(entry.combined, handle);
+					return handle;
+				}
+
+				/** Returns the handle of an identifier that's already been interned without interning anything. */
+				std::optional<Identifier::Handle> find(std::string_view combined) const {
+					if (combined == ":")
+						return 0;
+
+					std::shared_lock lock(mutex);
+					if (auto iter = handles.find(combined); iter != handles.end())
+						return iter->second;
+
+					return std::nullopt;
+				}
+
+				const Entry & operator[](Identifier::Handle handle) const {
+					return blocks[handle / BLOCK_SIZE].load(std::memory_order_acquire)[handle % BLOCK_SIZE];
+				}
+
+				size_t size() const {
+					std::shared_lock lock(mutex);
+					return count;
+				}
+
+			private:
+				mutable std::shared_mutex mutex;
+				std::array<std::atomic<Entry *>, MAX_BLOCKS> blocks{};
+				/** Keys point into the entries' combined strings. */
+				std::unordered_map<std::string_view, Identifier::Handle> handles;
+				size_t count = 0;
+
+				/** Must be called with the mutex uniquely locked (or from the constructor). */
+				Entry & allocate() {
+					const size_t block = count / BLOCK_SIZE;
+					if (block == MAX_BLOCKS)
+						throw std::length_error("Too many identifiers");
+
+					if (count % BLOCK_SIZE == 0)
+						blocks[block].store(new Entry[BLOCK_SIZE], std::memory_order_release);
+
+					return blocks[block].load(std::memory_order_relaxed)[count++ % BLOCK_SIZE];
+				}
+		};
+
+		/** Never destroyed, so identifiers stay usable during static destruction. */
+		IdentifierTable & getTable() {
+			static IdentifierTable *table = new IdentifierTable;
+			return *table;
+		}
+	}
+
+	Identifier::Identifier(std::string_view space_, std::string_view name_) {
+		std::string combined;
+		combined.reserve(space_.size() + 1 + name_.size());
+		combined += space_;
+		combined += ':';
+		combined += name_;
+		handle = getTable().intern(combined);
+	}
+
+	Identifier::Identifier(std::string_view combined):
+		handle(getTable().intern(combined)) {}
 
 	Identifier::Identifier(const char *combined):
 		Identifier(std::string_view(combined)) {}
 
+	std::optional<Identifier> Identifier::find(std::string_view combined) {
+		if (std::optional<Handle> handle = getTable().find(combined)) {
+			Identifier out;
+			out.handle = *handle;
+			return out;
+		}
+
+		return std::nullopt;
+	}
+
+	bool Identifier::empty() const {
+		if (handle == 0)
+			return true;
+		const Entry &entry = getTable()[handle];
+		if (entry.space.empty() || entry.name.empty())
+			throw std::runtime_error("Partially empty identifier");
+		return false;
+	}
+
+	const std::string & Identifier::str() const {
+		return getTable()[handle].combined;
+	}
+
+	std::string_view Identifier::getSpace() const {
+		return getTable()[handle].space;
+	}
+
+	std::string_view Identifier::getName() const {
+		return getTable()[handle].name;
+	}
+
 	std::string Identifier::getPath() const {
+		const std::string_view name = getName();
 		const auto slash = name.find_last_of('/');
-		if (slash == std::string::npos)
+		if (slash == std::string_view::npos)
 			return "";
-		return name.substr(0, slash);
+		return std::string(name.substr(0, slash));
 	}
 
 	std::string Identifier::getPathStart() const {
+		const std::string_view name = getName();
 		const auto slash = name.find('/');
-		if (slash == std::string::npos)
+		if (slash == std::string_view::npos)
 			return "";
-		return name.substr(0, slash);
+		return std::string(name.substr(0, slash));
 	}
 
 	std::string Identifier::getPostPath() const {
+		const std::string_view name = getName();
 		const auto slash = name.find_last_of('/');
-		if (slash == std::string::npos)
-			return name;
-		return name.substr(slash + 1);
+		if (slash == std::string_view::npos)
+			return std::string(name);
+		return std::string(name.substr(slash + 1));
+	}
+
+	size_t Identifier::getInternedCount() {
+		return getTable().size();
 	}
 
 	bool Identifier::operator==(const char *combined) const {
@@ -41,31 +182,24 @@ namespace Game3 {
 	}
 
 	bool Identifier::operator==(std::string_view combined) const {
-		const size_t colon = combined.find(':');
-		if (colon == std::string_view::npos)
-			return false;
-		return space == combined.substr(0, colon) && name == combined.substr(colon + 1);
-	}
-
-	bool Identifier::operator==(const Identifier &other) const {
-		return this == &other || (space == other.space && name == other.name);
+		return str() == combined;
 	}
 
 	bool Identifier::operator<(const Identifier &other) const {
-		if (this == &other)
+		if (handle == other.handle)
 			return false;
 
-		if (space < other.space)
-			return true;
+		const Entry &entry = getTable()[handle];
+		const Entry &other_entry = getTable()[other.handle];
 
-		if (space > other.space)
-			return false;
+		if (entry.space != other_entry.space)
+			return entry.space < other_entry.space;
 
-		return name < other.name;
+		return entry.name < other_entry.name;
 	}
 
 	void from_json(const nlohmann::json &json, Identifier &identifier) {
-		identifier = std::string_view(json.get<std::string>());
+		identifier = Identifier(std::string_view(json.get_ref<const std::string &>()));
 	}
 
 	void to_json(nlohmann::json &json, const Identifier &identifier) {
@@ -78,7 +212,9 @@ namespace Game3 {
 
 	template <>
 	Identifier popBuffer<Identifier>(Buffer &buffer) {
-		return {popBuffer<std::string>(buffer)};
+		Identifier out;
+		buffer >> out;
+		return out;
 	}
 
 	template <>
@@ -97,8 +233,15 @@ namespace Game3 {
 	Buffer & operator>>(Buffer &buffer, Identifier &identifier) {
 		std::string str;
 		buffer >> str;
-		identifier = std::string_view(str);
-		return buffer;
+
+		// Buffers can come from untrusted clients, and every interned identifier stays in the table forever. Anything
+		// the game knows about was interned when it was registered, so unknown identifiers are rejected.
+		if (std::optional<Identifier> found = Identifier::find(str)) {
+			identifier = *found;
+			return buffer;
+		}
+
+		throw std::invalid_argument("Unknown identifier in buffer: " + str);
 	}
 
 	std::ostream & operator<<(std::ostream &os, const Identifier &id) {
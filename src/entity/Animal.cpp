@@ -9,8 +9,6 @@
 #include "tileentity/Teleporter.h"
 
 namespace Game3 {
-	ThreadPool Animal::threadPool{2};
-
 	namespace {
 		constexpr HitPoints MAX_HEALTH = 40;
 		constexpr float RETRY_TIME = 30;
@@ -57,11 +55,6 @@ namespace Game3 {
 			timeUntilWander = *iter;
 	}
 
-	void Animal::init(Game &game) {
-		Entity::init(game);
-		threadPool.start();
-	}
-
 	void Animal::tick(Game &game, float delta) {
 		Entity::tick(game, delta);
 
@@ -80,15 +73,14 @@ namespace Game3 {
 		if (!attemptingWander.exchange(true)) {
 			increaseUpdateCounter();
 			const auto [row, column] = position.copyBase();
-			return threadPool.add([this, row = row, column = column](ThreadPool &, size_t) {
-				pathfind({
-					threadContext.random(int64_t(row    - wanderRadius), int64_t(row    + wanderRadius)),
-					threadContext.random(int64_t(column - wanderRadius), int64_t(column + wanderRadius))
-				}, 256);
-
-				timeUntilWander = getWanderDistribution()(threadContext.rng);
-				attemptingWander = false;
-			});
+			pathfindAsync({
+				threadContext.random(int64_t(row    - wanderRadius), int64_t(row    + wanderRadius)),
+				threadContext.random(int64_t(column - wanderRadius), int64_t(column + wanderRadius))
+			}, 256);
+
+			timeUntilWander = getWanderDistribution()(threadContext.rng);
+			attemptingWander = false;
+			return true;
 		}
 
 		return false;
@@ -271,6 +271,7 @@ namespace Game3 {
 			for (size_t i = inventory->count(item); i < count; ++i) {
 				std::vector<ItemStack> leftovers;
 				// std::cout << "Crafting " << ItemStack(item) << '\n';
+				auto inventory_lock = inventory->uniqueLock();
 				if (!inventory->craft(game.primaryRecipes.at(item), leftovers)) {
 					// std::cout << "Couldn't craft. Breaking.\n";
 					break;
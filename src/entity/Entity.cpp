@@ -23,6 +23,7 @@
 #include "registry/Registries.h"
 #include "ui/Canvas.h"
 #include "algorithm/AStar.h"
+#include "algorithm/PathfindingPool.h"
 #include "util/Cast.h"
 #include "util/Util.h"
 
@@ -31,6 +32,28 @@
 #include <sstream>
 
 namespace Game3 {
+	namespace {
+		void toDirections(const std::vector<Position> &positions, std::list<Direction> &out) {
+			if (positions.size() < 2)
+				return;
+
+			for (auto iter = positions.cbegin() + 1, end = positions.cend(); iter != end; ++iter) {
+				const Position &prev = *(iter - 1);
+				const Position &next = *iter;
+				if (next.row == prev.row + 1)
+					out.push_back(Direction::Down);
+				else if (next.row == prev.row - 1)
+					out.push_back(Direction::Up);
+				else if (next.column == prev.column + 1)
+					out.push_back(Direction::Right);
+				else if (next.column == prev.column - 1)
+					out.push_back(Direction::Left);
+				else
+					throw std::runtime_error("Invalid path offset: " + std::string(next - prev));
+			}
+		}
+	}
+
 	EntityTexture::EntityTexture(Identifier identifier_, Identifier texture_id, uint8_t variety_):
 		NamedRegisterable(std::move(identifier_)),
 		textureID(std::move(texture_id)),
@@ -140,17 +163,27 @@ namespace Game3 {
 	}
 
 	void Entity::tick(Game &, float delta) {
+		bool path_finished = false;
+
 		{
 			auto shared_lock = path.sharedLock();
 			if (!path.empty() && move(path.front())) {
 				// Please no data race kthx.
 				shared_lock.unlock();
 				auto unique_lock = path.uniqueLock();
-				if (!path.empty())
+				if (!path.empty()) {
 					path.pop_front();
+					path_finished = path.empty();
+				}
 			}
 		}
 
+		if (getSide() == Side::Server) {
+			if (path_finished && followWaypoint())
+				broadcastPath();
+			applyPendingPath();
+		}
+
 		auto offset_lock = offset.uniqueLock();
 
 		auto &x = offset.x;
@@ -537,6 +570,9 @@ namespace Game3 {
 	}
 
 	bool Entity::teleport(const Position &new_position, MovementContext context) {
+		if (deferFarTeleport(new_position, weakRealm.lock(), context))
+			return false;
+
 		const auto old_chunk_position = position.getChunk();
 		const bool in_different_chunk = firstTeleport || old_chunk_position != new_position.getChunk();
 		const bool is_server = getSide() == Side::Server;
@@ -579,6 +615,9 @@ namespace Game3 {
 	}
 
 	void Entity::teleport(const Position &new_position, const std::shared_ptr<Realm> &new_realm, MovementContext context) {
+		if (deferRealmChange(new_position, new_realm, context) || deferFarTeleport(new_position, new_realm, context))
+			return;
+
 		auto old_realm = weakRealm.lock();
 		RealmID limbo_id = inLimboFor.load();
 
@@ -602,6 +641,41 @@ namespace Game3 {
 		}
 	}
 
+	bool Entity::deferRealmChange(const Position &new_position, const std::shared_ptr<Realm> &new_realm, MovementContext context) {
+		if (getSide() != Side::Server || weakRealm.lock() == new_realm)
+			return false;
+
+		return getGame().toServer().deferCrossRealm([weak_self = std::weak_ptr(getSelf()), weak_realm = std::weak_ptr(new_realm), new_position, context] {
+			if (auto self = weak_self.lock())
+				if (auto realm = weak_realm.lock())
+					self->teleport(new_position, realm, context);
+		});
+	}
+
+	bool Entity::deferFarTeleport(const Position &new_position, const std::shared_ptr<Realm> &new_realm, MovementContext context) {
+		if (getSide() != Side::Server)
+			return false;
+
+		RealmPtr realm = weakRealm.lock();
+		if (!realm || !realm->isTickingChunksInParallel())
+			return false;
+
+		if (realm == new_realm) {
+			const ChunkPosition old_chunk = position.getChunk();
+			const ChunkPosition new_chunk = new_position.getChunk();
+			if (std::abs(int64_t(old_chunk.x) - new_chunk.x) <= Realm::PARALLEL_TICK_REACH && std::abs(int64_t(old_chunk.y) - new_chunk.y) <= Realm::PARALLEL_TICK_REACH)
+				return false;
+		}
+
+		realm->queue([weak_self = std::weak_ptr(getSelf()), weak_realm = std::weak_ptr(new_realm), new_position, context] {
+			if (auto self = weak_self.lock())
+				if (auto realm = weak_realm.lock())
+					self->teleport(new_position, realm, context);
+		});
+
+		return true;
+	}
+
 	Position Entity::nextTo() const {
 		switch (direction) {
 			case Direction::Up:    return {position.row - 1, position.column};
@@ -635,7 +709,7 @@ namespace Game3 {
 		if (start == goal)
 			return PathResult::Trivial;
 
-		if (!simpleAStar(getRealm(), start, goal, positions, loop_max))
+		if (!gridAStar(getRealm(), start, goal, positions, loop_max))
 			return PathResult::Unpathable;
 
 		out.clear();
@@ -644,47 +718,164 @@ namespace Game3 {
 		if (positions.size() < 2)
 			return PathResult::Trivial;
 
-		for (auto iter = positions.cbegin() + 1, end = positions.cend(); iter != end; ++iter) {
-			const Position &prev = *(iter - 1);
-			const Position &next = *iter;
-			if (next.row == prev.row + 1)
-				out.push_back(Direction::Down);
-			else if (next.row == prev.row - 1)
-				out.push_back(Direction::Up);
-			else if (next.column == prev.column + 1)
-				out.push_back(Direction::Right);
-			else if (next.column == prev.column - 1)
-				out.push_back(Direction::Left);
-			else
-				throw std::runtime_error("Invalid path offset: " + std::string(next - prev));
-		}
-
+		toDirections(positions, out);
 		pathfindGoal = goal;
 		return PathResult::Success;
 	}
 
 	bool Entity::pathfind(const Position &goal, size_t loop_max) {
-		PathResult out = PathResult::Invalid;
-		{
+		// Supersede any search still running on the pathfinding pool.
+		++pathRequestID;
+		awaitingPath = false;
+
+		if (getSide() != Side::Server) {
 			auto lock = path.uniqueLock();
-			out = pathfind(position, goal, path, loop_max);
+			const PathResult out = pathfind(position, goal, path, loop_max);
+			return out == PathResult::Trivial || out == PathResult::Success;
 		}
 
-		if (out == PathResult::Success && getSide() == Side::Server) {
-			increaseUpdateCounter();
-			auto shared = getSelf();
-			const EntitySetPathPacket packet(*this);
-			auto lock = visiblePlayers.sharedLock();
-			for (const auto &weak_player: visiblePlayers) {
-				if (auto player = weak_player.lock()) {
-					pathSeers.insert(weak_player);
-					player->toServer()->ensureEntity(shared);
-					player->send(packet);
+		return applyPath(PathfindingPool::search(getRealm(), position, goal, loop_max));
+	}
+
+	void Entity::pathfindAsync(const Position &goal, size_t loop_max) {
+		if (getSide() != Side::Server) {
+			pathfind(goal, loop_max);
+			return;
+		}
+
+		const uint64_t request_id = ++pathRequestID;
+		awaitingPath = true;
+
+		const bool requested = getGame().toServer().getPathfindingPool().request(getRealm(), position, goal, loop_max, [weak_self = std::weak_ptr<Entity>(getSelf()), request_id](const std::shared_ptr<const PathSearch> &search) {
+			if (EntityPtr self = weak_self.lock()) {
+				auto lock = self->pendingPath.uniqueLock();
+				if (self->pathRequestID == request_id) {
+					self->pendingPath.getBase() = search;
+					self->pendingPathID = request_id;
 				}
 			}
+		});
+
+		if (!requested)
+			awaitingPath = false;
+	}
+
+	void Entity::setPath(std::list<Direction> new_path, const Position &goal) {
+		++pathRequestID;
+		awaitingPath = false;
+
+		{
+			auto lock = waypoints.uniqueLock();
+			waypoints.clear();
+		}
+
+		{
+			auto lock = path.uniqueLock();
+			path.getBase() = std::move(new_path);
+		}
+
+		pathSeers.clear();
+		pathfindGoal = goal;
+
+		if (getSide() == Side::Server)
+			broadcastPath();
+	}
+
+	bool Entity::applyPath(const PathSearch &search) {
+		{
+			auto lock = waypoints.uniqueLock();
+			waypoints.assign(search.waypoints.begin(), search.waypoints.end());
+		}
+
+		if (search.result == PathResult::Trivial)
+			return true;
+
+		if (search.result != PathResult::Success)
+			return false;
+
+		{
+			auto lock = path.uniqueLock();
+			path.clear();
+			toDirections(search.positions, path);
+		}
+
+		pathSeers.clear();
+		pathfindGoal = search.goal;
+
+		if (getSide() == Side::Server)
+			broadcastPath();
+
+		return true;
+	}
+
+	void Entity::applyPendingPath() {
+		std::shared_ptr<const PathSearch> search;
+		uint64_t search_id = 0;
+
+		{
+			auto lock = pendingPath.uniqueLock();
+			if (!pendingPath)
+				return;
+			search = std::move(pendingPath.getBase());
+			pendingPath.reset();
+			search_id = pendingPathID;
+		}
+
+		if (search_id != pathRequestID)
+			return;
+
+		awaitingPath = false;
+
+		// The path is useless if the entity was moved while the search was running.
+		if (search->start == position.copyBase())
+			applyPath(*search);
+	}
+
+	bool Entity::followWaypoint() {
+		for (;;) {
+			Position waypoint;
+			Position final_goal;
+
+			{
+				auto lock = waypoints.uniqueLock();
+				if (waypoints.empty())
+					return false;
+				waypoint = waypoints.front();
+				final_goal = waypoints.back();
+				waypoints.pop_front();
+			}
+
+			PathResult result = PathResult::Invalid;
+			{
+				auto lock = path.uniqueLock();
+				result = pathfind(position, waypoint, path, PathfindingPool::LEG_LOOP_MAX);
+			}
+
+			if (result == PathResult::Success) {
+				pathfindGoal = final_goal;
+				return true;
+			}
+
+			if (result != PathResult::Trivial) {
+				auto lock = waypoints.uniqueLock();
+				waypoints.clear();
+				return false;
+			}
 		}
+	}
 
-		return out == PathResult::Trivial || out == PathResult::Success;
+	void Entity::broadcastPath() {
+		increaseUpdateCounter();
+		auto shared = getSelf();
+		const EntitySetPathPacket packet(*this);
+		auto lock = visiblePlayers.sharedLock();
+		for (const auto &weak_player: visiblePlayers) {
+			if (auto player = weak_player.lock()) {
+				pathSeers.insert(weak_player);
+				player->toServer()->ensureEntity(shared);
+				player->send(packet);
+			}
+		}
 	}
 
 	Game & Entity::getGame() {
@@ -834,7 +1025,7 @@ namespace Game3 {
 						assert(visible->getGID() != getGID());
 						visibleEntities.insert(visible);
 						if (visible->isPlayer())
-							visiblePlayers.emplace(safeDynamicCast<Player>(visible));
+							visiblePlayers.insert(safeDynamicCast<Player>(visible));
 						if (visible->otherEntityToLock != globalID) {
 							otherEntityToLock = visible->globalID;
 							{
@@ -1048,9 +1239,9 @@ namespace Game3 {
 			auto players_lock = realm->players.sharedLock();
 			auto visible_lock = visiblePlayers.uniqueLock();
 			visiblePlayers.clear();
-			std::erase_if(realm->players, [this](const std::weak_ptr<Player> &weak_player) {
+			realm->players.eraseIf([this](const std::weak_ptr<Player> &weak_player) {
 				if (std::shared_ptr<Player> player = weak_player.lock()) {
-					visiblePlayers.emplace(player);
+					visiblePlayers.insert(player);
 					return false;
 				}
 
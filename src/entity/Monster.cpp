@@ -1,4 +1,5 @@
 #include "algorithm/DamageCalculation.h"
+#include "algorithm/FlowField.h"
 #include "entity/Monster.h"
 #include "game/ServerGame.h"
 #include "realm/Realm.h"
@@ -134,6 +135,7 @@ namespace Game3 {
 	void Monster::setTarget(const std::shared_ptr<LivingEntity> &new_target) {
 		weakTarget = new_target;
 		targetGID = new_target->getGID();
+		flowField = getRealm()->getFlowField(targetGID);
 	}
 
 	bool Monster::hasTarget() {
@@ -143,6 +145,7 @@ namespace Game3 {
 	void Monster::giveUp() {
 		weakTarget.reset();
 		targetGID = -1;
+		flowField.reset();
 		timeSinceSearch = 0;
 		timeSinceAdjustment = 0;
 	}
@@ -205,11 +208,22 @@ namespace Game3 {
 
 		{
 			auto lock = path.sharedLock();
-			if (!path.empty() || !target)
+			if (!path.empty() || !target || isAwaitingPath())
 				return;
 		}
 
 		RealmPtr realm = getRealm();
+
+		// Monsters chasing the same target share one flow field instead of each searching for a path of its own.
+		if (flowField && target->getRealm() == realm) {
+			const Position target_position = target->getPosition();
+			std::list<Direction> new_path;
+			if (flowField->getPath(realm->tileProvider, target_position, getPosition(), new_path)) {
+				setPath(std::move(new_path), target_position);
+				return;
+			}
+		}
+
 		Direction facing = target->getPosition().getFacing(position);
 		if (facing == Direction::Invalid)
 			facing = Direction::Right;
@@ -217,7 +231,7 @@ namespace Game3 {
 		// First try to pathfind to the closest position that's adjacent to the player.
 		Position destination = target->getPosition() + facing;
 		if (realm->isPathable(destination)) {
-			pathfind(destination, 256);
+			pathfindAsync(destination, 256);
 			return;
 		}
 
@@ -228,7 +242,7 @@ namespace Game3 {
 
 			const Position destination = target->getPosition() + offset;
 			if (realm->isPathable(destination)) {
-				pathfind(destination, 256);
+				pathfindAsync(destination, 256);
 				return;
 			}
 		}
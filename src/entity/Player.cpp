@@ -194,6 +194,9 @@ namespace Game3 {
 	}
 
 	void Player::teleport(const Position &position, const std::shared_ptr<Realm> &new_realm, MovementContext context) {
+		if (deferRealmChange(position, new_realm, context) || deferFarTeleport(position, new_realm, context))
+			return;
+
 		auto &game = new_realm->getGame();
 
 		if ((firstTeleport || weakRealm.lock() != new_realm) && getSide() == Side::Server) {
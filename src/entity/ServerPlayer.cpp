@@ -90,6 +90,12 @@ namespace Game3 {
 		return locked;
 	}
 
+	bool ServerPlayer::send(const FramedPacket &framed) {
+		if (auto locked = weakClient.lock())
+			return locked->send(framed);
+		return false;
+	}
+
 	void ServerPlayer::handleMessage(const std::shared_ptr<Agent> &source, const std::string &name, std::any &data) {
 		assert(source);
 		if (auto *buffer = std::any_cast<Buffer>(&data))
@@ -64,6 +64,6 @@ namespace Game3 {
 
 	void Agent::onSend(const std::shared_ptr<Player> &player) {
 		auto lock = sentTo.uniqueLock();
-		sentTo.emplace(player);
+		sentTo.insert(player);
 	}
 }
@@ -31,7 +31,7 @@ namespace Game3 {
 		auto now = getTime();
 		auto difference = now - lastTime;
 		lastTime = now;
-		delta = std::chrono::duration_cast<std::chrono::nanoseconds>(difference).count() / 1e9;
+		delta = 0.f < fixedDelta? fixedDelta : std::chrono::duration_cast<std::chrono::nanoseconds>(difference).count() / 1e9;
 		time = time + delta;
 		++currentTick;
 		return true;
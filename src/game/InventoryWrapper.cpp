@@ -299,6 +299,22 @@ namespace Game3 {
 		inventory->replace(std::move(other));
 	}
 
+	void InventoryWrapper::beginTransaction() {
+		inventory->beginTransaction();
+	}
+
+	void InventoryWrapper::commit() {
+		inventory->commit();
+	}
+
+	void InventoryWrapper::rollback() {
+		inventory->rollback();
+	}
+
+	bool InventoryWrapper::inTransaction() const {
+		return inventory->inTransaction();
+	}
+
 	std::unique_lock<DefaultMutex> InventoryWrapper::uniqueLock() const {
 		return inventory->uniqueLock();
 	}
@@ -3,7 +3,7 @@
 namespace Game3 {
 	void Observable::addObserver(const std::shared_ptr<Player> &player, bool) {
 		auto lock = observers.uniqueLock();
-		observers.emplace(player);
+		observers.insert(player);
 	}
 
 	void Observable::removeObserver(const std::shared_ptr<Player> &player) {
@@ -13,8 +13,6 @@ namespace Game3 {
 
 	void Observable::cleanObservers() {
 		auto lock = observers.uniqueLock();
-		std::erase_if(observers, [](const std::weak_ptr<Player> &player) {
-			return player.expired();
-		});
+		observers.sweep();
 	}
 }
@@ -19,16 +19,31 @@
 #include "packet/TileEntityPacket.h"
 #include "packet/TileUpdatePacket.h"
 #include "packet/TimePacket.h"
+#include "threading/Waiter.h"
 #include "util/Cast.h"
 #include "util/Demangle.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 #include "util/Util.h"
 
+#include <algorithm>
+#include <array>
 #include <iomanip>
+#include <sstream>
 
 namespace Game3 {
+	namespace {
+		/** The zones reported by ServerGame::exportProfile, in the order they're reported. */
+		constexpr std::array TICK_PHASES{"TickRealm", "TickPlayers", "TickEntities", "TickTileEntities", "RandomTicks", "TickPipes", "HandlePackets", "FlushNetwork"};
+	}
+
 	ServerGame::ServerGame(const std::shared_ptr<Server> &server_, size_t pool_size):
-		weakServer(server_), pool(pool_size) { pool.start(); }
+		weakServer(server_), pool(pool_size), chunkPool(pool_size), pathfindingPool(pool_size) {
+			pool.start();
+			chunkPool.start();
+			chunkLoadPool.start();
+			pathfindingPool.start();
+			fixedDelta = tickScheduler.getPeriod().count() / 1e9;
+		}
 
 	void ServerGame::addEntityFactories() {
 		Game::addEntityFactories();
@@ -36,16 +51,37 @@ namespace Game3 {
 	}
 
 	ServerGame::~ServerGame() {
+		pathfindingPool.join();
 		pool.join();
+		chunkPool.join();
+		chunkLoadPool.join();
 		INFO("Saving realms and users...");
 		database.writeAllRealms();
 		database.writeUsers(players);
 		SUCCESS("Saved realms and users.");
-		Timer::summary();
-		Timer::clear();
+		Profiler::summary();
+		Profiler::clear();
 	}
 
 	bool ServerGame::tick() {
+		{
+			PROFILE_ZONE("Tick");
+			if (!tickProfiled())
+				return false;
+		}
+
+		// Exported once the Tick zone has closed, so that the export doesn't count toward the tick it reports on and the
+		// current tick is included in the per-tick averages.
+		lastProfileExport += delta;
+		if (const ssize_t seconds = getRule("profileExportSeconds").value_or(0); 0 < seconds && seconds <= lastProfileExport) {
+			exportProfile();
+			lastProfileExport = 0.f;
+		}
+
+		return true;
+	}
+
+	bool ServerGame::tickProfiled() {
 		if (!Game::tick())
 			return false;
 
@@ -56,19 +92,20 @@ namespace Game3 {
 			if (auto client = player->toServer()->weakClient.lock())
 				guards.emplace(player.get(), client);
 
-		for (const auto &[weak_client, packet]: packetQueue.steal())
-			if (auto client = weak_client.lock())
-				handlePacket(*client, *packet);
+		{
+			PROFILE_ZONE("HandlePackets");
+			for (const auto &[weak_client, packet]: packetQueue.steal())
+				if (auto client = weak_client.lock())
+					handlePacket(*client, *packet);
+		}
 
-		const size_t max_jobs = realms.size() * 2;
+		tickBudgets.update(*this);
 
-		for (auto &[id, realm]: realms) {
-			if (max_jobs <= pool.jobCount())
-				break;
-			// pool.add([weak_realm = std::weak_ptr(realm), delta = delta](ThreadPool &, size_t) {
-			// 	if (RealmPtr realm = weak_realm.lock())
-					realm->tick(delta);
-			// });
+		if (getRule("parallelRealmTicks").value_or(0) != 0) {
+			tickRealmsInParallel();
+		} else {
+			for (auto &[id, realm]: realms)
+				realm->tick(delta);
 		}
 
 		std::optional<TimePacket> time_packet;
@@ -78,11 +115,13 @@ namespace Game3 {
 			timeSinceTimeUpdate = 0.;
 		}
 
+		const FramedPacket framed_time = time_packet? framePacket(*this, *time_packet) : nullptr;
+
 		for (const auto &player: players) {
 			player->ticked = false;
 
-			if (time_packet)
-				player->send(*time_packet);
+			if (framed_time)
+				player->send(framed_time);
 
 			if (player->inventoryUpdated) {
 				player->send(InventoryPacket(player->getInventory(0)));
@@ -113,9 +152,75 @@ namespace Game3 {
 			lastGarbageCollection = 0.f;
 		}
 
+		lastChunkEviction += delta;
+		if (CHUNK_EVICTION_TIME <= lastChunkEviction) {
+			evictChunks();
+			lastChunkEviction = 0.f;
+		}
+
+		{
+			// Releasing the buffer guards sends everything queued for each client during the tick.
+			PROFILE_ZONE("FlushNetwork");
+			guards.clear();
+		}
+
+		tickScheduler.setMaxCatchUp(std::max<ssize_t>(0, getRule("maxCatchUpTicks").value_or(TickScheduler::DEFAULT_MAX_CATCH_UP)));
 		return true;
 	}
 
+	void ServerGame::exportProfile() {
+		Profiler::Snapshot snapshot = Profiler::snapshot();
+		const Profiler::Sample ticks = Profiler::total(PROFILE_ZONE_ID("Tick"), snapshot, lastProfile);
+
+		if (ticks.count != 0) {
+			auto per_tick = [&](const Profiler::Sample &sample) {
+				return sample.time.count() / 1e6 / ticks.count;
+			};
+
+			std::stringstream phases;
+			phases << std::fixed << std::setprecision(3);
+			for (const char *phase: TICK_PHASES)
+				phases << ' ' << phase << '=' << per_tick(Profiler::total(Profiler::intern(phase), snapshot, lastProfile));
+
+			INFO("Tick profile over " << ticks.count << " ticks (ms per tick): Tick=" << std::fixed << std::setprecision(3) << per_tick(ticks) << phases.str());
+		}
+
+		lastProfile = std::move(snapshot);
+	}
+
+	void ServerGame::tickRealmsInParallel() {
+		std::vector<RealmPtr> realms_to_tick;
+
+		{
+			auto lock = realms.sharedLock();
+			realms_to_tick.reserve(realms.size());
+			for (const auto &[id, realm]: realms)
+				realms_to_tick.push_back(realm);
+		}
+
+		Waiter waiter(realms_to_tick.size());
+		tickingRealmsInParallel = true;
+
+		for (const RealmPtr &realm: realms_to_tick) {
+			const bool added = pool.add([&waiter, realm, delta = delta](ThreadPool &, size_t) {
+				waiter.run([&] { realm->tick(delta); });
+			});
+
+			if (!added)
+				waiter.run([&] { realm->tick(delta); });
+		}
+
+		waiter.wait();
+		tickingRealmsInParallel = false;
+
+		// Operations deferred by realms that finished ticking still run if another realm threw.
+		for (const auto &function: crossRealmQueue.steal())
+			function();
+
+		// Realm tick exceptions reach the tick thread's error handling just like they do when realms tick serially.
+		waiter.rethrow();
+	}
+
 	void ServerGame::garbageCollect() {
 		auto lock = players.sharedLock();
 
@@ -126,16 +231,24 @@ namespace Game3 {
 					continue;
 			}
 			auto unique_lock = player->knownEntities.uniqueLock();
-			std::vector<std::weak_ptr<Entity>> to_remove;
-			to_remove.reserve(player->knownEntities.size() / 4);
-			for (const auto &weak_entity: player->knownEntities)
-				if (!weak_entity.lock())
-					to_remove.push_back(weak_entity);
-			for (const auto &weak_entity: to_remove)
-				player->knownEntities.erase(weak_entity);
+			player->knownEntities.sweep();
 		}
 	}
 
+	void ServerGame::evictChunks() {
+		const ssize_t seconds = getRule("chunkEvictionSeconds").value_or(DEFAULT_CHUNK_EVICTION_SECONDS);
+		if (seconds <= 0)
+			return;
+
+		size_t evicted = 0;
+		iterateRealms([&](const RealmPtr &realm) {
+			evicted += realm->evictInactiveChunks(std::chrono::seconds(seconds));
+		});
+
+		if (evicted != 0)
+			INFO("Evicted " << evicted << " inactive chunk" << (evicted == 1? "" : "s") << '.');
+	}
+
 	void ServerGame::broadcastTileUpdate(RealmID realm_id, Layer layer, const Position &position, TileID tile_id) {
 		broadcast({position, realms.at(realm_id), nullptr}, TileUpdatePacket(realm_id, layer, position, tile_id));
 	}
@@ -153,6 +266,13 @@ namespace Game3 {
 		client.send(CommandResultPacket(command_id, success, std::move(message)));
 	}
 
+	bool ServerGame::deferCrossRealm(std::function<void()> function) {
+		if (!tickingRealmsInParallel)
+			return false;
+		crossRealmQueue.push(std::move(function));
+		return true;
+	}
+
 	void ServerGame::entityChangingRealms(Entity &entity, const RealmPtr &new_realm, const Position &new_position) {
 		const EntityChangingRealmsPacket changing_packet(entity.getGID(), new_realm->id, new_position);
 		EntityMovedPacket moved_packet(entity);
@@ -179,31 +299,22 @@ namespace Game3 {
 		if (context.isTeleport)
 			packet.arguments.adjustOffset = false;
 
-		if (auto cast_player = dynamic_cast<Player *>(&entity)) {
-			if (!context.excludePlayerSelf)
-				cast_player->send(packet);
-			auto lock = players.sharedLock();
-			for (const auto &player: players)
-				if (player.get() != cast_player && player->getRealm() && player->canSee(entity))
-					if (auto client = player->toServer()->weakClient.lock())
-						client->send(packet);
-		} else {
-			auto lock = players.sharedLock();
-			for (const auto &player: players)
-				if (player->getRealm() && player->canSee(entity))
-					if (auto client = player->toServer()->weakClient.lock())
-						client->send(packet);
-		}
+		const FramedPacket framed = framePacket(*this, packet);
+		if (!framed)
+			return;
+
+		auto *cast_player = dynamic_cast<Player *>(&entity);
+		if (cast_player && !context.excludePlayerSelf)
+			cast_player->send(packet);
+
+		auto lock = players.sharedLock();
+		for (const auto &player: players)
+			if (player.get() != cast_player && player->getRealm() && player->canSee(entity))
+				player->send(framed);
 	}
 
 	void ServerGame::entityDestroyed(const Entity &entity) {
-		const DestroyEntityPacket packet(entity, false);
-		auto server = weakServer.lock();
-		assert(server);
-		auto &clients = server->getClients();
-		auto lock = clients.sharedLock();
-		for (const auto &client: clients)
-			std::static_pointer_cast<RemoteClient>(client)->send(packet);
+		broadcast(DestroyEntityPacket(entity, false), true);
 	}
 
 	void ServerGame::tileEntitySpawned(const TileEntityPtr &tile_entity) {
@@ -222,13 +333,7 @@ namespace Game3 {
 	}
 
 	void ServerGame::tileEntityDestroyed(const TileEntity &tile_entity) {
-		const DestroyTileEntityPacket packet(tile_entity);
-		auto server = weakServer.lock();
-		assert(server);
-		auto &clients = server->getClients();
-		auto lock = clients.sharedLock();
-		for (const auto &client: clients)
-			std::dynamic_pointer_cast<RemoteClient>(client)->send(packet);
+		broadcast(DestroyTileEntityPacket(tile_entity), true);
 	}
 
 	void ServerGame::remove(const ServerPlayerPtr &player) {
@@ -263,16 +368,20 @@ namespace Game3 {
 	}
 
 	void ServerGame::broadcast(const Packet &packet, bool include_non_players) {
+		const FramedPacket framed = framePacket(*this, packet);
+		if (!framed)
+			return;
+
 		if (include_non_players) {
 			std::shared_ptr<Server> server = getServer();
 			auto &clients = server->getClients();
 			auto lock = clients.sharedLock();
 			for (const RemoteClientPtr &client: clients)
-				client->send(packet);
+				client->send(framed);
 		} else {
 			auto lock = players.sharedLock();
 			for (const ServerPlayerPtr &player: players)
-				player->send(packet);
+				player->send(framed);
 		}
 	}
 
@@ -445,12 +554,12 @@ namespace Game3 {
 					player->getRealm()->remakePathMap(player->getChunk());
 
 				TileProvider &provider = player->getRealm()->tileProvider;
-				auto &path_chunk = provider.getPathChunk(player->getChunk());
-				auto lock = path_chunk.sharedLock();
+				const auto path_chunk = provider.getPathChunk(player->getChunk());
+				auto lock = path_chunk->sharedLock();
 				size_t walkables = 0;
 				for (size_t y = 0; y < CHUNK_SIZE; ++y) {
 					for (size_t x = 0; x < CHUNK_SIZE; ++x) {
-						const auto walkable = path_chunk[y * CHUNK_SIZE + x];
+						const auto walkable = (*path_chunk)[y * CHUNK_SIZE + x];
 						std::cerr << (walkable? "\u2588" : "\u2591");
 						walkables += walkable;
 					}
@@ -558,6 +667,33 @@ namespace Game3 {
 				return {true, "Unequipped items."};
 			}
 
+			if (first == "tps") {
+				const TickScheduler::Stats stats = tickScheduler.getStats();
+				std::stringstream ss;
+				ss << std::fixed << std::setprecision(2) << "TPS: " << stats.tps << ", MSPT: " << stats.mspt << " (max " << stats.maxMspt
+				   << "), overruns: " << stats.overruns << ", dropped: " << stats.dropped << " of " << stats.ticks << " ticks";
+				return {true, ss.str()};
+			}
+
+			if (first == "budgets") {
+				std::array<uint64_t, TICK_PHASE_COUNT> processed{}, starved{}, deferred{};
+				iterateRealms([&](const RealmPtr &realm) {
+					for (size_t i = 0; i < TICK_PHASE_COUNT; ++i) {
+						processed[i] += realm->tickPhaseStats[i].processed;
+						starved[i] += realm->tickPhaseStats[i].starvedTicks;
+						deferred[i] += realm->tickPhaseStats[i].deferred;
+					}
+				});
+
+				std::stringstream ss;
+				for (const TickPhase phase: ALL_TICK_PHASES) {
+					const auto i = static_cast<size_t>(phase);
+					ss << (i == 0? "" : "; ") << phase << ": " << tickBudgets.get(phase).count() << "us, " << processed[i] << " done, "
+					   << starved[i] << " starved ticks, " << deferred[i] << " deferred";
+				}
+				return {true, ss.str()};
+			}
+
 			if (first == "online") {
 				std::set<std::string> display_names;
 				{
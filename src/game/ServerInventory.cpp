@@ -39,12 +39,14 @@ namespace Game3 {
 					const ssize_t storable = ssize_t(stored.item->maxCount) - ssize_t(stored.count);
 					if (0 < storable) {
 						const ItemCount to_store = std::min(ItemCount(remaining), ItemCount(storable));
+						record(start);
 						stored.count += to_store;
 						remaining -= to_store;
 					}
 				}
 			} else {
 				const ItemCount to_store = std::min(ItemCount(stack.item->maxCount), ItemCount(remaining));
+				record(start);
 				assert(storage.try_emplace(start, stack.getGame(), stack.item, to_store, stack.data).second);
 				remaining -= to_store;
 			}
@@ -57,6 +59,7 @@ namespace Game3 {
 				const ssize_t storable = ssize_t(stored.item->maxCount) - ssize_t(stored.count);
 				if (0 < storable) {
 					const ItemCount to_store = std::min(ItemCount(remaining), ItemCount(storable));
+					record(slot);
 					stored.count += to_store;
 					remaining -= to_store;
 					if (remaining <= 0)
@@ -70,6 +73,7 @@ namespace Game3 {
 				if (storage.contains(slot) || !predicate(slot))
 					continue;
 				const ItemCount to_store = std::min(ItemCount(remaining), stack.item->maxCount);
+				record(slot);
 				storage.emplace(slot, ItemStack(stack.getGame(), stack.item, to_store, stack.data));
 				remaining -= to_store;
 				if (remaining <= 0)
@@ -119,6 +123,9 @@ namespace Game3 {
 		if (onSwap)
 			action = onSwap(*this, source, *this, destination);
 
+		record(source);
+		record(destination);
+
 		if (storage.contains(destination)) {
 			ItemStack &destination_stack = storage.at(destination);
 			if (destination_stack.canMerge(source_stack)) {
@@ -143,6 +150,7 @@ namespace Game3 {
 		std::function<void()> after;
 		if (onRemove)
 			after = onRemove(slot);
+		record(slot);
 		storage.erase(slot);
 		if (after)
 			after();
@@ -150,6 +158,8 @@ namespace Game3 {
 
 	void ServerInventory::clear() {
 		// TODO: some kind of callback?
+		for (const auto &[slot, stack]: storage)
+			record(slot);
 		storage.clear();
 	}
 
@@ -168,6 +178,7 @@ namespace Game3 {
 
 			if (stack.canMerge(stack_to_remove)) {
 				const ItemCount to_remove = std::min(stack.count, count_to_remove);
+				record(slot);
 				// The const_cast is for certain older compilers (looking at you, gcc) that constify the first argument of the function passed to std::erase_if.
 				// Such behavior doesn't comply with the C++ standard, but I want to support those compilers anyway.
 				const_cast<ItemStack &>(stack).count -= to_remove;
@@ -199,6 +210,7 @@ namespace Game3 {
 
 			if (predicate(stack, slot) && stack.canMerge(stack_to_remove)) {
 				const ItemCount to_remove = std::min(stack.count, count_to_remove);
+				record(slot);
 				// See above for the reasoning behind this const_cast.
 				const_cast<ItemStack &>(stack).count -= to_remove;
 				count_to_remove -= to_remove;
@@ -232,6 +244,7 @@ namespace Game3 {
 			return 0;
 
 		const ItemCount to_remove = std::min(stack.count, stack_to_remove.count);
+		record(slot);
 		if ((stack.count -= to_remove) == 0)
 			storage.erase(slot);
 
@@ -251,9 +264,10 @@ namespace Game3 {
 		ItemCount count_removed = 0;
 
 		for (Slot slot = 0; slot < slotCount && 0 < count_remaining; ++slot) {
-			if (auto *stack = (*this)[slot]; stack && predicate(*stack, slot) && stack->hasAttribute(attribute)) {
+			if (const ItemStack *stack = std::as_const(*this)[slot]; stack && predicate(*stack, slot) && stack->hasAttribute(attribute)) {
 				const ItemCount to_remove = std::min(stack->count, count_remaining);
-				stack->count  -= to_remove;
+				record(slot);
+				storage.at(slot).count -= to_remove;
 				count_removed += to_remove;
 				if (0 == (count_remaining -= to_remove))
 					break;
@@ -1,6 +1,8 @@
 #include "game/StorageInventory.h"
 #include "recipe/CraftingRecipe.h"
 
+#include <algorithm>
+
 namespace Game3 {
 	StorageInventory::StorageInventory(std::shared_ptr<Agent> owner, Slot slot_count, Slot active_slot, InventoryID index_, Storage storage_):
 		Inventory(std::move(owner), active_slot, index_), storage(std::move(storage_)), slotCount(slot_count) {}
@@ -33,6 +35,9 @@ namespace Game3 {
 		if (this == &other)
 			return *this;
 
+		if (transactionActive)
+			throw std::logic_error("Can't replace an inventory during a transaction");
+
 		Inventory::operator=(other);
 		auto this_lock = uniqueLock();
 		auto other_lock = other.sharedLock();
@@ -45,6 +50,9 @@ namespace Game3 {
 		if (this == &other)
 			return *this;
 
+		if (transactionActive)
+			throw std::logic_error("Can't replace an inventory during a transaction");
+
 		Inventory::operator=(std::move(other));
 		auto this_lock = uniqueLock();
 		auto other_lock = other.uniqueLock();
@@ -54,6 +62,7 @@ namespace Game3 {
 	}
 
 	ItemStack * StorageInventory::operator[](Slot slot) {
+		record(slot);
 		if (auto iter = storage.find(slot); iter != storage.end())
 			return &iter->second;
 		return nullptr;
@@ -68,6 +77,7 @@ namespace Game3 {
 	void StorageInventory::set(Slot slot, ItemStack stack) {
 		if (!hasSlot(slot))
 			throw std::out_of_range("Slot out of range: " + std::to_string(slot));
+		record(slot);
 		storage[slot] = std::move(stack);
 	}
 
@@ -87,10 +97,13 @@ namespace Game3 {
 	}
 
 	void StorageInventory::iterate(const std::function<bool(ItemStack &, Slot)> &function) {
-		for (Slot slot = 0; slot < slotCount; ++slot)
-			if (auto iter = storage.find(slot); iter != storage.end())
+		for (Slot slot = 0; slot < slotCount; ++slot) {
+			if (auto iter = storage.find(slot); iter != storage.end()) {
+				record(slot);
 				if (function(iter->second, slot))
 					return;
+			}
+		}
 	}
 
 	ItemStack * StorageInventory::firstItem(Slot *slot_out) {
@@ -101,6 +114,7 @@ namespace Game3 {
 		}
 
 		auto &[slot, stack] = *storage.begin();
+		record(slot);
 		if (slot_out)
 			*slot_out = slot;
 		return &stack;
@@ -109,6 +123,7 @@ namespace Game3 {
 	ItemStack * StorageInventory::firstItem(Slot *slot_out, const std::function<bool(const ItemStack &, Slot)> &predicate) {
 		for (auto &[slot, stack]: storage) {
 			if (predicate(stack, slot)) {
+				record(slot);
 				if (slot_out)
 					*slot_out = slot;
 				return &stack;
@@ -257,6 +272,7 @@ namespace Game3 {
 	ItemStack & StorageInventory::front() {
 		if (storage.empty())
 			throw std::out_of_range("Inventory empty");
+		record(storage.begin()->first);
 		return storage.begin()->second;
 	}
 
@@ -285,6 +301,7 @@ namespace Game3 {
 	}
 
 	ItemStack * StorageInventory::getActive() {
+		record(activeSlot);
 		if (auto iter = storage.find(activeSlot); iter != storage.end())
 			return &iter->second;
 		return nullptr;
@@ -341,14 +358,76 @@ namespace Game3 {
 		}
 	}
 
+	void StorageInventory::beginTransaction() {
+		if (transactionActive)
+			throw std::logic_error("Inventory transactions can't be nested");
+
+		transactionActive = true;
+		suppressedBeforeTransaction = suppressInventoryNotifications.exchange(true);
+		recorded.assign(std::max<Slot>(0, slotCount), false);
+	}
+
+	void StorageInventory::commit() {
+		if (!transactionActive)
+			throw std::logic_error("No inventory transaction to commit");
+
+		const bool changed = !journal.empty();
+		endTransaction();
+		if (changed)
+			notifyOwner();
+	}
+
+	void StorageInventory::rollback() {
+		if (!transactionActive)
+			throw std::logic_error("No inventory transaction to roll back");
+
+		for (auto &[slot, original]: journal) {
+			if (original)
+				storage.insert_or_assign(slot, std::move(*original));
+			else
+				storage.erase(slot);
+		}
+
+		endTransaction();
+	}
+
+	bool StorageInventory::inTransaction() const {
+		return transactionActive;
+	}
+
+	void StorageInventory::recordOriginal(Slot slot) {
+		if (slot < 0)
+			return;
+
+		if (recorded.size() <= size_t(slot))
+			recorded.resize(slot + 1, false);
+		else if (recorded[slot])
+			return;
+
+		recorded[slot] = true;
+
+		if (auto iter = storage.find(slot); iter != storage.end())
+			journal.emplace_back(slot, iter->second);
+		else
+			journal.emplace_back(slot, std::nullopt);
+	}
+
+	void StorageInventory::endTransaction() {
+		journal.clear();
+		transactionActive = false;
+		suppressInventoryNotifications = suppressedBeforeTransaction;
+	}
+
 	void StorageInventory::compact() {
 		auto lock = storage.uniqueLock();
 
 		for (auto iter = storage.begin(); iter != storage.end();) {
-			if (iter->second.count == 0)
+			if (iter->second.count == 0) {
+				record(iter->first);
 				storage.erase(iter++);
-			else
+			} else {
 				++iter;
+			}
 		}
 	}
 }
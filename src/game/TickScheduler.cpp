@@ -0,0 +1,107 @@
+#include "game/TickScheduler.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace Game3 {
+	TickScheduler::TickScheduler(std::chrono::nanoseconds period_, size_t max_catch_up):
+		period(period_), maxCatchUp(max_catch_up) {
+			recentStarts.reserve(WINDOW_SIZE);
+			recentDurations.reserve(WINDOW_SIZE);
+		}
+
+	void TickScheduler::run(const std::atomic_bool &running, const std::function<void()> &tick) {
+		Clock::time_point deadline = Clock::now();
+
+		while (running) {
+			const Clock::time_point start = Clock::now();
+			tick();
+			const Clock::time_point end = Clock::now();
+
+			deadline += period;
+			size_t dropped_ticks = 0;
+
+			if (deadline < end) {
+				// The number of ticks whose deadlines have already passed.
+				const auto behind = static_cast<size_t>((end - deadline) / period) + 1;
+				if (maxCatchUp < behind) {
+					dropped_ticks = behind - 1;
+					deadline = end;
+				}
+			}
+
+			record(start, end - start, dropped_ticks);
+
+			if (Clock::now() < deadline)
+				std::this_thread::sleep_until(deadline);
+		}
+	}
+
+	TickScheduler::Stats TickScheduler::getStats() const {
+		std::unique_lock lock(statsMutex);
+		Stats out;
+		out.ticks = ticks;
+		out.overruns = overruns;
+		out.dropped = dropped;
+
+		if (recentDurations.empty())
+			return out;
+
+		std::chrono::nanoseconds total{};
+		std::chrono::nanoseconds longest{};
+		for (const std::chrono::nanoseconds duration: recentDurations) {
+			total += duration;
+			longest = std::max(longest, duration);
+		}
+
+		out.mspt = total.count() / 1e6 / recentDurations.size();
+		out.maxMspt = longest.count() / 1e6;
+
+		if (2 <= recentStarts.size()) {
+			// The oldest entry is the one that will be overwritten next.
+			const size_t oldest = recentStarts.size() < WINDOW_SIZE? 0 : recentIndex;
+			const size_t newest = (recentIndex + recentStarts.size() - 1) % recentStarts.size();
+			const std::chrono::duration<double> span = recentStarts[newest] - recentStarts[oldest];
+			if (0 < span.count())
+				out.tps = (recentStarts.size() - 1) / span.count();
+		}
+
+		return out;
+	}
+
+	std::map<uint64_t, size_t> TickScheduler::getHistogram() const {
+		std::unique_lock lock(statsMutex);
+		return histogram;
+	}
+
+	void TickScheduler::resetStats() {
+		std::unique_lock lock(statsMutex);
+		ticks = 0;
+		overruns = 0;
+		dropped = 0;
+		histogram.clear();
+		recentStarts.clear();
+		recentDurations.clear();
+		recentIndex = 0;
+	}
+
+	void TickScheduler::record(Clock::time_point start, std::chrono::nanoseconds duration, size_t dropped_ticks) {
+		std::unique_lock lock(statsMutex);
+		++ticks;
+		dropped += dropped_ticks;
+		if (period < duration)
+			++overruns;
+
+		++histogram[duration / HISTOGRAM_BUCKET + 1];
+
+		if (recentStarts.size() < WINDOW_SIZE) {
+			recentStarts.push_back(start);
+			recentDurations.push_back(duration);
+			recentIndex = recentStarts.size() % WINDOW_SIZE;
+		} else {
+			recentStarts[recentIndex] = start;
+			recentDurations[recentIndex] = duration;
+			recentIndex = (recentIndex + 1) % WINDOW_SIZE;
+		}
+	}
+}
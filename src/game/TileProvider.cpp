@@ -4,73 +4,195 @@
 #include "util/Util.h"
 #include "util/Zstd.h"
 
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
 namespace Game3 {
+	namespace {
+		std::atomic_uint64_t nextSerial{1};
+
+		/** The records a thread looked up most recently, indexed by the low bits of their chunk coordinates so that no two
+		 *  chunks in an 8x8 area share a slot. Pathfinding, walkability checks and random ticks tend to look at many tiles in
+		 *  a few neighboring chunks in a row, so this saves most of their hash lookups and their trips through the record
+		 *  map's lock. Records are never freed before their provider, so a stale entry is harmless. */
+		struct CachedRecord {
+			uint64_t serial = 0;
+			ChunkPosition position;
+			ChunkRecord *record = nullptr;
+		};
+
+		constexpr int32_t RECORD_CACHE_WIDTH = 8;
+
+		thread_local std::array<CachedRecord, RECORD_CACHE_WIDTH * RECORD_CACHE_WIDTH> recordCache;
+
+		CachedRecord & getCachedRecord(ChunkPosition chunk_position) {
+			return recordCache[(chunk_position.x & (RECORD_CACHE_WIDTH - 1)) + (chunk_position.y & (RECORD_CACHE_WIDTH - 1)) * RECORD_CACHE_WIDTH];
+		}
+
+		void validateChunkSet(const ChunkSet &chunk_set) {
+			if (chunk_set.terrain.size() != LAYER_COUNT)
+				throw std::invalid_argument("ChunkSet has invalid number of terrain layers: " + std::to_string(chunk_set.terrain.size()));
+
+			if (chunk_set.biomes.size() != CHUNK_SIZE * CHUNK_SIZE)
+				throw std::invalid_argument("ChunkSet has invalid number of biome tiles: " + std::to_string(chunk_set.biomes.size()));
+
+			if (chunk_set.fluids.size() != CHUNK_SIZE * CHUNK_SIZE)
+				throw std::invalid_argument("ChunkSet has invalid number of fluid tiles: " + std::to_string(chunk_set.fluids.size()));
+		}
+
+		/** Moves a validated ChunkSet's data into a record. Expects the record to be uniquely locked. */
+		void storeChunkSet(ChunkRecord &record, ChunkSet &&chunk_set) {
+			for (size_t i = 0; i < LAYER_COUNT; ++i)
+				record.terrain[i] = std::move(chunk_set.terrain[i]);
+
+			record.biomes = std::move(chunk_set.biomes);
+			record.fluids = std::move(chunk_set.fluids);
+			record.pathmap = std::move(chunk_set.pathmap);
+		}
+
+		template <typename C>
+		void freeChunk(C &chunk) {
+			chunk.clear();
+			chunk.shrink_to_fit();
+		}
+
+		/** Frees all of a record's data. Expects the record to be uniquely locked. */
+		void resetRecord(ChunkRecord &record) {
+			for (TileChunk &chunk: record.terrain)
+				freeChunk(chunk);
+
+			freeChunk(record.biomes);
+			freeChunk(record.pathmap);
+			freeChunk(record.fluids);
+			record.meta.updateCount = 0;
+			record.meta.savedCount = ChunkMeta::NEVER_SAVED;
+		}
+
+		template <typename C>
+		C & requirePresent(C &chunk, const char *kind, ChunkPosition chunk_position) {
+			if (chunk.empty())
+				throw std::out_of_range("Couldn't find " + std::string(kind) + " chunk at position " + static_cast<std::string>(chunk_position));
+			return chunk;
+		}
+	}
+
+	bool ChunkRecord::isComplete() const {
+		if (biomes.empty() || pathmap.empty() || fluids.empty())
+			return false;
+		return std::ranges::none_of(terrain, [](const TileChunk &chunk) { return chunk.empty(); });
+	}
+
+	TileProvider::TileProvider():
+		serial(nextSerial++) {}
+
 	TileProvider::TileProvider(Identifier tileset_id):
-		tilesetID(std::move(tileset_id)) {}
+		tilesetID(std::move(tileset_id)),
+		serial(nextSerial++) {}
 
 	void TileProvider::clear() {
-		for (auto &map: chunkMaps)
-			map.clear();
-		biomeMap.clear();
+		for (ChunkRecord *record: getRecords()) {
+			std::unique_lock<std::shared_mutex> lock(record->mutex);
+			if (record->resident)
+				releaseRecord(*record, false);
+		}
+
+		std::unique_lock map_lock(recordMutex);
+		evictedChunks.clear();
 	}
 
 	bool TileProvider::contains(ChunkPosition chunk_position) const {
-		if (!pathMap.contains(chunk_position) || !biomeMap.contains(chunk_position))
-			return false;
-		for (const auto &map: chunkMaps)
-			if (!map.contains(chunk_position))
-				return false;
-		return true;
+		std::shared_lock<std::shared_mutex> lock;
+		const ChunkRecord *record = lockRecord(chunk_position, lock);
+		return record != nullptr && record->isComplete();
+	}
+
+	std::vector<ChunkPosition> TileProvider::getChunkPositions() const {
+		std::vector<ChunkRecord *> candidates = getRecords();
+		std::vector<ChunkPosition> out;
+		out.reserve(candidates.size());
+		for (const ChunkRecord *record: candidates) {
+			std::shared_lock<std::shared_mutex> lock(record->mutex);
+			if (record->resident && !record->terrain[0].empty())
+				out.push_back(record->position);
+		}
+		return out;
 	}
 
 	uint64_t TileProvider::updateChunk(ChunkPosition chunk_position) {
-		std::unique_lock meta_lock(metaMutex);
-		return ++metaMap[chunk_position].updateCount;
+		{
+			std::shared_lock<std::shared_mutex> lock;
+			if (ChunkRecord *record = lockRecord(chunk_position, lock))
+				return ++record->meta.updateCount;
+		}
+
+		std::unique_lock<std::shared_mutex> lock;
+		return ++lockOrCreateRecord(chunk_position, lock).meta.updateCount;
 	}
 
 	uint64_t TileProvider::getUpdateCounter(ChunkPosition chunk_position) {
-		std::shared_lock shared_lock(metaMutex);
-		if (auto iter = metaMap.find(chunk_position); iter != metaMap.end())
-			return iter->second.updateCount;
+		std::shared_lock<std::shared_mutex> lock;
+		if (const ChunkRecord *record = lockRecord(chunk_position, lock))
+			return record->meta.updateCount;
 		return 0;
 	}
 
+	bool TileProvider::isUpToDate(ChunkPosition chunk_position, uint64_t counter_threshold) {
+		return counter_threshold != 0 && contains(chunk_position) && getUpdateCounter(chunk_position) < counter_threshold;
+	}
+
 	void TileProvider::setUpdateCounter(ChunkPosition chunk_position, uint64_t counter) {
-		std::unique_lock meta_lock(metaMutex);
-		metaMap[chunk_position].updateCount = counter;
+		{
+			std::shared_lock<std::shared_mutex> lock;
+			if (ChunkRecord *record = lockRecord(chunk_position, lock)) {
+				record->meta.updateCount = counter;
+				return;
+			}
+		}
+
+		std::unique_lock<std::shared_mutex> lock;
+		lockOrCreateRecord(chunk_position, lock).meta.updateCount = counter;
 	}
 
 	void TileProvider::absorb(ChunkPosition chunk_position, ChunkSet chunk_set) {
-		if (chunk_set.terrain.size() != LAYER_COUNT)
-			throw std::invalid_argument("ChunkSet has invalid number of terrain layers in TileProvider::absorb: " + std::to_string(chunk_set.terrain.size()));
+		validateChunkSet(chunk_set);
 
-		if (chunk_set.biomes.size() != CHUNK_SIZE * CHUNK_SIZE)
-			throw std::invalid_argument("Invalid number of biome tiles in TileProvider::absorb: " + std::to_string(chunk_set.biomes.size()));
-
-		if (chunk_set.fluids.size() != CHUNK_SIZE * CHUNK_SIZE)
-			throw std::invalid_argument("Invalid number of fluid tiles in TileProvider::absorb: " + std::to_string(chunk_set.fluids.size()));
+		std::unique_lock<std::shared_mutex> lock;
+		ChunkRecord &record = lockOrCreateRecord(chunk_position, lock);
+		storeChunkSet(record, std::move(chunk_set));
+		++record.meta.updateCount;
+	}
 
-		for (size_t i = 0; i < LAYER_COUNT; ++i) {
-			std::unique_lock lock(chunkMutexes[i]);
-			chunkMaps[i][chunk_position] = std::move(chunk_set.terrain[i]);
-		}
+	bool TileProvider::ensureLoaded(ChunkPosition chunk_position) {
+		loadIfMissing(chunk_position);
+		return isLoaded(chunk_position);
+	}
 
-		{
-			std::unique_lock lock(biomeMutex);
-			biomeMap[chunk_position] = std::move(chunk_set.biomes);
-		}
+	bool TileProvider::isLoaded(ChunkPosition chunk_position) const {
+		std::shared_lock<std::shared_mutex> lock;
+		const ChunkRecord *record = lockRecord(chunk_position, lock);
+		return record != nullptr && !record->terrain[0].empty();
+	}
 
-		{
-			std::unique_lock lock(fluidMutex);
-			fluidMap[chunk_position] = std::move(chunk_set.fluids);
-		}
+	void TileProvider::evict(ChunkPosition chunk_position) {
+		std::unique_lock<std::shared_mutex> lock;
+		if (ChunkRecord *record = lockRecord(chunk_position, lock))
+			releaseRecord(*record, true);
+	}
 
-		{
-			std::unique_lock lock(pathMutex);
-			pathMap[chunk_position] = std::move(chunk_set.pathmap);
-		}
+	bool TileProvider::isDirty(ChunkPosition chunk_position) const {
+		std::shared_lock<std::shared_mutex> lock;
+		if (const ChunkRecord *record = lockRecord(chunk_position, lock))
+			return record->meta.savedCount != record->meta.updateCount;
+		return false;
+	}
 
-		updateChunk(chunk_position);
+	void TileProvider::markSaved(ChunkPosition chunk_position, uint64_t update_counter) {
+		std::shared_lock<std::shared_mutex> lock;
+		if (ChunkRecord *record = lockRecord(chunk_position, lock))
+			record->meta.savedCount = update_counter;
 	}
 
 	std::shared_ptr<Tileset> TileProvider::getTileset(const Game &game) {
@@ -88,34 +210,26 @@ namespace Game3 {
 		std::vector<Position> land_tiles;
 		land_tiles.resize((range.tileWidth() - right_pad) * (range.tileHeight() - bottom_pad));
 
-		std::shared_lock lock(chunkMutexes[0]);
-
 		size_t i = 0;
-		bool was_empty = false;
 
 		for (Index row = range.rowMin(); row <= range.rowMax() - bottom_pad; ++row)
 			for (Index column = range.columnMin(); column < range.columnMax() - right_pad; ++column)
-				if (tileset->isLand(copyTileUnsafe(Layer::Terrain, Position(row, column), was_empty, TileMode::Throw)))
+				if (tileset->isLand(copyTile(Layer::Terrain, Position(row, column), TileMode::Throw)))
 					if (auto fluid_tile = copyFluidTile(Position(row, column)); !fluid_tile || fluid_tile->level == 0)
 						land_tiles[i++] = {row, column};
 		return land_tiles;
 	}
 
 	TileID TileProvider::copyTile(Layer layer, Position position, bool &was_empty, TileMode mode) const {
-		std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-		return copyTileUnsafe(layer, position, was_empty, mode);
-	}
-
-	TileID TileProvider::copyTileUnsafe(Layer layer, Position position, bool &was_empty, TileMode mode) const {
 		was_empty = false;
 		validateLayer(layer);
 
-		const ChunkPosition chunk_position = position.getChunk();
-
-		const ChunkMap &map = chunkMaps[getIndex(layer)];
-
-		if (auto iter = map.find(chunk_position); iter != map.end())
-			return access(iter->second, remainder(position.row), remainder(position.column));
+		{
+			std::shared_lock<std::shared_mutex> lock;
+			if (const ChunkRecord *record = lockForReading(position.getChunk(), lock))
+				if (auto tile = tryAccess(record->terrain[getIndex(layer)], remainder(position.row), remainder(position.column)))
+					return *tile;
+		}
 
 		if (mode == TileMode::ReturnEmpty) {
 			was_empty = true;
@@ -135,11 +249,10 @@ namespace Game3 {
 
 		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-		const auto &map = chunkMaps[getIndex(layer)];
+		std::shared_lock<std::shared_mutex> lock;
 
-		if (auto iter = map.find(chunk_position); iter != map.end())
-			return access(iter->second, remainder(position.row), remainder(position.column));
+		if (const ChunkRecord *record = lockForReading(chunk_position, lock))
+			return tryAccess(record->terrain[getIndex(layer)], remainder(position.row), remainder(position.column));
 
 		return std::nullopt;
 	}
@@ -147,10 +260,10 @@ namespace Game3 {
 	std::optional<BiomeType> TileProvider::copyBiomeType(Position position) const {
 		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		std::shared_lock lock(biomeMutex);
+		std::shared_lock<std::shared_mutex> lock;
 
-		if (auto iter = biomeMap.find(chunk_position); iter != biomeMap.end())
-			return access(iter->second, remainder(position.row), remainder(position.column));
+		if (const ChunkRecord *record = lockForReading(chunk_position, lock))
+			return tryAccess(record->biomes, remainder(position.row), remainder(position.column));
 
 		return std::nullopt;
 	}
@@ -158,53 +271,55 @@ namespace Game3 {
 	std::optional<uint8_t> TileProvider::copyPathState(Position position) const {
 		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		std::shared_lock lock(pathMutex);
+		std::shared_lock<std::shared_mutex> lock;
 
-		if (auto iter = pathMap.find(chunk_position); iter != pathMap.end())
-			return access(iter->second, remainder(position.row), remainder(position.column));
+		if (const ChunkRecord *record = lockForReading(chunk_position, lock))
+			return tryAccess(record->pathmap, remainder(position.row), remainder(position.column));
 
 		return std::nullopt;
 	}
 
-	std::optional<FluidTile> TileProvider::copyFluidTile(Position position) const {
-		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
+	bool TileProvider::copyPathChunk(ChunkPosition chunk_position, uint8_t *out, size_t stride) const {
+		std::shared_lock<std::shared_mutex> lock;
 
-		std::shared_lock lock(fluidMutex);
+		const ChunkRecord *record = lockForReading(chunk_position, lock);
+		if (!record)
+			return false;
 
-		if (auto iter = fluidMap.find(chunk_position); iter != fluidMap.end())
-			return access(iter->second, remainder(position.row), remainder(position.column));
+		auto chunk_lock = record->pathmap.sharedLock();
+		if (record->pathmap.empty())
+			return false;
 
-		return std::nullopt;
+		for (int64_t row = 0; row < CHUNK_SIZE; ++row)
+			std::memcpy(out + row * stride, record->pathmap.data() + row * CHUNK_SIZE, CHUNK_SIZE);
+
+		return true;
 	}
 
-	ChunkSet TileProvider::getChunkSet(ChunkPosition chunk_position) const {
-		std::vector<TileChunk> terrain;
+	std::optional<FluidTile> TileProvider::copyFluidTile(Position position) const {
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		for (size_t i = 0; i < LAYER_COUNT; ++i) {
-			std::shared_lock lock(chunkMutexes[i]);
-			terrain.push_back(chunkMaps[i].at(chunk_position));
-		}
+		std::shared_lock<std::shared_mutex> lock;
 
-		BiomeChunk biomes;
+		if (const ChunkRecord *record = lockForReading(chunk_position, lock))
+			return tryAccess(record->fluids, remainder(position.row), remainder(position.column));
 
-		{
-			std::shared_lock lock(biomeMutex);
-			biomes = biomeMap.at(chunk_position);
-		}
+		return std::nullopt;
+	}
 
-		FluidChunk fluids;
+	ChunkSet TileProvider::getChunkSet(ChunkPosition chunk_position) const {
+		std::shared_lock<std::shared_mutex> lock;
+		const ChunkRecord &record = requireRecord(chunk_position, lock);
 
-		{
-			std::shared_lock lock(fluidMutex);
-			fluids = fluidMap.at(chunk_position);
-		}
+		std::vector<TileChunk> terrain;
+		terrain.reserve(LAYER_COUNT);
 
-		PathChunk pathmap;
+		for (size_t i = 0; i < LAYER_COUNT; ++i)
+			terrain.push_back(requirePresent(record.terrain[i], "tile", chunk_position));
 
-		{
-			std::shared_lock lock(pathMutex);
-			pathmap = pathMap.at(chunk_position);
-		}
+		BiomeChunk biomes = requirePresent(record.biomes, "biome", chunk_position);
+		FluidChunk fluids = requirePresent(record.fluids, "fluid", chunk_position);
+		PathChunk pathmap = requirePresent(record.pathmap, "path", chunk_position);
 
 		return {std::move(terrain), std::move(biomes), std::move(fluids), std::move(pathmap)};
 	}
@@ -213,23 +328,28 @@ namespace Game3 {
 		std::string raw;
 		raw.reserve(LAYER_COUNT * CHUNK_SIZE * CHUNK_SIZE * sizeof(TileID));
 
+		std::shared_lock<std::shared_mutex> lock;
+		const ChunkRecord &record = requireRecord(chunk_position, lock);
+
 		for (Layer layer: allLayers) {
-			std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-			const TileChunk &chunk = chunkMaps[getIndex(layer)].at(chunk_position);
+			const TileChunk &chunk = requirePresent(record.terrain[getIndex(layer)], "tile", chunk_position);
+			auto chunk_lock = chunk.sharedLock();
 			appendSpan(raw, std::span(chunk));
 		}
 
 		{
-			std::shared_lock lock(biomeMutex);
-			appendSpan(raw, std::span(biomeMap.at(chunk_position)));
+			const BiomeChunk &chunk = requirePresent(record.biomes, "biome", chunk_position);
+			auto chunk_lock = chunk.sharedLock();
+			appendSpan(raw, std::span(chunk));
 		}
 
 		{
-			std::shared_lock lock(fluidMutex);
+			const FluidChunk &chunk = requirePresent(record.fluids, "fluid", chunk_position);
 			std::vector<FluidInt> raw_fluids;
 			raw_fluids.reserve(CHUNK_SIZE * CHUNK_SIZE);
 
-			for (const FluidTile &tile: fluidMap.at(chunk_position))
+			auto chunk_lock = chunk.sharedLock();
+			for (const FluidTile &tile: chunk)
 				raw_fluids.emplace_back(tile);
 
 			appendSpan(raw, std::span(raw_fluids));
@@ -242,9 +362,12 @@ namespace Game3 {
 		std::string raw;
 		raw.reserve(LAYER_COUNT * CHUNK_SIZE * CHUNK_SIZE * sizeof(TileID));
 
+		std::shared_lock<std::shared_mutex> lock;
+		const ChunkRecord &record = requireRecord(chunk_position, lock);
+
 		for (Layer layer: allLayers) {
-			std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-			const TileChunk &chunk = chunkMaps[getIndex(layer)].at(chunk_position);
+			const TileChunk &chunk = requirePresent(record.terrain[getIndex(layer)], "tile", chunk_position);
+			auto chunk_lock = chunk.sharedLock();
 			appendSpan(raw, std::span(chunk));
 		}
 
@@ -255,8 +378,8 @@ namespace Game3 {
 		std::string raw;
 		raw.reserve(sizeof(BiomeType) * CHUNK_SIZE * CHUNK_SIZE);
 		{
-			std::shared_lock lock(biomeMutex);
-			const BiomeChunk &biome_data = biomeMap.at(chunk_position);
+			std::shared_lock<std::shared_mutex> lock;
+			const BiomeChunk &biome_data = requirePresent(requireRecord(chunk_position, lock).biomes, "biome", chunk_position);
 			auto biome_lock = biome_data.sharedLock();
 			appendSpan(raw, std::span(biome_data));
 		}
@@ -267,8 +390,8 @@ namespace Game3 {
 		std::string raw;
 		raw.reserve(sizeof(uint8_t) * CHUNK_SIZE * CHUNK_SIZE);
 		{
-			std::shared_lock lock(pathMutex);
-			const PathChunk &pathmap_data = pathMap.at(chunk_position);
+			std::shared_lock<std::shared_mutex> lock;
+			const PathChunk &pathmap_data = requirePresent(requireRecord(chunk_position, lock).pathmap, "path", chunk_position);
 			auto pathmap_lock = pathmap_data.sharedLock();
 			appendSpan(raw, std::span(pathmap_data));
 		}
@@ -281,10 +404,10 @@ namespace Game3 {
 		raw_fluids.reserve(CHUNK_SIZE * CHUNK_SIZE);
 		raw.reserve(CHUNK_SIZE * CHUNK_SIZE * sizeof(FluidInt));
 		{
-			std::shared_lock lock(fluidMutex);
-			const FluidChunk &fluid_data = fluidMap.at(chunk_position);
+			std::shared_lock<std::shared_mutex> lock;
+			const FluidChunk &fluid_data = requirePresent(requireRecord(chunk_position, lock).fluids, "fluid", chunk_position);
 			auto fluid_lock = fluid_data.sharedLock();
-			for (const FluidTile &tile: fluidMap.at(chunk_position))
+			for (const FluidTile &tile: fluid_data)
 				raw_fluids.emplace_back(tile);
 		}
 		assert(raw_fluids.size() == CHUNK_SIZE * CHUNK_SIZE);
@@ -293,379 +416,468 @@ namespace Game3 {
 		return raw;
 	}
 
-	TileID & TileProvider::findTile(Layer layer, Position position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, TileMode mode) {
+	template <typename C, typename L, typename S, typename I>
+	C * TileProvider::findChunk(ChunkPosition chunk_position, L *lock_out, bool create, bool &created, S &&select, I &&init) {
+		constexpr bool is_unique = std::is_same_v<L, std::unique_lock<std::shared_mutex>>;
 		created = false;
-		validateLayer(layer);
 
-		const ChunkPosition chunk_position {divide(position.column), divide(position.row)};
+		for (;;) {
+			{
+				L lock;
+				if (ChunkRecord *record = lockRecord(chunk_position, lock)) {
+					if (C &chunk = select(*record); !chunk.empty()) {
+						if (lock_out != nullptr)
+							*lock_out = std::move(lock);
+						return &chunk;
+					}
+				}
+			}
 
-		std::shared_mutex &mutex = chunkMutexes[getIndex(layer)];
-		std::shared_lock shared_lock(mutex);
-		ChunkMap &map = chunkMaps[getIndex(layer)];
+			if (!create) {
+				if (pageIn(chunk_position))
+					continue;
+				return nullptr;
+			}
 
-		if (auto iter = map.find(chunk_position); iter != map.end()) {
-			if (lock_out != nullptr)
-				*lock_out = std::move(shared_lock);
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+			loadIfMissing(chunk_position);
+			std::unique_lock<std::shared_mutex> lock;
+			C &chunk = select(lockOrCreateRecord(chunk_position, lock));
 
-		if (mode == TileMode::Create) {
-			created = true;
-			shared_lock.unlock();
-			std::unique_lock unique_lock(mutex);
-			TileChunk &chunk = map[chunk_position];
-			initTileChunk(layer, chunk, chunk_position);
-			TileID &accessed = access(chunk, remainder(position.row), remainder(position.column)) = 0;
+			// Another thread may have created it while we weren't holding the lock.
+			if (chunk.empty()) {
+				created = true;
+				init(chunk, chunk_position);
+			}
 
-			if (lock_out != nullptr) {
-				unique_lock.unlock();
-				shared_lock.lock();
-				*lock_out = std::move(shared_lock);
+			if constexpr (is_unique) {
+				if (lock_out != nullptr)
+					*lock_out = std::move(lock);
+				return &chunk;
+			} else if (lock_out == nullptr) {
+				return &chunk;
 			}
 
-			return accessed;
+			// A unique lock can't be downgraded, so look the chunk up again with a shared lock.
+			// If it's evicted in between, it'll be loaded or created again.
 		}
-
-		throw std::out_of_range("Couldn't find tile at " + std::string(position));
 	}
 
-	TileID & TileProvider::findTile(Layer layer, Position position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, TileMode mode) {
-		created = false;
+	TileID & TileProvider::findTile(Layer layer, Position position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, TileMode mode) {
 		validateLayer(layer);
 
-		const ChunkPosition chunk_position {divide(position.column), divide(position.row)};
-
-		std::shared_mutex &mutex = chunkMutexes[getIndex(layer)];
-		std::shared_lock shared_lock(mutex);
-		ChunkMap &map = chunkMaps[getIndex(layer)];
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		if (auto iter = map.find(chunk_position); iter != map.end()) {
-			if (lock_out != nullptr) {
-				shared_lock.unlock();
-				*lock_out = std::unique_lock(mutex);
-			}
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+		TileChunk *chunk = findChunk<TileChunk>(chunk_position, lock_out, mode == TileMode::Create, created,
+			[layer](ChunkRecord &record) -> TileChunk & { return record.terrain[getIndex(layer)]; },
+			[this, layer](TileChunk &new_chunk, ChunkPosition new_position) { initTileChunk(layer, new_chunk, new_position); });
 
-		if (mode == TileMode::Create) {
-			created = true;
-			shared_lock.unlock();
-			std::unique_lock unique_lock(mutex);
-			TileChunk &chunk = map[chunk_position];
-			initTileChunk(layer, chunk, chunk_position);
-			TileID &accessed = access(chunk, remainder(position.row), remainder(position.column)) = 0;
-			if (lock_out != nullptr)
-				*lock_out = std::move(unique_lock);
-			return accessed;
-		}
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find tile at " + std::string(position));
 
-		throw std::out_of_range("Couldn't find tile at " + std::string(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
-	BiomeType & TileProvider::findBiomeType(Position position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, BiomeMode mode) {
-		created = false;
-
-		const ChunkPosition chunk_position {divide(position.column), divide(position.row)};
-
-		std::shared_lock shared_lock(biomeMutex);
+	TileID & TileProvider::findTile(Layer layer, Position position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, TileMode mode) {
+		validateLayer(layer);
 
-		if (auto iter = biomeMap.find(chunk_position); iter != biomeMap.end()) {
-			if (lock_out != nullptr)
-				*lock_out = std::move(shared_lock);
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		if (mode == BiomeMode::Create) {
-			created = true;
-			shared_lock.unlock();
-			std::unique_lock unique_lock(biomeMutex);
-			BiomeChunk &chunk = biomeMap[chunk_position];
-			initBiomeChunk(chunk, chunk_position);
-			BiomeType &accessed = access(chunk, remainder(position.row), remainder(position.column)) = 0;
-
-			// Transfer the lock sketchily.
-			if (lock_out != nullptr) {
-				unique_lock.unlock();
-				// Yikes.
-				shared_lock.lock();
-				*lock_out = std::move(shared_lock);
-			}
+		TileChunk *chunk = findChunk<TileChunk>(chunk_position, lock_out, mode == TileMode::Create, created,
+			[layer](ChunkRecord &record) -> TileChunk & { return record.terrain[getIndex(layer)]; },
+			[this, layer](TileChunk &new_chunk, ChunkPosition new_position) { initTileChunk(layer, new_chunk, new_position); });
 
-			return accessed;
-		}
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find tile at " + std::string(position));
 
-		throw std::out_of_range("Couldn't find biome type at " + std::string(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
-	BiomeType & TileProvider::findBiomeType(Position position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, BiomeMode mode) {
-		created = false;
+	BiomeType & TileProvider::findBiomeType(Position position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, BiomeMode mode) {
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		const ChunkPosition chunk_position {divide(position.column), divide(position.row)};
+		BiomeChunk *chunk = findChunk<BiomeChunk>(chunk_position, lock_out, mode == BiomeMode::Create, created,
+			[](ChunkRecord &record) -> BiomeChunk & { return record.biomes; },
+			[this](BiomeChunk &new_chunk, ChunkPosition new_position) { initBiomeChunk(new_chunk, new_position); });
 
-		std::shared_lock shared_lock(biomeMutex);
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find biome type at " + std::string(position));
 
-		if (auto iter = biomeMap.find(chunk_position); iter != biomeMap.end()) {
-			if (lock_out != nullptr) {
-				shared_lock.unlock();
-				*lock_out = std::unique_lock(pathMutex);
-			}
+		return access(*chunk, remainder(position.row), remainder(position.column));
+	}
 
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+	BiomeType & TileProvider::findBiomeType(Position position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, BiomeMode mode) {
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		if (mode == BiomeMode::Create) {
-			created = true;
-			shared_lock.unlock();
-			std::unique_lock unique_lock(biomeMutex);
-			BiomeChunk &chunk = biomeMap[chunk_position];
-			initBiomeChunk(chunk, chunk_position);
-			BiomeType &accessed = access(chunk, remainder(position.row), remainder(position.column)) = 0;
-			if (lock_out != nullptr)
-				*lock_out = std::move(unique_lock);
-			return accessed;
-		}
+		BiomeChunk *chunk = findChunk<BiomeChunk>(chunk_position, lock_out, mode == BiomeMode::Create, created,
+			[](ChunkRecord &record) -> BiomeChunk & { return record.biomes; },
+			[this](BiomeChunk &new_chunk, ChunkPosition new_position) { initBiomeChunk(new_chunk, new_position); });
+
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find biome type at " + std::string(position));
 
-		throw std::out_of_range("Couldn't find biome type at " + std::string(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
 	uint8_t & TileProvider::findPathState(Position position, bool &created, std::shared_lock<std::shared_mutex> *lock_out, PathMode mode) {
-		created = false;
-
-		const ChunkPosition chunk_position {divide(position.column), divide(position.row)};
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-		std::shared_lock shared_lock(pathMutex);
+		PathChunk *chunk = findChunk<PathChunk>(chunk_position, lock_out, mode == PathMode::Create, created,
+			[](ChunkRecord &record) -> PathChunk & { return record.pathmap; },
+			[this](PathChunk &new_chunk, ChunkPosition new_position) { initPathChunk(new_chunk, new_position); });
 
-		if (auto iter = pathMap.find(chunk_position); iter != pathMap.end()) {
-			if (lock_out != nullptr)
-				*lock_out = std::move(shared_lock);
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find path state at " + std::string(position));
 
-		if (mode == PathMode::Create) {
-			created = true;
-			shared_lock.unlock();
-			std::unique_lock unique_lock(pathMutex);
-			PathChunk &chunk = pathMap[chunk_position];
-			initPathChunk(chunk, chunk_position);
-			uint8_t &accessed = access(chunk, remainder(position.row), remainder(position.column)) = 0;
-
-			// Transfer the lock sketchily.
-			if (lock_out != nullptr) {
-				unique_lock.unlock();
-				// Yikes.
-				shared_lock.lock();
-				*lock_out = std::move(shared_lock);
-			}
-
-			return accessed;
-		}
-
-		throw std::out_of_range("Couldn't find path state at " + std::string(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
 	uint8_t & TileProvider::findPathState(Position position, bool &created, std::unique_lock<std::shared_mutex> *lock_out, PathMode mode) {
-		created = false;
-
-		const ChunkPosition chunk_position {divide(position.column), divide(position.row)};
-
-		std::shared_lock shared_lock(pathMutex);
-
-		if (auto iter = pathMap.find(chunk_position); iter != pathMap.end()) {
-			if (lock_out != nullptr) {
-				shared_lock.unlock();
-				*lock_out = std::unique_lock(pathMutex);
-			}
+		const ChunkPosition chunk_position{divide(position.column), divide(position.row)};
 
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+		PathChunk *chunk = findChunk<PathChunk>(chunk_position, lock_out, mode == PathMode::Create, created,
+			[](ChunkRecord &record) -> PathChunk & { return record.pathmap; },
+			[this](PathChunk &new_chunk, ChunkPosition new_position) { initPathChunk(new_chunk, new_position); });
 
-		if (mode == PathMode::Create) {
-			created = true;
-			shared_lock.unlock();
-			std::unique_lock unique_lock(pathMutex);
-			PathChunk &chunk = pathMap[chunk_position];
-			initPathChunk(chunk, chunk_position);
-			uint8_t &accessed = access(chunk, remainder(position.row), remainder(position.column));
-			if (lock_out != nullptr)
-				*lock_out = std::move(unique_lock);
-			return accessed = 0;
-		}
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find path state at " + std::string(position));
 
-		throw std::out_of_range("Couldn't find path state at " + std::string(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
 	FluidTile & TileProvider::findFluid(Position position, std::shared_lock<std::shared_mutex> *lock_out, FluidMode mode) {
-		const auto chunk_position = position.getChunk();
-		std::shared_lock shared_lock(fluidMutex);
-
-		if (auto iter = fluidMap.find(chunk_position); iter != fluidMap.end()) {
-			if (lock_out != nullptr)
-				*lock_out = std::move(shared_lock);
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
-
-		if (mode == FluidMode::Create) {
-			shared_lock.unlock();
-			std::unique_lock unique_lock(fluidMutex);
-			auto &chunk = fluidMap[chunk_position];
-			initFluidChunk(chunk, chunk_position);
-			FluidTile &accessed = access(chunk, remainder(position.row), remainder(position.column)) = {0, 0};
+		bool created{};
 
-			if (lock_out != nullptr) {
-				unique_lock.unlock();
-				shared_lock.lock();
-				*lock_out = std::move(shared_lock);
-			}
+		FluidChunk *chunk = findChunk<FluidChunk>(position.getChunk(), lock_out, mode == FluidMode::Create, created,
+			[](ChunkRecord &record) -> FluidChunk & { return record.fluids; },
+			[this](FluidChunk &new_chunk, ChunkPosition new_position) { initFluidChunk(new_chunk, new_position); });
 
-			return accessed;
-		}
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find fluid tile at " + static_cast<std::string>(position));
 
-		throw std::out_of_range("Couldn't find fluid tile at " + static_cast<std::string>(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
 	FluidTile & TileProvider::findFluid(Position position, std::unique_lock<std::shared_mutex> *lock_out, FluidMode mode) {
-		const auto chunk_position = position.getChunk();
-		std::shared_lock shared_lock(fluidMutex);
+		bool created{};
 
-		if (auto iter = fluidMap.find(chunk_position); iter != fluidMap.end()) {
-			if (lock_out != nullptr) {
-				shared_lock.unlock();
-				*lock_out = std::unique_lock(fluidMutex);
-			}
-			return access(iter->second, remainder(position.row), remainder(position.column));
-		}
+		FluidChunk *chunk = findChunk<FluidChunk>(position.getChunk(), lock_out, mode == FluidMode::Create, created,
+			[](ChunkRecord &record) -> FluidChunk & { return record.fluids; },
+			[this](FluidChunk &new_chunk, ChunkPosition new_position) { initFluidChunk(new_chunk, new_position); });
 
-		if (mode == FluidMode::Create) {
-			shared_lock.unlock();
-			std::unique_lock unique_lock(fluidMutex);
-			auto &chunk = fluidMap[chunk_position];
-			initFluidChunk(chunk, chunk_position);
-			FluidTile &accessed = access(chunk, remainder(position.row), remainder(position.column)) = {0, 0};
-			if (lock_out != nullptr)
-				*lock_out = std::move(unique_lock);
-			return accessed;
-		}
+		if (chunk == nullptr)
+			throw std::out_of_range("Couldn't find fluid tile at " + static_cast<std::string>(position));
 
-		throw std::out_of_range("Couldn't find fluid tile at " + static_cast<std::string>(position));
+		return access(*chunk, remainder(position.row), remainder(position.column));
 	}
 
-	const TileChunk & TileProvider::getTileChunk(Layer layer, ChunkPosition chunk_position) const {
+	ChunkHandle<const TileChunk> TileProvider::getTileChunk(Layer layer, ChunkPosition chunk_position) const {
 		validateLayer(layer);
-
-		std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-		if (auto iter = chunkMaps[getIndex(layer)].find(chunk_position); iter != chunkMaps[getIndex(layer)].end())
-			return iter->second;
-
-		throw std::out_of_range("Couldn't find tile chunk at position " + static_cast<std::string>(chunk_position));
+		std::shared_lock<std::shared_mutex> lock;
+		const TileChunk &chunk = requirePresent(requireRecord(chunk_position, lock).terrain[getIndex(layer)], "tile", chunk_position);
+		return {std::move(lock), chunk};
 	}
 
-	TileChunk & TileProvider::getTileChunk(Layer layer, ChunkPosition chunk_position) {
+	ChunkHandle<TileChunk> TileProvider::getTileChunk(Layer layer, ChunkPosition chunk_position) {
 		validateLayer(layer);
-		ensureTileChunk(chunk_position, layer);
-		std::unique_lock lock(chunkMutexes[getIndex(layer)]);
-		return chunkMaps[getIndex(layer)][chunk_position];
+		bool created{};
+		std::shared_lock<std::shared_mutex> lock;
+		TileChunk *chunk = findChunk<TileChunk>(chunk_position, &lock, true, created,
+			[layer](ChunkRecord &record) -> TileChunk & { return record.terrain[getIndex(layer)]; },
+			[this, layer](TileChunk &new_chunk, ChunkPosition new_position) { initTileChunk(layer, new_chunk, new_position); });
+		return {std::move(lock), *chunk};
 	}
 
-	std::optional<std::reference_wrapper<const TileChunk>> TileProvider::tryTileChunk(Layer layer, ChunkPosition chunk_position) const {
-		std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-		if (auto iter = chunkMaps[getIndex(layer)].find(chunk_position); iter != chunkMaps[getIndex(layer)].end())
-			return std::ref(iter->second);
+	std::optional<ChunkHandle<const TileChunk>> TileProvider::tryTileChunk(Layer layer, ChunkPosition chunk_position) const {
+		validateLayer(layer);
+		std::shared_lock<std::shared_mutex> lock;
+		if (const ChunkRecord *record = lockForReading(chunk_position, lock); record != nullptr && !record->terrain[getIndex(layer)].empty())
+			return ChunkHandle<const TileChunk>(std::move(lock), record->terrain[getIndex(layer)]);
 		return std::nullopt;
 	}
 
-	std::optional<std::reference_wrapper<TileChunk>> TileProvider::tryTileChunk(Layer layer, ChunkPosition chunk_position) {
-		std::shared_lock lock(chunkMutexes[getIndex(layer)]);
-		if (auto iter = chunkMaps[getIndex(layer)].find(chunk_position); iter != chunkMaps[getIndex(layer)].end())
-			return std::ref(iter->second);
+	std::optional<ChunkHandle<TileChunk>> TileProvider::tryTileChunk(Layer layer, ChunkPosition chunk_position) {
+		validateLayer(layer);
+		pageIn(chunk_position);
+		std::shared_lock<std::shared_mutex> lock;
+		if (ChunkRecord *record = lockRecord(chunk_position, lock); record != nullptr && !record->terrain[getIndex(layer)].empty())
+			return ChunkHandle<TileChunk>(std::move(lock), record->terrain[getIndex(layer)]);
 		return std::nullopt;
 	}
 
-	const Chunk<BiomeType> & TileProvider::getBiomeChunk(ChunkPosition chunk_position) const {
-		std::shared_lock lock(biomeMutex);
-		if (auto iter = biomeMap.find(chunk_position); iter != biomeMap.end())
-			return iter->second;
-
-		throw std::out_of_range("Couldn't find biome chunk at position " + static_cast<std::string>(chunk_position));
+	ChunkHandle<const BiomeChunk> TileProvider::getBiomeChunk(ChunkPosition chunk_position) const {
+		std::shared_lock<std::shared_mutex> lock;
+		const BiomeChunk &chunk = requirePresent(requireRecord(chunk_position, lock).biomes, "biome", chunk_position);
+		return {std::move(lock), chunk};
 	}
 
-	Chunk<BiomeType> & TileProvider::getBiomeChunk(ChunkPosition chunk_position) {
-		ensureBiomeChunk(chunk_position);
-		std::unique_lock lock(biomeMutex);
-		return biomeMap[chunk_position];
+	ChunkHandle<BiomeChunk> TileProvider::getBiomeChunk(ChunkPosition chunk_position) {
+		bool created{};
+		std::shared_lock<std::shared_mutex> lock;
+		BiomeChunk *chunk = findChunk<BiomeChunk>(chunk_position, &lock, true, created,
+			[](ChunkRecord &record) -> BiomeChunk & { return record.biomes; },
+			[this](BiomeChunk &new_chunk, ChunkPosition new_position) { initBiomeChunk(new_chunk, new_position); });
+		return {std::move(lock), *chunk};
 	}
 
-	const Chunk<uint8_t> & TileProvider::getPathChunk(ChunkPosition chunk_position) const {
-		std::shared_lock lock(pathMutex);
-		if (auto iter = pathMap.find(chunk_position); iter != pathMap.end())
-			return iter->second;
-
-		throw std::out_of_range("Couldn't find path chunk at position " + static_cast<std::string>(chunk_position));
+	ChunkHandle<const PathChunk> TileProvider::getPathChunk(ChunkPosition chunk_position) const {
+		std::shared_lock<std::shared_mutex> lock;
+		const PathChunk &chunk = requirePresent(requireRecord(chunk_position, lock).pathmap, "path", chunk_position);
+		return {std::move(lock), chunk};
 	}
 
-	Chunk<uint8_t> & TileProvider::getPathChunk(ChunkPosition chunk_position) {
-		ensurePathChunk(chunk_position);
-		std::unique_lock lock(pathMutex);
-		return pathMap[chunk_position];
+	ChunkHandle<PathChunk> TileProvider::getPathChunk(ChunkPosition chunk_position) {
+		bool created{};
+		std::shared_lock<std::shared_mutex> lock;
+		PathChunk *chunk = findChunk<PathChunk>(chunk_position, &lock, true, created,
+			[](ChunkRecord &record) -> PathChunk & { return record.pathmap; },
+			[this](PathChunk &new_chunk, ChunkPosition new_position) { initPathChunk(new_chunk, new_position); });
+		return {std::move(lock), *chunk};
 	}
 
-	const Chunk<FluidTile> & TileProvider::getFluidChunk(ChunkPosition chunk_position) const {
-		std::shared_lock lock(fluidMutex);
-		if (auto iter = fluidMap.find(chunk_position); iter != fluidMap.end())
-			return iter->second;
-
-		throw std::out_of_range("Couldn't find fluid chunk at position " + static_cast<std::string>(chunk_position));
+	ChunkHandle<const FluidChunk> TileProvider::getFluidChunk(ChunkPosition chunk_position) const {
+		std::shared_lock<std::shared_mutex> lock;
+		const FluidChunk &chunk = requirePresent(requireRecord(chunk_position, lock).fluids, "fluid", chunk_position);
+		return {std::move(lock), chunk};
 	}
 
-	Chunk<FluidTile> & TileProvider::getFluidChunk(ChunkPosition chunk_position) {
-		ensureFluidChunk(chunk_position);
-		std::unique_lock lock(fluidMutex);
-		return fluidMap[chunk_position];
+	ChunkHandle<FluidChunk> TileProvider::getFluidChunk(ChunkPosition chunk_position) {
+		bool created{};
+		std::shared_lock<std::shared_mutex> lock;
+		FluidChunk *chunk = findChunk<FluidChunk>(chunk_position, &lock, true, created,
+			[](ChunkRecord &record) -> FluidChunk & { return record.fluids; },
+			[this](FluidChunk &new_chunk, ChunkPosition new_position) { initFluidChunk(new_chunk, new_position); });
+		return {std::move(lock), *chunk};
 	}
 
 	void TileProvider::ensureTileChunk(ChunkPosition chunk_position) {
-		for (const auto layer: allLayers) {
-			std::unique_lock lock(chunkMutexes[getIndex(layer)]);
-			if (auto [iter, inserted] = chunkMaps[getIndex(layer)].try_emplace(chunk_position); inserted)
-				initTileChunk(layer, iter->second, chunk_position);
-		}
+		loadIfMissing(chunk_position);
+		std::unique_lock<std::shared_mutex> lock;
+		ChunkRecord &record = lockOrCreateRecord(chunk_position, lock);
+		for (const auto layer: allLayers)
+			if (TileChunk &chunk = record.terrain[getIndex(layer)]; chunk.empty())
+				initTileChunk(layer, chunk, chunk_position);
 	}
 
 	void TileProvider::ensureTileChunk(ChunkPosition chunk_position, Layer layer) {
 		validateLayer(layer);
-		std::unique_lock lock(chunkMutexes[getIndex(layer)]);
-		if (auto [iter, inserted] = chunkMaps[getIndex(layer)].try_emplace(chunk_position); inserted)
-			initTileChunk(layer, iter->second, chunk_position);
+		loadIfMissing(chunk_position);
+		std::unique_lock<std::shared_mutex> lock;
+		if (TileChunk &chunk = lockOrCreateRecord(chunk_position, lock).terrain[getIndex(layer)]; chunk.empty())
+			initTileChunk(layer, chunk, chunk_position);
 	}
 
 	void TileProvider::ensureBiomeChunk(ChunkPosition chunk_position) {
-		std::unique_lock lock(biomeMutex);
-		if (auto [iter, inserted] = biomeMap.try_emplace(chunk_position); inserted)
-			initBiomeChunk(iter->second, chunk_position);
+		loadIfMissing(chunk_position);
+		std::unique_lock<std::shared_mutex> lock;
+		if (BiomeChunk &chunk = lockOrCreateRecord(chunk_position, lock).biomes; chunk.empty())
+			initBiomeChunk(chunk, chunk_position);
 	}
 
 	void TileProvider::ensurePathChunk(ChunkPosition chunk_position) {
-		std::unique_lock lock(pathMutex);
-		if (auto [iter, inserted] = pathMap.try_emplace(chunk_position); inserted)
-			initPathChunk(iter->second, chunk_position);
+		loadIfMissing(chunk_position);
+		std::unique_lock<std::shared_mutex> lock;
+		if (PathChunk &chunk = lockOrCreateRecord(chunk_position, lock).pathmap; chunk.empty())
+			initPathChunk(chunk, chunk_position);
 	}
 
 	void TileProvider::ensureFluidChunk(ChunkPosition chunk_position) {
-		std::unique_lock lock(fluidMutex);
-		if (auto [iter, inserted] = fluidMap.try_emplace(chunk_position); inserted)
-			initFluidChunk(iter->second, chunk_position);
+		loadIfMissing(chunk_position);
+		std::unique_lock<std::shared_mutex> lock;
+		if (FluidChunk &chunk = lockOrCreateRecord(chunk_position, lock).fluids; chunk.empty())
+			initFluidChunk(chunk, chunk_position);
 	}
 
 	void TileProvider::ensureAllChunks(ChunkPosition chunk_position) {
-		ensurePathChunk(chunk_position);
-		ensureBiomeChunk(chunk_position);
-		ensureTileChunk(chunk_position);
-		ensureFluidChunk(chunk_position);
+		{
+			std::shared_lock<std::shared_mutex> lock;
+			if (const ChunkRecord *record = lockRecord(chunk_position, lock); record != nullptr && record->isComplete())
+				return;
+		}
+
+		loadIfMissing(chunk_position);
+		std::unique_lock<std::shared_mutex> lock;
+		ChunkRecord &record = lockOrCreateRecord(chunk_position, lock);
+
+		if (record.pathmap.empty())
+			initPathChunk(record.pathmap, chunk_position);
+
+		if (record.biomes.empty())
+			initBiomeChunk(record.biomes, chunk_position);
+
+		for (const auto layer: allLayers)
+			if (TileChunk &chunk = record.terrain[getIndex(layer)]; chunk.empty())
+				initTileChunk(layer, chunk, chunk_position);
+
+		if (record.fluids.empty())
+			initFluidChunk(record.fluids, chunk_position);
 	}
 
 	void TileProvider::ensureAllChunks(Position position) {
 		ensureAllChunks(position.getChunk());
 	}
 
+	bool TileProvider::loadIfMissing(ChunkPosition chunk_position) {
+		{
+			std::shared_lock<std::shared_mutex> lock;
+			if (const ChunkRecord *record = lockRecord(chunk_position, lock); record != nullptr && !record->terrain[0].empty())
+				return true;
+		}
+
+		if (!chunkLoader)
+			return false;
+
+		std::optional<ChunkSet> chunk_set = chunkLoader(chunk_position);
+		if (!chunk_set)
+			return false;
+
+		storeLoaded(chunk_position, std::move(*chunk_set));
+		return true;
+	}
+
+	bool TileProvider::storeLoaded(ChunkPosition chunk_position, ChunkSet chunk_set) {
+		validateChunkSet(chunk_set);
+
+		{
+			std::unique_lock<std::shared_mutex> lock;
+			ChunkRecord &record = lockOrCreateRecord(chunk_position, lock);
+
+			// Another thread may have loaded or created the chunk while the loader was running.
+			if (!record.terrain[0].empty())
+				return false;
+
+			storeChunkSet(record, std::move(chunk_set));
+			record.meta.savedCount = ++record.meta.updateCount;
+
+			std::unique_lock map_lock(recordMutex);
+			evictedChunks.erase(chunk_position);
+		}
+
+		if (onChunkLoaded)
+			onChunkLoaded(chunk_position);
+
+		return true;
+	}
+
+	bool TileProvider::pageIn(ChunkPosition chunk_position) const {
+		{
+			std::shared_lock map_lock(recordMutex);
+			if (!evictedChunks.contains(chunk_position))
+				return false;
+		}
+
+		return const_cast<TileProvider &>(*this).loadIfMissing(chunk_position);
+	}
+
+	ChunkRecord * TileProvider::findRecord(ChunkPosition chunk_position) const {
+		CachedRecord &cached = getCachedRecord(chunk_position);
+
+		if (cached.record != nullptr && cached.serial == serial && cached.position == chunk_position)
+			return cached.record;
+
+		std::shared_lock lock(recordMutex);
+
+		if (auto iter = records.find(chunk_position); iter != records.end()) {
+			cached = {serial, chunk_position, iter->second};
+			return iter->second;
+		}
+
+		return nullptr;
+	}
+
+	template <typename L>
+	ChunkRecord * TileProvider::lockRecord(ChunkPosition chunk_position, L &lock) const {
+		for (;;) {
+			ChunkRecord *record = findRecord(chunk_position);
+			if (record == nullptr)
+				return nullptr;
+
+			lock = L(record->mutex);
+			if (record->resident && record->position == chunk_position)
+				return record;
+
+			// The record was evicted (and possibly reused) after it was found. Forget it and look again.
+			lock.unlock();
+			getCachedRecord(chunk_position).record = nullptr;
+		}
+	}
+
+	const ChunkRecord * TileProvider::lockForReading(ChunkPosition chunk_position, std::shared_lock<std::shared_mutex> &lock) const {
+		if (const ChunkRecord *record = lockRecord(chunk_position, lock); record != nullptr && !record->terrain[0].empty())
+			return record;
+
+		if (lock.owns_lock())
+			lock.unlock();
+
+		pageIn(chunk_position);
+		return lockRecord(chunk_position, lock);
+	}
+
+	ChunkRecord & TileProvider::lockOrCreateRecord(ChunkPosition chunk_position, std::unique_lock<std::shared_mutex> &lock) {
+		for (;;) {
+			if (ChunkRecord *record = lockRecord(chunk_position, lock))
+				return *record;
+
+			ChunkRecord *record = nullptr;
+
+			{
+				std::unique_lock map_lock(recordMutex);
+				if (freeRecords.empty()) {
+					record = allRecords.emplace_back(std::make_unique<ChunkRecord>()).get();
+				} else {
+					record = freeRecords.back();
+					freeRecords.pop_back();
+				}
+			}
+
+			// Record locks are always taken before recordMutex, never the other way around.
+			lock = std::unique_lock(record->mutex);
+
+			std::unique_lock map_lock(recordMutex);
+
+			if (records.try_emplace(chunk_position, record).second) {
+				record->position = chunk_position;
+				record->resident = true;
+				// Clients compare their copy's counter against this one, so it has to keep going up across evictions.
+				if (auto iter = evictedChunks.find(chunk_position); iter != evictedChunks.end())
+					record->meta.updateCount = iter->second;
+				return *record;
+			}
+
+			// Another thread created a record for the position in the meantime.
+			freeRecords.push_back(record);
+			map_lock.unlock();
+			lock.unlock();
+		}
+	}
+
+	void TileProvider::releaseRecord(ChunkRecord &record, bool evicted) {
+		assert(record.resident);
+		record.resident = false;
+		const uint64_t update_count = record.meta.updateCount;
+		resetRecord(record);
+
+		std::unique_lock map_lock(recordMutex);
+		records.erase(record.position);
+		freeRecords.push_back(&record);
+		if (evicted)
+			evictedChunks[record.position] = update_count;
+	}
+
+	const ChunkRecord & TileProvider::requireRecord(ChunkPosition chunk_position, std::shared_lock<std::shared_mutex> &lock) const {
+		if (const ChunkRecord *record = lockForReading(chunk_position, lock))
+			return *record;
+		throw std::out_of_range("Couldn't find chunk at position " + static_cast<std::string>(chunk_position));
+	}
+
+	std::vector<ChunkRecord *> TileProvider::getRecords() const {
+		std::shared_lock lock(recordMutex);
+		std::vector<ChunkRecord *> out;
+		out.reserve(records.size());
+		for (const auto &[chunk_position, record]: records)
+			out.push_back(record);
+		return out;
+	}
+
 	void TileProvider::validateLayer(Layer layer) const {
 		if (static_cast<uint8_t>(layer) < static_cast<uint8_t>(Layer::Terrain) || LAYER_COUNT < static_cast<uint8_t>(layer))
 			throw std::out_of_range("Invalid layer: " + std::to_string(static_cast<uint8_t>(layer)));
@@ -694,10 +906,16 @@ namespace Game3 {
 		if (full_data) {
 			auto &data = json["data"];
 
+			const std::vector<ChunkRecord *> candidates = getRecords();
+
 			nlohmann::json tile_array;
 			for (const auto layer: allLayers) {
-				std::shared_lock biome_lock(chunkMutexes[getIndex(layer)]);
-				for (auto &[position, chunk]: chunkMaps[getIndex(layer)]) {
+				for (const ChunkRecord *record: candidates) {
+					std::shared_lock<std::shared_mutex> record_lock(record->mutex);
+					const TileChunk &chunk = record->terrain[getIndex(layer)];
+					if (!record->resident || chunk.empty())
+						continue;
+					const ChunkPosition position = record->position;
 					auto chunk_lock = chunk.sharedLock();
 					tile_array.push_back(std::make_pair(std::make_tuple(getIndex(layer), position.x, position.y), compress(std::span(chunk.data(), chunk.size()))));
 				}
@@ -705,39 +923,45 @@ namespace Game3 {
 			data.push_back(std::move(tile_array));
 
 			nlohmann::json biome_array;
-			{
-				std::shared_lock biome_lock(biomeMutex);
-				for (auto &[position, chunk]: biomeMap) {
-					auto chunk_lock = chunk.sharedLock();
-					biome_array.push_back(std::make_pair(std::make_pair(position.x, position.y), compress(std::span(chunk.data(), chunk.size()))));
-				}
+			for (const ChunkRecord *record: candidates) {
+				std::shared_lock<std::shared_mutex> record_lock(record->mutex);
+				const BiomeChunk &chunk = record->biomes;
+				if (!record->resident || chunk.empty())
+					continue;
+				const ChunkPosition position = record->position;
+				auto chunk_lock = chunk.sharedLock();
+				biome_array.push_back(std::make_pair(std::make_pair(position.x, position.y), compress(std::span(chunk.data(), chunk.size()))));
 			}
 			data.push_back(std::move(biome_array));
 
 			nlohmann::json path_array;
-			{
-				std::shared_lock path_lock(pathMutex);
-				for (auto &[position, chunk]: pathMap) {
-					auto chunk_lock = chunk.sharedLock();
-					path_array.push_back(std::make_pair(std::make_pair(position.x, position.y), compress(std::span(chunk.data(), chunk.size()))));
-				}
+			for (const ChunkRecord *record: candidates) {
+				std::shared_lock<std::shared_mutex> record_lock(record->mutex);
+				const PathChunk &chunk = record->pathmap;
+				if (!record->resident || chunk.empty())
+					continue;
+				const ChunkPosition position = record->position;
+				auto chunk_lock = chunk.sharedLock();
+				path_array.push_back(std::make_pair(std::make_pair(position.x, position.y), compress(std::span(chunk.data(), chunk.size()))));
 			}
 			data.push_back(std::move(path_array));
 
 			nlohmann::json fluid_array;
-			{
-				static_assert(sizeof(FluidLevel) == 2);
-				std::shared_lock fluid_lock(fluidMutex);
-				for (auto &[position, chunk]: fluidMap) {
-					std::vector<FluidInt> packed;
-					{
-						auto chunk_lock = chunk.sharedLock();
-						packed.reserve(chunk.size());
-						for (const FluidTile &fluid_tile: chunk)
-							packed.emplace_back(fluid_tile);
-					}
-					fluid_array.push_back(std::make_pair(std::make_pair(position.x, position.y), compress(std::span(packed.data(), packed.size()))));
+			static_assert(sizeof(FluidLevel) == 2);
+			for (const ChunkRecord *record: candidates) {
+				std::shared_lock<std::shared_mutex> record_lock(record->mutex);
+				const FluidChunk &chunk = record->fluids;
+				if (!record->resident || chunk.empty())
+					continue;
+				const ChunkPosition position = record->position;
+				std::vector<FluidInt> packed;
+				{
+					auto chunk_lock = chunk.sharedLock();
+					packed.reserve(chunk.size());
+					for (const FluidTile &fluid_tile: chunk)
+						packed.emplace_back(fluid_tile);
 				}
+				fluid_array.push_back(std::make_pair(std::make_pair(position.x, position.y), compress(std::span(packed.data(), packed.size()))));
 			}
 			data.push_back(std::move(fluid_array));
 		}
@@ -753,21 +977,24 @@ namespace Game3 {
 				const auto [layer, x, y] = item.at(0).get<std::tuple<size_t, int32_t, int32_t>>();
 				static_assert(sizeof(TileID) == 2);
 				const auto compressed = item.at(1).get<std::vector<uint8_t>>();
-				chunkMaps[layer][ChunkPosition{x, y}] = decompress16(std::span(compressed.data(), compressed.size()));
+				std::unique_lock<std::shared_mutex> lock;
+				lockOrCreateRecord(ChunkPosition{x, y}, lock).terrain.at(layer) = decompress16(std::span(compressed.data(), compressed.size()));
 			}
 
 			for (const auto &item: data.at(1)) {
 				const auto [x, y] = item.at(0).get<std::pair<int32_t, int32_t>>();
 				static_assert(sizeof(BiomeType) == 2);
 				const auto compressed = item.at(1).get<std::vector<uint8_t>>();
-				biomeMap[ChunkPosition{x, y}] = decompress16(std::span(compressed.data(), compressed.size()));
+				std::unique_lock<std::shared_mutex> lock;
+				lockOrCreateRecord(ChunkPosition{x, y}, lock).biomes = decompress16(std::span(compressed.data(), compressed.size()));
 			}
 
 			for (const auto &item: data.at(2)) {
 				const auto [x, y] = item.at(0).get<std::pair<int32_t, int32_t>>();
 				static_assert(sizeof(PathChunk::value_type) == 1);
 				const auto compressed = item.at(1).get<std::vector<uint8_t>>();
-				pathMap[ChunkPosition{x, y}] = decompress8(std::span(compressed.data(), compressed.size()));
+				std::unique_lock<std::shared_mutex> lock;
+				lockOrCreateRecord(ChunkPosition{x, y}, lock).pathmap = decompress8(std::span(compressed.data(), compressed.size()));
 			}
 
 			for (const auto &item: data.at(3)) {
@@ -775,7 +1002,8 @@ namespace Game3 {
 				static_assert(sizeof(FluidTile) == 6);
 				const auto compressed = item.at(1).get<std::vector<uint8_t>>();
 				const auto decompressed = decompress64(std::span(compressed.data(), compressed.size()));
-				auto &chunk = fluidMap[ChunkPosition{x, y}];
+				std::unique_lock<std::shared_mutex> lock;
+				auto &chunk = lockOrCreateRecord(ChunkPosition{x, y}, lock).fluids;
 				chunk.clear();
 				chunk.reserve(decompressed.size());
 				for (const auto tile: decompressed) {
@@ -9,7 +9,7 @@
 #include "realm/Realm.h"
 #include "ui/MainWindow.h"
 #include "util/FS.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 #include "util/Util.h"
 
 #include <array>
@@ -177,7 +177,7 @@ namespace Game3 {
 			return;
 		chunk = &new_chunk;
 		if (can_reupload) {
-			Timer timer{"EBR::setChunk::reupload"};
+			PROFILE_ZONE("EBR::setChunk::reupload");
 			reupload();
 		}
 	}
@@ -218,7 +218,7 @@ namespace Game3 {
 		const TileID missing = tileset["base:tile/void"];
 		Game &game = realm->getGame();
 
-		Timer timer{"BufferedVBOInit"};
+		PROFILE_ZONE("BufferedVBOInit");
 		vbo.init<float, 11>(CHUNK_SIZE, CHUNK_SIZE, GL_STATIC_DRAW, [this, &game, &tileset, set_width, divisor, t_size, missing](size_t x, size_t y) {
 			const auto [chunk_x, chunk_y] = chunkPosition.copyBase();
 
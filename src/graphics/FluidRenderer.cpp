@@ -15,7 +15,7 @@
 #include "graphics/FluidRenderer.h"
 #include "realm/Realm.h"
 #include "util/FS.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 #include "util/Util.h"
 
 namespace Game3 {
@@ -114,7 +114,7 @@ namespace Game3 {
 			return;
 		chunk = &new_chunk;
 		if (can_reupload) {
-			Timer timer{"FR::setChunk::reupload"};
+			PROFILE_ZONE("FR::setChunk::reupload");
 			reupload();
 		}
 	}
@@ -156,7 +156,7 @@ namespace Game3 {
 
 		const auto [chunk_x, chunk_y] = chunkPosition.copyBase();
 
-		Timer timer{"FluidVBOInit"};
+		PROFILE_ZONE("FluidVBOInit");
 		vbo.init<float, 4>(CHUNK_SIZE, CHUNK_SIZE, GL_DYNAMIC_DRAW, [this, chunk_x = chunk_x, chunk_y = chunk_y, &game, set_width, divisor, t_size, missing](size_t x, size_t y) {
 			const auto fluid_opt = realm->tileProvider.copyFluidTile({
 				Index(y) + CHUNK_SIZE * (chunk_y + 1), // why `+ 1`?
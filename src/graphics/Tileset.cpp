@@ -3,6 +3,9 @@
 #include "item/Item.h"
 #include "realm/Realm.h"
 #include "util/Crypto.h"
+#include "util/Math.h"
+
+#include <algorithm>
 
 namespace Game3 {
 	Tileset::Tileset(Identifier identifier_):
@@ -13,7 +16,7 @@ namespace Game3 {
 	}
 
 	bool Tileset::isLand(TileID id) const {
-		return isLand(names.at(id));
+		return (getFlags(id) & LAND_TILE) != 0;
 	}
 
 	bool Tileset::isWalkable(const Identifier &id) const {
@@ -21,7 +24,8 @@ namespace Game3 {
 	}
 
 	bool Tileset::isWalkable(TileID id) const {
-		return isWalkable(names.at(id));
+		const uint8_t flags = getFlags(id);
+		return (flags & (LAND_TILE | WALKABLE_TILE)) != 0 || (flags & SOLID_TILE) == 0;
 	}
 
 	bool Tileset::isSolid(const Identifier &id) const {
@@ -29,7 +33,7 @@ namespace Game3 {
 	}
 
 	bool Tileset::isSolid(TileID id) const {
-		return isSolid(names.at(id));
+		return (getFlags(id) & SOLID_TILE) != 0;
 	}
 
 	const Identifier & Tileset::getEmpty() const {
@@ -50,16 +54,12 @@ namespace Game3 {
 		return bright;
 	}
 
-	std::vector<TileID> Tileset::getBrightIDs() {
-		if (brightCache)
-			return *brightCache;
+	const std::vector<TileID> & Tileset::getBrightIDs() const {
+		return brightIDs;
+	}
 
-		std::vector<TileID> out;
-		out.reserve(bright.size());
-		for (const auto &tilename: bright)
-			out.push_back(ids.at(tilename));
-		brightCache = out;
-		return out;
+	bool Tileset::isBright(TileID id) const {
+		return (getFlags(id) & BRIGHT_TILE) != 0;
 	}
 
 	std::string Tileset::getName() const {
@@ -90,29 +90,8 @@ namespace Game3 {
 		return false;
 	}
 
-	bool Tileset::isMarchable(TileID id) {
-		if (marchableCache.contains(id))
-			return true;
-
-		if (unmarchableCache.contains(id))
-			return false;
-
-		const auto &tilename = names.at(id);
-
-		if (marchable.contains(tilename)) {
-			marchableCache.insert(id);
-			return true;
-		}
-
-		for (const auto &category: inverseCategories.at(tilename)) {
-			if (marchable.contains(category)) {
-				marchableCache.insert(id);
-				return true;
-			}
-		}
-
-		unmarchableCache.insert(id);
-		return false;
+	bool Tileset::isMarchable(TileID id) const {
+		return (getFlags(id) & MARCHABLE_TILE) != 0;
 	}
 
 	bool Tileset::isCategoryMarchable(const Identifier &category) const {
@@ -125,21 +104,12 @@ namespace Game3 {
 		return nullptr;
 	}
 
-	void Tileset::clearCache() {
-		marchableCache.clear();
-		unmarchableCache.clear();
-		brightCache.reset();
-	}
-
 	const std::unordered_set<Identifier> & Tileset::getCategories(const Identifier &tilename) const {
 		return inverseCategories.at(tilename);
 	}
 
-	const std::unordered_set<TileID> Tileset::getCategoryIDs(const Identifier &category) const {
-		std::unordered_set<TileID> out;
-		for (const auto &tilename: categories.at(category))
-			out.insert((*this)[tilename]);
-		return out;
+	const std::unordered_set<TileID> & Tileset::getCategoryIDs(const Identifier &category) const {
+		return categoryTileIDs.at(categoryIndices.at(category));
 	}
 
 	const std::unordered_set<Identifier> & Tileset::getTilesByCategory(const Identifier &category) const {
@@ -152,8 +122,21 @@ namespace Game3 {
 		return false;
 	}
 
+	std::optional<Tileset::CategoryIndex> Tileset::getCategoryIndex(const Identifier &category) const {
+		if (auto iter = categoryIndices.find(category); iter != categoryIndices.end())
+			return iter->second;
+		return std::nullopt;
+	}
+
 	bool Tileset::isInCategory(TileID tile_id, const Identifier &category) const {
-		return isInCategory((*this)[tile_id], category);
+		if (std::optional<CategoryIndex> index = getCategoryIndex(category))
+			return isInCategory(tile_id, *index);
+		return false;
+	}
+
+	bool Tileset::isInCategory(TileID tile_id, CategoryIndex index) const {
+		getFlags(tile_id);
+		return (tileCategories[tile_id * tileCategoryWords + index / 64] >> (index % 64)) & 1;
 	}
 
 	bool Tileset::hasName(const Identifier &tilename) const {
@@ -225,6 +208,73 @@ namespace Game3 {
 		json["autotiles"] = std::move(autotiles);
 	}
 
+	void Tileset::buildTables() {
+		categoryIndices.clear();
+		categoryTileIDs.clear();
+
+		for (const auto &[category, tilenames]: categories) {
+			const auto index = static_cast<CategoryIndex>(categoryTileIDs.size());
+			categoryIndices[category] = index;
+			std::unordered_set<TileID> &tile_ids = categoryTileIDs.emplace_back();
+			for (const Identifier &tilename: tilenames)
+				if (auto iter = ids.find(tilename); iter != ids.end())
+					tile_ids.insert(iter->second);
+		}
+
+		size_t tile_count = 0;
+		for (const auto &[id, tilename]: names)
+			tile_count = std::max<size_t>(tile_count, id + 1);
+
+		tileCategoryWords = updiv(categoryTileIDs.size(), 64);
+		tileFlags.assign(tile_count, 0);
+		tileCategories.assign(tile_count * tileCategoryWords, 0);
+		brightIDs.clear();
+
+		for (const auto &[id, tilename]: names) {
+			uint8_t flags = KNOWN_TILE;
+
+			if (land.contains(tilename))
+				flags |= LAND_TILE;
+
+			if (walkable.contains(tilename))
+				flags |= WALKABLE_TILE;
+
+			if (solid.contains(tilename))
+				flags |= SOLID_TILE;
+
+			if (bright.contains(tilename))
+				flags |= BRIGHT_TILE;
+
+			if (marchable.contains(tilename))
+				flags |= MARCHABLE_TILE;
+
+			if (auto iter = inverseCategories.find(tilename); iter != inverseCategories.end()) {
+				for (const Identifier &category: iter->second) {
+					if (marchable.contains(category))
+						flags |= MARCHABLE_TILE;
+
+					if (auto index_iter = categoryIndices.find(category); index_iter != categoryIndices.end()) {
+						const CategoryIndex index = index_iter->second;
+						tileCategories[id * tileCategoryWords + index / 64] |= uint64_t(1) << (index % 64);
+					}
+				}
+			}
+
+			tileFlags[id] = flags;
+		}
+
+		for (const Identifier &tilename: bright)
+			if (auto iter = ids.find(tilename); iter != ids.end())
+				brightIDs.push_back(iter->second);
+	}
+
+	uint8_t Tileset::getFlags(TileID id) const {
+		if (id < tileFlags.size())
+			if (const uint8_t flags = tileFlags[id]; flags != 0)
+				return flags;
+		throw std::out_of_range("Tile ID " + std::to_string(id) + " not in tileset " + identifier.str());
+	}
+
 	void Tileset::setAutotile(const Identifier &tilename, const Identifier &autotile_name) {
 		if (auto iter = autotileSets.find(autotile_name); iter != autotileSets.end()) {
 			autotileSetMap[tilename] = iter->second;
@@ -9,7 +9,7 @@
 #include "realm/Realm.h"
 #include "ui/MainWindow.h"
 #include "util/FS.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 #include "util/Util.h"
 
 #include <array>
@@ -173,7 +173,7 @@ namespace Game3 {
 			return;
 		chunk = &new_chunk;
 		if (can_reupload) {
-			Timer timer{"UR::setChunk::reupload"};
+			PROFILE_ZONE("UR::setChunk::reupload");
 			reupload();
 		}
 	}
@@ -209,7 +209,7 @@ namespace Game3 {
 		const float divisor = set_width;
 		const float t_size = 1.f / divisor - TILE_TEXTURE_PADDING * 2;
 
-		Timer timer{"UpperVBOInit"};
+		PROFILE_ZONE("UpperVBOInit");
 		vbo.init<float, 8>(CHUNK_SIZE, CHUNK_SIZE, GL_STATIC_DRAW, [this, &tileset, set_width, divisor, t_size](size_t x, size_t y) {
 			const auto [chunk_x, chunk_y] = chunkPosition.copyBase();
 
@@ -56,8 +56,8 @@ namespace Game3 {
 	}
 
 	std::string ChemicalItem::getFormula(const ItemStack &stack) {
-		if (auto iter = stack.data.find("formula"); iter != stack.data.end() && !iter->is_null())
-			return *iter;
+		if (const std::string *formula = stack.data.get<std::string>("formula"))
+			return *formula;
 		return {};
 	}
 }
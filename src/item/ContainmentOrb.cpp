@@ -41,18 +41,21 @@ namespace Game3 {
 			if (!selected)
 				return true;
 
-			stack.data["containedEntity"] = selected->type;
-			stack.data["containedName"] = selected->getName();
+			nlohmann::json data;
+			data["containedEntity"] = selected->type;
+			data["containedName"] = selected->getName();
 
 			if (selected->isPlayer()) {
 				auto player = safeDynamicCast<ServerPlayer>(selected);
 				player->teleport({32, 32}, game.getRealm(-1), MovementContext{.isTeleport = true});
-				stack.data["containedUsername"] = player->username;
+				data["containedUsername"] = player->username;
 			} else {
-				selected->toJSON(stack.data);
+				selected->toJSON(data);
 				selected->queueDestruction();
 			}
 
+			stack.data = data;
+
 			player->getInventory(0)->notifyOwner();
 			SUCCESS("Captured " << selected->type);
 			return true;
@@ -61,13 +64,13 @@ namespace Game3 {
 		if (!place.realm->isPathable(place.position))
 			return true;
 
-		Identifier type = stack.data.at("containedEntity");
+		Identifier type(stack.data.at<std::string>("containedEntity"));
 		if (type == "base:entity/player") {
-			game.toServer().releasePlayer(stack.data.at("containedUsername"), place);
+			game.toServer().releasePlayer(stack.data.at<std::string>("containedUsername"), place);
 		} else {
 			const GlobalID new_gid = Agent::generateGID();
 			const std::shared_ptr<EntityFactory> &factory = game.registry<EntityFactoryRegistry>()[type];
-			EntityPtr entity = (*factory)(game, stack.data);
+			EntityPtr entity = (*factory)(game, stack.data.toJSON());
 			entity->spawning = true;
 			entity->setRealm(realm);
 			realm->queueEntityInit(std::move(entity), place.position);
@@ -79,8 +82,8 @@ namespace Game3 {
 	}
 
 	std::string ContainmentOrb::getTooltip(const ItemStack &stack) {
-		if (auto iter = stack.data.find("containedName"); iter != stack.data.end())
-			return "Containment Orb (" + iter->get<std::string>() + ')';
+		if (const std::string *name = stack.data.get<std::string>("containedName"))
+			return "Containment Orb (" + *name + ')';
 		return "Containment Orb";
 	}
 
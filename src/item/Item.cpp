@@ -130,7 +130,7 @@ namespace Game3 {
 		item->initStack(game_, *this);
 	}
 
-	ItemStack::ItemStack(const Game &game_, std::shared_ptr<Item> item_, ItemCount count_, nlohmann::json data_):
+	ItemStack::ItemStack(const Game &game_, std::shared_ptr<Item> item_, ItemCount count_, ItemData data_):
 	item(std::move(item_)), count(count_), data(std::move(data_)), game(&game_) {
 		assert(item);
 		item->initStack(game_, *this);
@@ -142,7 +142,7 @@ namespace Game3 {
 		item->initStack(game_, *this);
 	}
 
-	ItemStack::ItemStack(const Game &game_, const ItemID &id, ItemCount count_, nlohmann::json data_):
+	ItemStack::ItemStack(const Game &game_, const ItemID &id, ItemCount count_, ItemData data_):
 	item(game_.registry<ItemRegistry>().at(id)), count(count_), data(std::move(data_)), game(&game_) {
 		assert(item);
 		item->initStack(game_, *this);
@@ -174,7 +174,7 @@ namespace Game3 {
 
 	ItemStack ItemStack::withDurability(const Game &game, const ItemID &id, Durability durability) {
 		ItemStack out(game, id, 1);
-		out.data["durability"] = std::make_pair(durability, durability);
+		out.data.set("durability", ItemData::IntegerPair(durability, durability));
 		return out;
 	}
 
@@ -185,7 +185,10 @@ namespace Game3 {
 	bool ItemStack::reduceDurability(Durability amount) {
 		if (!hasDurability())
 			return false;
-		return (data["durability"].at(0) = std::max(0, data["durability"].at(0).get<Durability>() - amount)) == 0;
+		auto [durability, max_durability] = data.at<ItemData::IntegerPair>("durability");
+		durability = std::max<int64_t>(0, durability - amount);
+		data.set("durability", ItemData::IntegerPair(durability, max_durability));
+		return durability == 0;
 	}
 
 	bool ItemStack::hasAttribute(const Identifier &attribute) const {
@@ -193,8 +196,8 @@ namespace Game3 {
 	}
 
 	bool ItemStack::hasDurability() const {
-		if (auto iter = data.find("durability"); iter != data.end())
-			return 0 <= iter->get<std::pair<double, double>>().second;
+		if (const auto *durability = data.get<ItemData::IntegerPair>("durability"))
+			return 0 <= durability->second;
 		return false;
 	}
 
@@ -202,8 +205,8 @@ namespace Game3 {
 		if (!hasDurability())
 			return 1.;
 
-		const std::pair<double, double> &pair = data.at("durability");
-		return pair.first / pair.second;
+		const auto [durability, max_durability] = data.at<ItemData::IntegerPair>("durability");
+		return double(durability) / max_durability;
 	}
 
 	std::string ItemStack::getTooltip() const {
@@ -227,7 +230,7 @@ namespace Game3 {
 			const auto &extra = json.at(2);
 			if (extra.is_string() && extra == "with_durability") {
 				const Durability durability = dynamic_cast<HasMaxDurability &>(*stack.item).maxDurability;
-				stack.data["durability"] = std::make_pair(durability, durability);
+				stack.data.set("durability", ItemData::IntegerPair(durability, durability));
 			} else {
 				stack.data = extra;
 			}
@@ -252,14 +255,14 @@ namespace Game3 {
 		absorbGame(game_);
 		buffer << item->identifier;
 		buffer << count;
-		buffer << data.dump();
+		buffer << data;
 	}
 
 	void ItemStack::decode(Game &game_, Buffer &buffer) {
 		absorbGame(game_);
 		item = game->registry<ItemRegistry>()[buffer.take<Identifier>()];
 		buffer >> count;
-		data = nlohmann::json::parse(buffer.take<std::string>());
+		buffer >> data;
 	}
 
 	void ItemStack::absorbGame(const Game &game_) {
@@ -289,7 +292,7 @@ namespace Game3 {
 		buffer.appendType(stack);
 		buffer << stack.item->identifier;
 		buffer << stack.count;
-		buffer << stack.data.dump(); // TODO: Buffer::operator+= for json
+		buffer << stack.data;
 		return buffer;
 	}
 
@@ -306,8 +309,7 @@ namespace Game3 {
 		}
 		const auto item_id = buffer.take<Identifier>();
 		stack.count = buffer.take<ItemCount>();
-		const auto raw_json = buffer.take<std::string>(); // TODO: popBuffer for json
-		stack.data = nlohmann::json::parse(raw_json);
+		buffer >> stack.data;
 		stack.item = stack.getGame().registry<ItemRegistry>().at(item_id);
 		return buffer;
 	}
@@ -316,7 +318,7 @@ namespace Game3 {
 		json[0] = stack.item->identifier;
 		json[1] = stack.count;
 		if (!stack.data.empty())
-			json[2] = stack.data;
+			json[2] = stack.data.toJSON();
 	}
 
 	std::ostream & operator<<(std::ostream &os, const Game3::ItemStack &stack) {
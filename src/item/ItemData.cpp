@@ -0,0 +1,170 @@
+#include "item/ItemData.h"
+#include "net/Buffer.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace Game3 {
+	namespace {
+		inline void combine(size_t &seed, size_t value) {
+			seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+		}
+
+		size_t hashValue(const ItemData::Value &value) {
+			size_t out = value.index();
+			std::visit([&out](const auto &alternative) {
+				using T = std::decay_t<decltype(alternative)>;
+				if constexpr (std::is_same_v<T, ItemData::IntegerPair>) {
+					combine(out, std::hash<int64_t>()(alternative.first));
+					combine(out, std::hash<int64_t>()(alternative.second));
+				} else {
+					combine(out, std::hash<T>()(alternative));
+				}
+			}, value);
+			return out;
+		}
+
+		/** Unsigned numbers too large for int64_t stay JSON, so that they don't come back negative. */
+		bool isInteger(const nlohmann::json &json) {
+			return json.is_number_integer() && (!json.is_number_unsigned() || json.get<uint64_t>() <= uint64_t(std::numeric_limits<int64_t>::max()));
+		}
+
+		ItemData::Value fromJSONValue(const nlohmann::json &json) {
+			if (json.is_boolean())
+				return json.get<bool>();
+
+			if (isInteger(json))
+				return json.get<int64_t>();
+
+			if (json.is_number_float())
+				return json.get<double>();
+
+			if (json.is_string())
+				return json.get<std::string>();
+
+			if (json.is_array() && json.size() == 2 && isInteger(json[0]) && isInteger(json[1]))
+				return ItemData::IntegerPair(json[0].get<int64_t>(), json[1].get<int64_t>());
+
+			return ItemData::Value(std::in_place_type<nlohmann::json>, json);
+		}
+
+		nlohmann::json toJSONValue(const ItemData::Value &value) {
+			return std::visit([](const auto &alternative) -> nlohmann::json {
+				using T = std::decay_t<decltype(alternative)>;
+				if constexpr (std::is_same_v<T, ItemData::IntegerPair>)
+					return nlohmann::json::array({alternative.first, alternative.second});
+				else
+					return alternative;
+			}, value);
+		}
+
+		auto findEntry(auto &entries, std::string_view key) {
+			return std::lower_bound(entries.begin(), entries.end(), key, [](const ItemData::Entry &entry, std::string_view key) {
+				return entry.first < key;
+			});
+		}
+	}
+
+	ItemData::ItemData(std::initializer_list<Entry> list) {
+		for (const auto &[key, value]: list)
+			set(key, value);
+	}
+
+	ItemData::ItemData(const nlohmann::json &json) {
+		if (json.is_null())
+			return;
+
+		if (!json.is_object())
+			throw std::invalid_argument("Item data must be a JSON object, not " + json.dump());
+
+		entries.reserve(json.size());
+		// nlohmann::json objects are sorted by key already.
+		for (const auto &[key, value]: json.items())
+			entries.emplace_back(key, fromJSONValue(value));
+
+		rehash();
+	}
+
+	const ItemData::Value * ItemData::find(std::string_view key) const {
+		auto iter = findEntry(entries, key);
+		if (iter != entries.end() && iter->first == key)
+			return &iter->second;
+		return nullptr;
+	}
+
+	void ItemData::set(std::string key, Value value) {
+		auto iter = findEntry(entries, key);
+		if (iter != entries.end() && iter->first == key)
+			iter->second = std::move(value);
+		else
+			entries.emplace(iter, std::move(key), std::move(value));
+		rehash();
+	}
+
+	bool ItemData::erase(std::string_view key) {
+		auto iter = findEntry(entries, key);
+		if (iter == entries.end() || iter->first != key)
+			return false;
+		entries.erase(iter);
+		rehash();
+		return true;
+	}
+
+	void ItemData::clear() {
+		entries.clear();
+		hash = 0;
+	}
+
+	nlohmann::json ItemData::toJSON() const {
+		nlohmann::json out;
+		for (const auto &[key, value]: entries)
+			out[key] = toJSONValue(value);
+		return out;
+	}
+
+	bool ItemData::operator==(const ItemData &other) const {
+		return this == &other || (hash == other.hash && entries == other.entries);
+	}
+
+	bool ItemData::operator<(const ItemData &other) const {
+		if (hash != other.hash)
+			return hash < other.hash;
+		return entries < other.entries;
+	}
+
+	void ItemData::rehash() {
+		hash = 0;
+		for (const auto &[key, value]: entries) {
+			combine(hash, std::hash<std::string>()(key));
+			combine(hash, hashValue(value));
+		}
+	}
+
+	void to_json(nlohmann::json &json, const ItemData &data) {
+		json = data.toJSON();
+	}
+
+	void from_json(const nlohmann::json &json, ItemData &data) {
+		data = ItemData(json);
+	}
+
+	template <>
+	ItemData popBuffer<ItemData>(Buffer &buffer) {
+		ItemData out;
+		buffer >> out;
+		return out;
+	}
+
+	Buffer & operator+=(Buffer &buffer, const ItemData &data) {
+		return buffer += data.toJSON();
+	}
+
+	Buffer & operator<<(Buffer &buffer, const ItemData &data) {
+		return buffer << data.toJSON();
+	}
+
+	Buffer & operator>>(Buffer &buffer, ItemData &data) {
+		data = ItemData(nlohmann::json::parse(buffer.take<std::string>()));
+		return buffer;
+	}
+}
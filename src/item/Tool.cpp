@@ -3,6 +3,6 @@
 namespace Game3 {
 	void Tool::initStack(const Game &, ItemStack &stack) {
 		if (!stack.data.contains("durability"))
-			stack.data["durability"] = std::make_pair(maxDurability, maxDurability);
+			stack.data.set("durability", ItemData::IntegerPair(maxDurability, maxDurability));
 	}
 }
@@ -27,6 +27,18 @@ namespace Game3 {
 	void splitter();
 	void omniOptOut();
 	void filterTest();
+	void sendBenchmark();
+	void frameDecoderBenchmark();
+	void pathfindingBenchmark();
+	void spatialHashBenchmark();
+	void weakSetBenchmark();
+	void tickSchedulerTest();
+	void chunkReadBenchmark();
+	void identifierBenchmark();
+	void registryBenchmark();
+	void itemDataBenchmark();
+	void inventoryTransactionBenchmark();
+	void chunkEvictionTest();
 	bool chemskrTest(int, char **);
 	void skewTest(double location, double scale, double shape);
 	void damageTest(HitPoints weapon_damage, int defense, int variability, double attacker_luck, double defender_luck);
@@ -163,6 +175,66 @@ int main(int argc, char **argv) {
 			return 0;
 		}
 
+		if (arg1 == "--send-benchmark") {
+			Game3::sendBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--frame-benchmark") {
+			Game3::frameDecoderBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--path-benchmark") {
+			Game3::pathfindingBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--spatial-benchmark") {
+			Game3::spatialHashBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--weakset-benchmark") {
+			Game3::weakSetBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--tick-test") {
+			Game3::tickSchedulerTest();
+			return 0;
+		}
+
+		if (arg1 == "--chunk-benchmark") {
+			Game3::chunkReadBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--identifier-benchmark") {
+			Game3::identifierBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--registry-benchmark") {
+			Game3::registryBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--item-data-benchmark") {
+			Game3::itemDataBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--inventory-benchmark") {
+			Game3::inventoryTransactionBenchmark();
+			return 0;
+		}
+
+		if (arg1 == "--eviction-test") {
+			Game3::chunkEvictionTest();
+			return 0;
+		}
+
 		if (argc == 4) {
 			std::cout << Game3::generateFlask(Game3::dataRoot / "resources" / "testtubebase.png", Game3::dataRoot / "resources" / "testtubemask.png", argv[1], argv[2], argv[3]);
 			return 0;
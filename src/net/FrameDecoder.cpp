@@ -0,0 +1,45 @@
+#include "net/FrameDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Game3 {
+	FrameDecoder::FrameDecoder(size_t max_payload_size):
+		maxPayloadSize(max_payload_size) {}
+
+	void FrameDecoder::reset() {
+		state = State::Header;
+		headerFill = 0;
+		packetID = 0;
+		payloadSize = 0;
+		pending.clear();
+	}
+
+	bool FrameDecoder::readHeader(std::span<const uint8_t> &input) {
+		if (headerFill == 0 && HEADER_SIZE <= input.size()) {
+			// The common case: the whole header is in this read and can be parsed where it is.
+			parseHeader(input.data());
+			input = input.subspan(HEADER_SIZE);
+		} else {
+			const size_t to_take = std::min(HEADER_SIZE - headerFill, input.size());
+			std::memcpy(header.data() + headerFill, input.data(), to_take);
+			headerFill += to_take;
+			input = input.subspan(to_take);
+
+			if (headerFill < HEADER_SIZE)
+				return false;
+
+			parseHeader(header.data());
+			headerFill = 0;
+		}
+
+		pending.clear();
+		state = State::Payload;
+		return true;
+	}
+
+	void FrameDecoder::parseHeader(const uint8_t *bytes) {
+		packetID = bytes[0] | (static_cast<uint16_t>(bytes[1]) << 8);
+		payloadSize = bytes[2] | (static_cast<uint32_t>(bytes[3]) << 8) | (static_cast<uint32_t>(bytes[4]) << 16) | (static_cast<uint32_t>(bytes[5]) << 24);
+	}
+}
@@ -0,0 +1,32 @@
+#include "Log.h"
+#include "net/Buffer.h"
+#include "net/FramedPacket.h"
+#include "packet/Packet.h"
+#include "util/Demangle.h"
+#include "util/Endian.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace Game3 {
+	FramedPacket framePacket(Game &game, const Packet &packet) {
+		if (!packet.valid) {
+			WARN("Dropping invalid packet of type " << DEMANGLE(packet));
+			return nullptr;
+		}
+
+		Buffer buffer;
+		buffer.bytes.resize(PACKET_HEADER_SIZE);
+		packet.encode(game, buffer);
+
+		const size_t payload_size = buffer.bytes.size() - PACKET_HEADER_SIZE;
+		assert(payload_size < UINT32_MAX);
+		const auto size = toLittle(static_cast<uint32_t>(payload_size));
+		const auto packet_id = toLittle(packet.getID());
+		static_assert(sizeof(packet_id) + sizeof(size) == PACKET_HEADER_SIZE);
+
+		std::memcpy(buffer.bytes.data(), &packet_id, sizeof(packet_id));
+		std::memcpy(buffer.bytes.data() + sizeof(packet_id), &size, sizeof(size));
+		return std::make_shared<const std::vector<uint8_t>>(std::move(buffer.bytes));
+	}
+}
@@ -26,6 +26,10 @@ namespace Game3 {
 	}
 
 	void GenericClient::queue(std::string message) {
+		queue(std::make_shared<const std::vector<uint8_t>>(message.begin(), message.end()));
+	}
+
+	void GenericClient::queue(FramedPacket message) {
 		{
 			auto lock = outbox.uniqueLock();
 			outbox.push_back(std::move(message));
@@ -36,19 +40,41 @@ namespace Game3 {
 		write();
 	}
 
+	void GenericClient::queue(std::vector<FramedPacket> messages) {
+		if (messages.empty())
+			return;
+
+		{
+			auto lock = outbox.uniqueLock();
+			const bool was_empty = outbox.empty();
+			outbox.insert(outbox.end(), std::make_move_iterator(messages.begin()), std::make_move_iterator(messages.end()));
+			if (!was_empty)
+				return;
+		}
+
+		write();
+	}
+
 	void GenericClient::write() {
 		auto lock = outbox.uniqueLock();
-		const std::string &message = outbox.front();
-		asio::async_write(socket, asio::buffer(message), strand.wrap([shared = shared_from_this()](const asio::error_code &errc, size_t size) {
-			shared->writeHandler(errc, size);
+
+		// Everything queued behind an in-flight write goes out together in the next vectored write.
+		const size_t count = std::min(outbox.size(), MAX_WRITE_BATCH);
+		std::vector<asio::const_buffer> buffers;
+		buffers.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+			buffers.emplace_back(outbox[i]->data(), outbox[i]->size());
+
+		asio::async_write(socket, buffers, strand.wrap([shared = shared_from_this(), count](const asio::error_code &errc, size_t size) {
+			shared->writeHandler(errc, size, count);
 		}));
 	}
 
-	void GenericClient::writeHandler(const asio::error_code &errc, size_t) {
+	void GenericClient::writeHandler(const asio::error_code &errc, size_t, size_t count) {
 		bool empty{};
 		{
 			auto lock = outbox.uniqueLock();
-			outbox.pop_front();
+			outbox.erase(outbox.begin(), outbox.begin() + count);
 			empty = outbox.empty();
 		}
 
@@ -4,6 +4,7 @@
 #include "Log.h"
 #include "game/ServerGame.h"
 #include "net/Buffer.h"
+#include "net/FramedPacket.h"
 #include "net/Server.h"
 #include "net/RemoteClient.h"
 #include "packet/ChunkTilesPacket.h"
@@ -16,114 +17,72 @@
 
 namespace Game3 {
 	void RemoteClient::handleInput(std::string_view string) {
-		if (string.empty())
-			return;
-
-		std::stringstream ss;
-		for (const uint8_t byte: string)
-			ss << ' ' << std::hex << std::setfill('0') << std::setw(2) << std::right << static_cast<uint16_t>(byte) << std::dec;
-		auto str = std::string(string);
-		while (!str.empty() && (str.back() == '\r' || str.back() == '\n'))
-			str.pop_back();
-
-		headerBytes.insert(headerBytes.end(), string.begin(), string.end());
-
-		if (state == State::Begin) {
-			receiveBuffer.clear();
-			packetType = 0;
-			payloadSize = 0;
-
-			if (6 <= headerBytes.size()) {
-				packetType = headerBytes[0] | (static_cast<uint16_t>(headerBytes[1]) << 8);
-				payloadSize = headerBytes[2] | (static_cast<uint32_t>(headerBytes[3]) << 8) | (static_cast<uint32_t>(headerBytes[4]) << 16) | (static_cast<uint32_t>(headerBytes[5]) << 24);
-
-				if (payloadSize > 32768) {
-					WARN("Payload size of " << payloadSize << " bytes for packet type " << packetType << " is too large (" << ip << ')');
-					mock();
-					return;
-				}
-
-				headerBytes.erase(headerBytes.begin(), headerBytes.begin() + 6);
-				state = State::Data;
-			}
-		}
+		const bool valid = decoder.feed(std::span(reinterpret_cast<const uint8_t *>(string.data()), string.size()), [this](PacketID packet_id, std::span<const uint8_t> payload) {
+			return handlePacket(packet_id, payload);
+		});
 
-		if (state == State::Data) {
-			if (MAX_PACKET_SIZE < receiveBuffer.size() + headerBytes.size())
-				throw PacketError("Packet too large");
-
-			const size_t to_append = std::min(payloadSize - receiveBuffer.size(), headerBytes.size());
-
-			receiveBuffer.append(headerBytes.begin(), headerBytes.begin() + to_append);
-			if (to_append == headerBytes.size())
-				headerBytes.clear();
-			else
-				headerBytes.erase(headerBytes.begin(), headerBytes.begin() + to_append);
-
-			if (payloadSize < receiveBuffer.size()) {
-				mock();
-				throw std::logic_error("Buffer grew too large");
-			}
-
-			if (payloadSize == receiveBuffer.size()) {
-				if (receiveBuffer.context.expired())
-					receiveBuffer.context = server.game;
-
-				auto packet = (*server.game->registry<PacketFactoryRegistry>()[packetType])();
-
-				try {
-					packet->decode(*server.game, receiveBuffer);
-				} catch (const std::exception &err) {
-					ERROR("Couldn't decode packet of type " << packetType << ", size " << payloadSize << ": " << err.what());
-					mock();
-					return;
-				} catch (...) {
-					ERROR("Couldn't decode packet of type " << packetType << ", size " << payloadSize);
-					mock();
-					return;
-				}
-
-				assert(receiveBuffer.empty());
-				receiveBuffer.clear();
-				server.game->queuePacket(std::static_pointer_cast<RemoteClient>(shared_from_this()), packet);
-				state = State::Begin;
-			}
+		if (!valid) {
+			WARN("Payload size of " << decoder.getPayloadSize() << " bytes for packet type " << decoder.getPacketID() << " is too large (" << ip << ')');
+			mock();
 		}
 	}
 
-	bool RemoteClient::send(const Packet &packet) {
-		if (!packet.valid) {
-			WARN("Dropping invalid packet of type " << DEMANGLE(packet));
+	bool RemoteClient::handlePacket(PacketID packet_id, std::span<const uint8_t> payload) {
+		// Reusing the buffer's storage means decoding doesn't allocate once it has grown to fit the largest packet seen.
+		receiveBuffer.clear();
+		receiveBuffer.bytes.assign(payload.begin(), payload.end());
+
+		if (receiveBuffer.context.expired())
+			receiveBuffer.context = server.game;
+
+		auto packet = (*server.game->registry<PacketFactoryRegistry>()[packet_id])();
+
+		try {
+			packet->decode(*server.game, receiveBuffer);
+		} catch (const std::exception &err) {
+			ERROR("Couldn't decode packet of type " << packet_id << ", size " << payload.size() << ": " << err.what());
+			mock();
+			return false;
+		} catch (...) {
+			ERROR("Couldn't decode packet of type " << packet_id << ", size " << payload.size());
+			mock();
 			return false;
 		}
 
+		assert(receiveBuffer.empty());
+		server.game->queuePacket(std::static_pointer_cast<RemoteClient>(shared_from_this()), packet);
+		return true;
+	}
+
+	bool RemoteClient::send(const Packet &packet) {
 		if (!server.game) {
 			WARN("Dropping packet of type " << DEMANGLE(packet) << ": game unavailable");
 			return false;
 		}
 
-		Buffer send_buffer;
-		packet.encode(*server.game, send_buffer);
-		assert(send_buffer.size() < UINT32_MAX);
-		const auto size = toLittle(static_cast<uint32_t>(send_buffer.size()));
-		const auto packet_id = toLittle(packet.getID());
-
-		std::span span = send_buffer.getSpan();
-		std::string to_send;
-		to_send.reserve(span.size_bytes() + sizeof(packet_id) + sizeof(size));
-		to_send.append(reinterpret_cast<const char *>(&packet_id), sizeof(packet_id));
-		to_send.append(reinterpret_cast<const char *>(&size), sizeof(size));
-		to_send.append(span.begin(), span.end());
-		send(to_send);
+		return send(framePacket(*server.game, packet));
+	}
+
+	bool RemoteClient::send(const FramedPacket &framed) {
+		if (!framed)
+			return false;
+
+		server.send(*this, framed);
 		return true;
 	}
 
 	void RemoteClient::sendChunk(Realm &realm, ChunkPosition chunk_position, bool can_request, uint64_t counter_threshold) {
 		assert(server.game);
 
-		if (counter_threshold != 0 && realm.tileProvider.contains(chunk_position) && realm.tileProvider.getUpdateCounter(chunk_position) < counter_threshold)
+		if (realm.tileProvider.isUpToDate(chunk_position, counter_threshold))
 			return;
 
+		// Stored chunks that aren't in memory are paged in off the tick thread and sent once they arrive.
+		if (realm.generatedChunks.contains(chunk_position) && !realm.tileProvider.isLoaded(chunk_position)) {
+			realm.requestChunk(chunk_position, std::static_pointer_cast<RemoteClient>(shared_from_this()));
+			return;
+		}
+
 		try {
 			realm.sendToOne(*this, chunk_position);
 		} catch (const std::out_of_range &) {
@@ -146,15 +105,16 @@ namespace Game3 {
 	void RemoteClient::flushBuffer(bool force) {
 		if (!force && !sendBuffer.active())
 			return;
-		std::string moved_buffer;
+		std::vector<FramedPacket> messages;
 		{
 			auto buffer_lock = sendBuffer.uniqueLock();
-			if (sendBuffer.bytes.empty())
+			if (sendBuffer.messages.empty())
 				return;
-			moved_buffer = std::move(sendBuffer.bytes);
+			messages = std::move(sendBuffer.messages);
+			sendBuffer.messages.clear();
 		}
 		std::unique_lock network_lock(networkMutex);
-		server.send(*this, std::move(moved_buffer), true);
+		server.send(*this, std::move(messages));
 	}
 
 	void RemoteClient::stopBuffering() {
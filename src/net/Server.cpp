@@ -2,7 +2,6 @@
 #include "entity/ServerPlayer.h"
 #include "game/Inventory.h"
 #include "game/ServerGame.h"
-#include "game/SimulationOptions.h"
 #include "net/NetError.h"
 #include "net/Server.h"
 #include "net/GenericClient.h"
@@ -57,21 +56,40 @@ namespace Game3 {
 		if (message.empty())
 			return;
 
+		send(client, std::make_shared<const std::vector<uint8_t>>(message.begin(), message.end()), force);
+	}
+
+	void Server::send(RemoteClient &client, FramedPacket message, bool force) {
+		if (!message || message->empty())
+			return;
+
 		if (!force && client.isBuffering()) {
 			SendBuffer &buffer = client.sendBuffer;
 			auto lock = buffer.uniqueLock();
-			buffer.bytes.insert(buffer.bytes.end(), message.begin(), message.end());
+			buffer.messages.push_back(std::move(message));
 			return;
 		}
 
 		std::weak_ptr weak_client(std::static_pointer_cast<RemoteClient>(client.shared_from_this()));
 
-		client.strand.post([this, weak_client, message = std::move(message)]() mutable {
+		client.strand.post([weak_client, message = std::move(message)]() mutable {
 			if (std::shared_ptr<RemoteClient> client = weak_client.lock())
 				client->queue(std::move(message));
 		});
 	}
 
+	void Server::send(RemoteClient &client, std::vector<FramedPacket> messages) {
+		if (messages.empty())
+			return;
+
+		std::weak_ptr weak_client(std::static_pointer_cast<RemoteClient>(client.shared_from_this()));
+
+		client.strand.post([weak_client, messages = std::move(messages)]() mutable {
+			if (std::shared_ptr<RemoteClient> client = weak_client.lock())
+				client->queue(std::move(messages));
+		});
+	}
+
 	void Server::accept() {
 		INFO("Accepting.");
 		acceptor.async_accept([this](const asio::error_code &errc, asio::ip::tcp::socket socket) {
@@ -295,15 +313,15 @@ namespace Game3 {
 		game->initInteractionSets();
 
 		std::thread tick_thread([&] {
-			while (running) {
+			game->getTickScheduler().run(running, [&] {
 				if (!game->tickingPaused)
 					game->tick();
-				std::this_thread::sleep_for(std::chrono::milliseconds(SERVER_TICK_PERIOD));
-			}
+			});
 		});
 
 		std::mutex save_mutex;
-		std::chrono::seconds save_period{120};
+		// Autosaves only rewrite changed chunks and don't pause ticking, so they can be frequent.
+		std::chrono::seconds save_period{30};
 
 		std::thread save_thread([&] {
 			std::chrono::time_point last_save = std::chrono::system_clock::now();
@@ -316,10 +334,12 @@ namespace Game3 {
 
 				if (running && save_period <= std::chrono::system_clock::now() - last_save) {
 					INFO("Autosaving...");
-					game->tickingPaused = true;
-					game->database.writeAll();
-					game->tickingPaused = false;
-					INFO("Autosaved.");
+					try {
+						game->database.autosave();
+						INFO("Autosaved.");
+					} catch (const std::exception &err) {
+						ERROR("Autosave failed: " << err.what());
+					}
 					last_save = std::chrono::system_clock::now();
 				}
 			}
@@ -15,19 +15,20 @@ namespace Game3 {
 	realmID(realm.id), chunkPosition(chunk_position), updateCounter(update_counter) {
 		tiles.reserve(CHUNK_SIZE * CHUNK_SIZE * LAYER_COUNT);
 		for (const Layer layer: allLayers) {
-			const TileChunk &layer_tiles = realm.tileProvider.getTileChunk(layer, chunk_position);
-			auto lock = layer_tiles.sharedLock();
-			tiles.insert(tiles.end(), layer_tiles.begin(), layer_tiles.end());
+			const auto layer_tiles = realm.tileProvider.getTileChunk(layer, chunk_position);
+			auto lock = layer_tiles->sharedLock();
+			tiles.insert(tiles.end(), layer_tiles->begin(), layer_tiles->end());
 		}
 
-		const FluidChunk &fluid_chunk = realm.tileProvider.getFluidChunk(chunk_position);
-		auto lock = fluid_chunk.sharedLock();
-		fluids = fluid_chunk;
+		const auto fluid_chunk = realm.tileProvider.getFluidChunk(chunk_position);
+		auto lock = fluid_chunk->sharedLock();
+		fluids = *fluid_chunk;
 	}
 
-	ChunkTilesPacket::ChunkTilesPacket(Realm &realm, ChunkPosition chunk_position): ChunkTilesPacket(realm, chunk_position, 0) {
-		updateCounter = realm.tileProvider.getUpdateCounter(chunk_position);
-	}
+	// The counter is read before the tiles are copied. Writes can land between the layers being copied, and reading the counter
+	// first means the client re-requests the chunk afterward instead of believing it's up to date.
+	ChunkTilesPacket::ChunkTilesPacket(Realm &realm, ChunkPosition chunk_position):
+		ChunkTilesPacket(realm, chunk_position, realm.tileProvider.getUpdateCounter(chunk_position)) {}
 
 	void ChunkTilesPacket::encode(Game &, Buffer &buffer) const {
 		Buffer secondary;
@@ -57,12 +58,11 @@ namespace Game3 {
 		TileProvider &provider = realm->tileProvider;
 
 		for (const Layer layer: allLayers) {
-			auto &chunk = provider.getTileChunk(layer, chunkPosition);
 			const size_t offset = getIndex(layer) * CHUNK_SIZE * CHUNK_SIZE;
-			chunk = std::vector<TileID>(tiles.begin() + offset, tiles.begin() + offset + CHUNK_SIZE * CHUNK_SIZE);
+			*provider.getTileChunk(layer, chunkPosition) = std::vector<TileID>(tiles.begin() + offset, tiles.begin() + offset + CHUNK_SIZE * CHUNK_SIZE);
 		}
 
-		provider.getFluidChunk(chunkPosition) = std::move(fluids);
+		*provider.getFluidChunk(chunkPosition) = std::move(fluids);
 
 		provider.setUpdateCounter(chunkPosition, updateCounter);
 
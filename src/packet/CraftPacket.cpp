@@ -24,8 +24,12 @@ namespace Game3 {
 		std::optional<std::vector<ItemStack>> leftovers;
 
 		for (size_t i = 0; i < count; ++i) {
-			if (!recipe->craft(game, inventory, inventory, leftovers))
-				break;
+			{
+				// Crafting uses a transaction, which needs the inventory locked throughout.
+				auto inventory_lock = inventory->uniqueLock();
+				if (!recipe->craft(game, inventory, inventory, leftovers))
+					break;
+			}
 
 			if (leftovers) {
 				for (const auto &leftover: *leftovers)
@@ -3,6 +3,7 @@
 #include "pipes/EnergyNetwork.h"
 #include "realm/Realm.h"
 #include "tileentity/EnergeticTileEntity.h"
+#include "util/Profiler.h"
 
 namespace Game3 {
 	EnergyNetwork::EnergyNetwork(size_t id_, const std::shared_ptr<Realm> &realm):
@@ -13,6 +14,7 @@ namespace Game3 {
 			return;
 
 		PipeNetwork::tick(tick_id);
+		PROFILE_ZONE("TickPipes");
 
 		auto this_lock = uniqueLock();
 
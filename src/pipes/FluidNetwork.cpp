@@ -3,6 +3,7 @@
 #include "pipes/FluidNetwork.h"
 #include "realm/Realm.h"
 #include "tileentity/FluidHoldingTileEntity.h"
+#include "util/Profiler.h"
 
 namespace Game3 {
 	FluidNetwork::FluidNetwork(size_t id_, const std::shared_ptr<Realm> &realm_):
@@ -14,6 +15,7 @@ namespace Game3 {
 			return;
 
 		PipeNetwork::tick(tick_id);
+		PROFILE_ZONE("TickPipes");
 
 		auto this_lock = uniqueLock();
 
@@ -83,7 +83,7 @@ namespace Game3 {
 		if (data < other.data)
 			return true;
 
-		if (data > other.data)
+		if (other.data < data)
 			return false;
 
 		if (comparator < other.comparator)
@@ -6,6 +6,7 @@
 #include "realm/Realm.h"
 #include "tileentity/InventoriedTileEntity.h"
 #include "tileentity/Pipe.h"
+#include "util/Profiler.h"
 
 namespace Game3 {
 	void ItemNetwork::tick(Tick tick_id) {
@@ -13,6 +14,7 @@ namespace Game3 {
 			return;
 
 		PipeNetwork::tick(tick_id);
+		PROFILE_ZONE("TickPipes");
 
 		auto this_lock = uniqueLock();
 
@@ -0,0 +1,69 @@
+#include "Log.h"
+#include "data/GameDB.h"
+#include "game/ServerGame.h"
+#include "realm/ChunkPrefetcher.h"
+#include "realm/Realm.h"
+
+namespace Game3 {
+	ChunkPrefetcher::ChunkPrefetcher(Realm &realm_):
+		realm(realm_) {}
+
+	void ChunkPrefetcher::request(ChunkPosition chunk_position) {
+		if (MAX_IN_FLIGHT <= inFlight.size() || inFlight.contains(chunk_position) || unavailable.contains(chunk_position))
+			return;
+
+		ServerGame &game = realm.getGame().toServer();
+		if (!game.database.isOpen())
+			return;
+
+		inFlight.insert(chunk_position);
+
+		const bool added = game.getChunkLoadPool().add([weak_game = std::weak_ptr(game.shared_from_this()), weak_realm = realm.weak_from_this(), chunk_position](ThreadPool &, size_t) {
+			GamePtr game = weak_game.lock();
+			std::shared_ptr<Realm> realm = weak_realm.lock();
+			if (!game || !realm)
+				return;
+
+			std::optional<ChunkSet> chunk_set;
+
+			try {
+				if (GameDB &database = game->toServer().database; database.isOpen())
+					chunk_set = database.getChunk(realm->id, chunk_position);
+			} catch (const std::exception &err) {
+				ERROR("Couldn't load chunk " << chunk_position << " in realm " << realm->id << ": " << err.what());
+			}
+
+			realm->queue([realm = realm.get(), chunk_position, chunk_set = std::move(chunk_set)]() mutable {
+				realm->chunkPrefetcher.finish(chunk_position, std::move(chunk_set));
+			});
+		});
+
+		if (!added)
+			inFlight.erase(chunk_position);
+	}
+
+	bool ChunkPrefetcher::isPending(ChunkPosition chunk_position) const {
+		return inFlight.contains(chunk_position);
+	}
+
+	bool ChunkPrefetcher::isUnavailable(ChunkPosition chunk_position) const {
+		return unavailable.contains(chunk_position);
+	}
+
+	void ChunkPrefetcher::reset(ChunkPosition chunk_position) {
+		unavailable.erase(chunk_position);
+	}
+
+	void ChunkPrefetcher::finish(ChunkPosition chunk_position, std::optional<ChunkSet> chunk_set) {
+		inFlight.erase(chunk_position);
+
+		if (!chunk_set) {
+			WARN("Chunk " << chunk_position << " in realm " << realm.id << " isn't in the database");
+			unavailable.insert(chunk_position);
+			return;
+		}
+
+		// Does nothing if the chunk was created or paged in synchronously while this load was running.
+		realm.tileProvider.storeLoaded(chunk_position, std::move(*chunk_set));
+	}
+}
@@ -12,6 +12,7 @@
 #include "graphics/SpriteRenderer.h"
 #include "graphics/TextRenderer.h"
 #include "graphics/Tileset.h"
+#include "net/FramedPacket.h"
 #include "net/RemoteClient.h"
 #include "packet/ErrorPacket.h"
 #include "packet/InteractPacket.h"
@@ -19,11 +20,13 @@
 #include "realm/Realm.h"
 #include "realm/RealmFactory.h"
 #include "threading/ThreadContext.h"
+#include "threading/ThreadPool.h"
+#include "threading/Waiter.h"
 #include "tile/Tile.h"
 #include "ui/Canvas.h"
 #include "ui/MainWindow.h"
 #include "util/Cast.h"
-#include "util/Timer.h"
+#include "util/Profiler.h"
 #include "util/Util.h"
 #include "worldgen/Carpet.h"
 #include "worldgen/House.h"
@@ -33,14 +36,37 @@
 #include <thread>
 #include <unordered_set>
 
-// #define PROFILE_TICKS
-
 namespace Game3 {
+	namespace {
+		/** Chunks this far apart on both axes tick in the same phase. Two concurrent chunk ticks can each reach
+		 *  PARALLEL_TICK_REACH chunks, so their areas must be separated by at least that much twice over. */
+		constexpr ChunkPosition::IntType PARALLEL_TICK_STRIDE = 2 * Realm::PARALLEL_TICK_REACH + 1;
+
+		/** A set of chunks at least PARALLEL_TICK_STRIDE apart that pool threads claim one at a time. */
+		struct ChunkTickBatch {
+			std::vector<ChunkPosition> chunks;
+			std::atomic_size_t next = 0;
+			Waiter waiter;
+
+			ChunkTickBatch(std::vector<ChunkPosition> chunks_):
+				chunks(std::move(chunks_)), waiter(chunks.size()) {}
+
+			/** Ticks unclaimed chunks until none remain. Exceptions are kept for the waiting thread to rethrow. */
+			template <typename Fn>
+			void drain(const Fn &tick_chunk) noexcept {
+				for (size_t index = next++; index < chunks.size(); index = next++)
+					waiter.run([&] { tick_chunk(chunks[index]); });
+			}
+		};
+	}
+
 	void from_json(const nlohmann::json &json, RealmDetails &details) {
 		details.tilesetName = json.at("tileset");
 	}
 
 	Realm::Realm(Game &game_): game(game_) {
+		initChunkLoader();
+
 		if (game.getSide() == Side::Client) {
 			game.toClient().getWindow().queue([this] {
 				createRenderers();
@@ -54,6 +80,8 @@ namespace Game3 {
 
 	Realm::Realm(Game &game_, RealmID id_, RealmType type_, Identifier tileset_id, int64_t seed_):
 	id(id_), type(std::move(type_)), tileProvider(std::move(tileset_id)), seed(seed_), game(game_) {
+		initChunkLoader();
+
 		if (game.getSide() == Side::Client) {
 			game.toClient().getWindow().queue([this] {
 				createRenderers();
@@ -100,6 +128,28 @@ namespace Game3 {
 
 	void Realm::initTexture() {}
 
+	void Realm::initChunkLoader() {
+		if (game.getSide() != Side::Server)
+			return;
+
+		tileProvider.chunkLoader = [this](ChunkPosition chunk_position) -> std::optional<ChunkSet> {
+			GameDB &database = game.toServer().database;
+			if (!database.isOpen())
+				return std::nullopt;
+			return database.getChunk(id, chunk_position);
+		};
+
+		// Pathmaps aren't stored in the database. Reading an evicted chunk loads it on the reading thread, which can be
+		// a pathfinding thread in the middle of building pathGraph, so the caches built from pathmaps are invalidated later.
+		tileProvider.onChunkLoaded = [this](ChunkPosition chunk_position) {
+			fillPathChunk(chunk_position);
+			queue([this, chunk_position] {
+				pathGraph.invalidate(chunk_position);
+				invalidateFlowFields();
+			});
+		};
+	}
+
 	RealmPtr Realm::fromJSON(Game &game, const nlohmann::json &json, bool full_data) {
 		const RealmType type = json.at("type");
 		auto factory = game.registry<RealmFactoryRegistry>().at(type);
@@ -365,7 +415,7 @@ namespace Game3 {
 		if (entity->isPlayer()) {
 			{
 				auto lock = players.uniqueLock();
-				players.emplace(safeDynamicCast<Player>(entity));
+				players.insert(safeDynamicCast<Player>(entity));
 			}
 			recalculateVisibleChunks();
 		}
@@ -394,7 +444,8 @@ namespace Game3 {
 			std::unique_lock<std::shared_mutex> path_lock;
 			tileProvider.findPathState(tile_entity->position.copyBase(), &path_lock) = 0;
 		}
-		tile_entity->onSpawn();
+		if (!scratch)
+			tile_entity->onSpawn();
 		return tile_entity;
 	}
 
@@ -413,9 +464,7 @@ namespace Game3 {
 		if (ticking.exchange(true))
 			return;
 
-#ifdef PROFILE_TICKS
-		Timer realm_timer{"TickRealm"};
-#endif
+		PROFILE_ZONE("TickRealm");
 
 		for (const auto &[entity, position]: entityInitializationQueue.steal())
 			initEntity(entity, position);
@@ -431,6 +480,7 @@ namespace Game3 {
 			std::vector<RemoteClient::BufferGuard> guards;
 
 			{
+				PROFILE_ZONE("TickPlayers");
 				auto lock = players.sharedLock();
 				guards.reserve(players.size());
 				for (const auto &weak_player: players) {
@@ -446,110 +496,85 @@ namespace Game3 {
 				}
 			}
 
+			// Visible chunks that were evicted are paged in off the tick thread and skipped until they arrive.
+			// Ticking them before then would page them in here instead.
+			std::vector<ChunkPosition> chunks;
 			{
 				auto visible_lock = visibleChunks.sharedLock();
-				for (const auto &chunk: visibleChunks) {
-					{
-						auto by_chunk_lock = entitiesByChunk.sharedLock();
-						if (auto iter = entitiesByChunk.find(chunk); iter != entitiesByChunk.end() && iter->second) {
-							auto set_lock = iter->second->sharedLock();
-							by_chunk_lock.unlock();
-							for (const auto &entity: *iter->second) {
-								if (!entity->isPlayer()) {
-#ifdef PROFILE_TICKS
-									Timer timer{"TickEntity"};
-#endif
-									entity->tick(game, delta);
-								}
-							}
-						}
-					}
-					{
-						auto by_chunk_lock = tileEntitiesByChunk.sharedLock();
-						if (auto iter = tileEntitiesByChunk.find(chunk); iter != tileEntitiesByChunk.end() && iter->second) {
-							auto set = iter->second;
-							auto set_lock = set->sharedLock();
-							by_chunk_lock.unlock();
-							for (const auto &tile_entity: *set) {
-#ifdef PROFILE_TICKS
-								Timer timer{"TickTileEntity"};
-#endif
-								tile_entity->tick(game, delta);
-							}
-						}
-					}
-					std::uniform_int_distribution<int64_t> distribution{0, CHUNK_SIZE - 1};
-					auto &tileset = getTileset();
-					auto shared = shared_from_this();
-
-#ifdef PROFILE_TICKS
-					Timer timer{"RandomTicks"};
-#endif
-					for (size_t i = 0; i < game.randomTicksPerChunk; ++i) {
-						const Position position(chunk.y * CHUNK_SIZE + distribution(threadContext.rng), chunk.x * CHUNK_SIZE + distribution(threadContext.rng));
-
-						for (const Layer layer: mainLayers)
-							if (auto tile_id = tileProvider.tryTile(layer, position); tile_id && *tile_id != 0)
-								game.getTile(tileset[*tile_id])->randomTick({position, shared, nullptr});
-					}
-				}
+				chunks.reserve(visibleChunks.size());
+				for (const ChunkPosition chunk_position: visibleChunks)
+					if (!generatedChunks.contains(chunk_position) || prefetchChunk(chunk_position))
+						chunks.push_back(chunk_position);
+			}
+
+			startRandomTicks();
+
+			if (game.toServer().getRule("parallelChunkTicks").value_or(0) != 0) {
+				tickChunksInParallel(std::move(chunks), delta);
+			} else {
+				for (const ChunkPosition chunk_position: chunks)
+					tickChunk(chunk_position, delta);
 			}
 
-			for (const auto &stolen: entityRemovalQueue.steal())
-				if (auto locked = stolen.lock())
+			finishRandomTicks();
+
+			drainBudgeted(TickPhase::EntityRemoval, entityRemovalQueue, [this](const std::weak_ptr<Entity> &weak) {
+				if (auto locked = weak.lock())
 					remove(locked);
+			});
 
-			for (const auto &stolen: entityDestructionQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::EntityDestruction, entityDestructionQueue, [](const std::weak_ptr<Entity> &weak) {
+				if (auto locked = weak.lock())
 					locked->destroy();
+			});
 
-			for (const auto &stolen: tileEntityRemovalQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::TileEntityRemoval, tileEntityRemovalQueue, [this](const std::weak_ptr<TileEntity> &weak) {
+				if (auto locked = weak.lock())
 					remove(locked);
+			});
 
-			for (const auto &stolen: tileEntityDestructionQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::TileEntityDestruction, tileEntityDestructionQueue, [](const std::weak_ptr<TileEntity> &weak) {
+				if (auto locked = weak.lock())
 					locked->destroy();
+			});
 
-			for (const auto &stolen: playerRemovalQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::PlayerRemoval, playerRemovalQueue, [this](const std::weak_ptr<Player> &weak) {
+				if (auto locked = weak.lock())
 					removePlayer(locked);
+			});
 
-			for (const auto &stolen: generalQueue.steal())
-				stolen();
+			drainBudgeted(TickPhase::General, generalQueue, [](const std::function<void()> &function) {
+				function();
+			});
 
-			if (!tileProvider.generationQueue.empty()) {
+			if (canGenerateInBackground()) {
+				tickGeneration();
+			} else if (!tileProvider.generationQueue.empty()) {
 				const auto chunk_position = tileProvider.generationQueue.take();
 				if (!generatedChunks.contains(chunk_position)) {
 					tileProvider.ensureAllChunks(chunk_position);
 					generateChunk(chunk_position);
 					generatedChunks.insert(chunk_position);
 					remakePathMap(chunk_position);
-					auto lock = chunkRequests.uniqueLock();
-					if (auto iter = chunkRequests.find(chunk_position); iter != chunkRequests.end()) {
-						std::unordered_set<std::shared_ptr<RemoteClient>> strong;
-						for (const auto &weak: iter->second)
-							if (auto locked = weak.lock())
-								strong.insert(locked);
-						sendToMany(strong, chunk_position);
-						chunkRequests.erase(iter);
-					}
+					sendRequestedChunk(chunk_position);
 				}
 			} else {
 				auto lock = chunkRequests.uniqueLock();
 
-				if (!chunkRequests.empty()) {
-					auto iter = chunkRequests.begin();
+				for (auto iter = chunkRequests.begin(); iter != chunkRequests.end(); ++iter) {
 					const auto &[chunk_position, client_set] = *iter;
 
 					if (!generatedChunks.contains(chunk_position)) {
 						generateChunk(chunk_position);
 						generatedChunks.insert(chunk_position);
 						remakePathMap(chunk_position);
+					} else if (!prefetchChunk(chunk_position)) {
+						continue;
 					}
 
 					sendToMany(filterWeak(client_set), chunk_position);
 					chunkRequests.erase(iter);
+					break;
 				}
 			}
 
@@ -575,24 +600,29 @@ namespace Game3 {
 
 			ticking = false;
 
-			for (const auto &stolen: entityRemovalQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::EntityRemoval, entityRemovalQueue, [this](const std::weak_ptr<Entity> &weak) {
+				if (auto locked = weak.lock())
 					removeSafe(locked);
+			});
 
-			for (const auto &stolen: entityDestructionQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::EntityDestruction, entityDestructionQueue, [](const std::weak_ptr<Entity> &weak) {
+				if (auto locked = weak.lock())
 					locked->destroy();
+			});
 
-			for (const auto &stolen: tileEntityRemovalQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::TileEntityRemoval, tileEntityRemovalQueue, [this](const std::weak_ptr<TileEntity> &weak) {
+				if (auto locked = weak.lock())
 					removeSafe(locked);
+			});
 
-			for (const auto &stolen: tileEntityDestructionQueue.steal())
-				if (auto locked = stolen.lock())
+			drainBudgeted(TickPhase::TileEntityDestruction, tileEntityDestructionQueue, [](const std::weak_ptr<TileEntity> &weak) {
+				if (auto locked = weak.lock())
 					locked->destroy();
+			});
 
-			for (const auto &stolen: generalQueue.steal())
-				stolen();
+			drainBudgeted(TickPhase::General, generalQueue, [](const std::function<void()> &function) {
+				function();
+			});
 
 			if (renderersReady) {
 				Index row_index = 0;
@@ -627,6 +657,211 @@ namespace Game3 {
 		ticking = false;
 	}
 
+	void Realm::tickGeneration() {
+		for (const ChunkPosition chunk_position: tileProvider.generationQueue.steal())
+			if (!generatedChunks.contains(chunk_position))
+				generationPipeline.request(chunk_position);
+
+		std::vector<ChunkPosition> player_chunks;
+		{
+			auto lock = players.sharedLock();
+			player_chunks.reserve(players.size());
+			for (const auto &weak_player: players)
+				if (auto player = weak_player.lock())
+					player_chunks.push_back(player->getChunk());
+		}
+
+		for (const auto &[chunk_position, scratch]: generationPipeline.tick(player_chunks)) {
+			if (scratch && !generatedChunks.contains(chunk_position)) {
+				absorbGenerated(chunk_position, *scratch);
+				sendRequestedChunk(chunk_position);
+			}
+		}
+
+		// Requests for chunks that already exist don't need to wait for the pipeline.
+		auto lock = chunkRequests.uniqueLock();
+		for (auto iter = chunkRequests.begin(); iter != chunkRequests.end(); ++iter) {
+			const auto &[chunk_position, client_set] = *iter;
+
+			if (generatedChunks.contains(chunk_position)) {
+				if (!prefetchChunk(chunk_position))
+					continue;
+				sendToMany(filterWeak(client_set), chunk_position);
+				chunkRequests.erase(iter);
+				break;
+			}
+
+			if (!generationPipeline.isPending(chunk_position))
+				generationPipeline.request(chunk_position);
+		}
+	}
+
+	void Realm::absorbGenerated(ChunkPosition chunk_position, Realm &scratch) {
+		std::vector<TileEntityPtr> spawned;
+
+		{
+			auto lock = scratch.tileEntities.sharedLock();
+			for (const auto &[position, tile_entity]: scratch.tileEntities)
+				if (position.getChunk() == chunk_position)
+					spawned.push_back(tile_entity);
+		}
+
+		{
+			auto guard = guardGeneration();
+			tileProvider.absorb(chunk_position, scratch.tileProvider.getChunkSet(chunk_position));
+
+			for (const TileEntityPtr &tile_entity: spawned)
+				add(tile_entity);
+
+			// The scratch realm had no neighboring chunks, so the edges need to be autotiled against the real neighbors.
+			const auto [top, left] = chunk_position.topLeft();
+			const auto [bottom, right] = chunk_position.bottomRight();
+			for (const Layer layer: mainLayers) {
+				for (Index column = left; column <= right; ++column) {
+					autotile({top, column}, layer);
+					autotile({bottom, column}, layer);
+				}
+				for (Index row = top + 1; row < bottom; ++row) {
+					autotile({row, left}, layer);
+					autotile({row, right}, layer);
+				}
+			}
+		}
+
+		generatedChunks.insert(chunk_position);
+		remakePathMap(chunk_position);
+		tileProvider.updateChunk(chunk_position);
+	}
+
+	bool Realm::prefetchChunk(ChunkPosition chunk_position) {
+		if (tileProvider.isLoaded(chunk_position) || chunkPrefetcher.isUnavailable(chunk_position))
+			return true;
+		chunkPrefetcher.request(chunk_position);
+		return false;
+	}
+
+	void Realm::sendRequestedChunk(ChunkPosition chunk_position) {
+		auto lock = chunkRequests.uniqueLock();
+		if (auto iter = chunkRequests.find(chunk_position); iter != chunkRequests.end()) {
+			std::unordered_set<std::shared_ptr<RemoteClient>> strong;
+			for (const auto &weak: iter->second)
+				if (auto locked = weak.lock())
+					strong.insert(locked);
+			sendToMany(strong, chunk_position);
+			chunkRequests.erase(iter);
+		}
+	}
+
+	void Realm::tickChunk(ChunkPosition chunk, float delta) {
+		{
+			auto by_chunk_lock = entitiesByChunk.sharedLock();
+			if (auto iter = entitiesByChunk.find(chunk); iter != entitiesByChunk.end() && iter->second) {
+				auto set = iter->second;
+				auto set_lock = set->sharedLock();
+				by_chunk_lock.unlock();
+				PROFILE_ZONE("TickEntities");
+				for (const auto &entity: *set)
+					if (!entity->isPlayer())
+						entity->tick(game, delta);
+			}
+		}
+		{
+			auto by_chunk_lock = tileEntitiesByChunk.sharedLock();
+			if (auto iter = tileEntitiesByChunk.find(chunk); iter != tileEntitiesByChunk.end() && iter->second) {
+				auto set = iter->second;
+				auto set_lock = set->sharedLock();
+				by_chunk_lock.unlock();
+				PROFILE_ZONE("TickTileEntities");
+				for (const auto &tile_entity: *set)
+					tile_entity->tick(game, delta);
+			}
+		}
+		if (randomTickNanosLeft <= 0) {
+			randomTicksSkipped += game.randomTicksPerChunk;
+			return;
+		}
+
+		std::uniform_int_distribution<int64_t> distribution{0, CHUNK_SIZE - 1};
+		auto &tileset = getTileset();
+		auto shared = shared_from_this();
+
+		PROFILE_ZONE("RandomTicks");
+		const auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < game.randomTicksPerChunk; ++i) {
+			const Position position(chunk.y * CHUNK_SIZE + distribution(threadContext.rng), chunk.x * CHUNK_SIZE + distribution(threadContext.rng));
+
+			for (const Layer layer: mainLayers)
+				if (auto tile_id = tileProvider.tryTile(layer, position); tile_id && *tile_id != 0)
+					game.getTile(tileset[*tile_id])->randomTick({position, shared, nullptr});
+		}
+		randomTickNanosLeft -= std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		tickPhaseStats[static_cast<size_t>(TickPhase::RandomTicks)].processed += game.randomTicksPerChunk;
+	}
+
+	const TickBudgets & Realm::getTickBudgets() const {
+		if (isServer())
+			return game.toServer().getTickBudgets();
+		static const TickBudgets defaults;
+		return defaults;
+	}
+
+	void Realm::startRandomTicks() {
+		const std::chrono::microseconds budget = getTickBudgets().get(TickPhase::RandomTicks);
+		randomTickNanosLeft = budget.count() < 0? INT64_MAX : std::chrono::duration_cast<std::chrono::nanoseconds>(budget).count();
+		randomTicksSkipped = 0;
+	}
+
+	void Realm::finishRandomTicks() {
+		if (const uint64_t skipped = randomTicksSkipped.exchange(0); skipped != 0) {
+			TickPhaseStats &stats = tickPhaseStats[static_cast<size_t>(TickPhase::RandomTicks)];
+			++stats.starvedTicks;
+			stats.deferred += skipped;
+		}
+	}
+
+	void Realm::tickChunksInParallel(std::vector<ChunkPosition> chunks, float delta) {
+		// Chunks of the same color are PARALLEL_TICK_STRIDE apart, so the chunks within PARALLEL_TICK_REACH of one of them
+		// are never within reach of another chunk ticking at the same time.
+		auto wrap = [](ChunkPosition::IntType coordinate) {
+			return ((coordinate % PARALLEL_TICK_STRIDE) + PARALLEL_TICK_STRIDE) % PARALLEL_TICK_STRIDE;
+		};
+
+		std::array<std::vector<ChunkPosition>, PARALLEL_TICK_STRIDE * PARALLEL_TICK_STRIDE> colors;
+		for (const ChunkPosition chunk: chunks)
+			colors[wrap(chunk.x) + wrap(chunk.y) * PARALLEL_TICK_STRIDE].push_back(chunk);
+
+		ThreadPool &pool = game.toServer().getChunkPool();
+		auto tick_chunk = [shared = shared_from_this(), delta](ChunkPosition chunk) {
+			shared->tickChunk(chunk, delta);
+		};
+
+		tickingChunksInParallel = true;
+		// Cleared even if a chunk tick throws. Effects queued because they reach too far run later in this realm's tick.
+		struct Reset {
+			std::atomic_bool &flag;
+			~Reset() { flag = false; }
+		} reset{tickingChunksInParallel};
+
+		for (std::vector<ChunkPosition> &color: colors) {
+			if (color.empty())
+				continue;
+
+			auto batch = std::make_shared<ChunkTickBatch>(std::move(color));
+			const size_t helpers = std::min(batch->chunks.size() - 1, pool.getSize());
+
+			for (size_t i = 0; i < helpers; ++i) {
+				pool.add([batch, tick_chunk](ThreadPool &, size_t) {
+					batch->drain(tick_chunk);
+				});
+			}
+
+			// The ticking thread claims chunks too, so the batch finishes even if every pool thread is busy.
+			batch->drain(tick_chunk);
+			batch->waiter.wait();
+			batch->waiter.rethrow();
+		}
+	}
+
 	std::vector<EntityPtr> Realm::findEntities(const Position &position) const {
 		EntitySet entity_set = getEntities(position.getChunk());
 
@@ -644,77 +879,62 @@ namespace Game3 {
 	}
 
 	std::vector<EntityPtr> Realm::findEntitiesSquare(const Position &position, uint64_t radius) const {
-		if (radius == 1)
-			return findEntities(position);
-
-		if (radius == 0)
-			return {};
-
-		std::vector<EntityPtr> out;
-
-		const Position offset(radius - 1, radius - 1);
-		ChunkRange((position - offset).getChunk(), (position + offset).getChunk()).iterate([this, &out, position, radius](ChunkPosition chunk_position) {
-			EntitySet entity_set = getEntities(chunk_position);
-			if (!entity_set)
-				return;
-
-			auto lock = entity_set->sharedLock();
-			for (const EntityPtr &entity: *entity_set)
-				if (entity->position.copyBase().maximumAxisDistance(position) < radius)
-					out.push_back(entity);
+		return findEntitiesSquare(position, radius, [](const EntityPtr &) {
+			return true;
 		});
-
-		return out;
 	}
 
 	std::vector<EntityPtr> Realm::findEntitiesSquare(const Position &position, uint64_t radius, const std::function<bool(const EntityPtr &)> &filter) const {
 		if (radius == 1)
 			return findEntities(position);
 
-		if (radius == 0)
-			return {};
-
 		std::vector<EntityPtr> out;
 
-		const Position offset(radius - 1, radius - 1);
-		ChunkRange((position - offset).getChunk(), (position + offset).getChunk()).iterate([this, &out, &filter, position, radius](ChunkPosition chunk_position) {
-			EntitySet entity_set = getEntities(chunk_position);
-			if (!entity_set)
-				return;
-
-			auto lock = entity_set->sharedLock();
-			for (const EntityPtr &entity: *entity_set)
-				if (entity->position.copyBase().maximumAxisDistance(position) < radius && filter(entity))
-					out.push_back(entity);
+		visitEntitiesSquare(position, radius, [&](const EntityPtr &entity) {
+			if (filter(entity))
+				out.push_back(entity);
+			return false;
 		});
 
 		return out;
 	}
 
 	bool Realm::hasEntitiesSquare(const Position &position, uint64_t radius, const std::function<bool(const EntityPtr &)> &predicate) const {
-		if (radius == 0)
-			return false;
+		return visitEntitiesSquare(position, radius, [&](const EntityPtr &entity) {
+			return predicate(entity);
+		});
+	}
 
-		bool out = false;
+	bool Realm::visitEntitiesSquare(const Position &position, uint64_t radius, const std::function<bool(const EntityPtr &)> &visitor) const {
+		// Reused between queries so that they don't allocate once warmed up. Taken rather than referenced in case the visitor
+		// makes a query of its own.
+		thread_local std::vector<GlobalID> reusable_gids;
+		std::vector<GlobalID> gids = std::move(reusable_gids);
+		gids.clear();
 
-		const Position offset(radius - 1, radius - 1);
-		ChunkRange((position - offset).getChunk(), (position + offset).getChunk()).iterate([this, &out, &predicate, position, radius](ChunkPosition chunk_position) {
-			EntitySet entity_set = getEntities(chunk_position);
-			if (!entity_set)
+		{
+			auto lock = entityIndex.sharedLock();
+			entityIndex.visitSquare(position, radius, [&gids](GlobalID gid, const Position &) {
+				gids.push_back(gid);
 				return false;
+			});
+		}
 
-			auto lock = entity_set->sharedLock();
-			for (const EntityPtr &entity: *entity_set) {
-				if (entity->position.copyBase().maximumAxisDistance(position) < radius && predicate(entity)) {
-					out = true;
-					return true;
+		bool stopped = false;
+
+		if (!gids.empty()) {
+			// The index lock is released first because attach and detach are called with entitiesByGID locked.
+			auto lock = entitiesByGID.sharedLock();
+			for (const GlobalID gid: gids) {
+				if (auto iter = entitiesByGID.find(gid); iter != entitiesByGID.end() && visitor(iter->second)) {
+					stopped = true;
+					break;
 				}
 			}
+		}
 
-			return false;
-		});
-
-		return out;
+		reusable_gids = std::move(gids);
+		return stopped;
 	}
 
 	std::vector<EntityPtr> Realm::findEntities(const Position &position, const EntityPtr &except) {
@@ -782,6 +1002,12 @@ namespace Game3 {
 			}
 		}
 
+		{
+			auto lock = entityIndex.uniqueLock();
+			if (entityIndex.remove(entity->getGID()) && can_warn)
+				WARN("Still present in Realm " << id << "'s entityIndex");
+		}
+
 		{
 			auto lock = entitiesByChunk.sharedLock();
 			for (const auto &[chunk_position, set]: entitiesByChunk) {
@@ -829,6 +1055,11 @@ namespace Game3 {
 	}
 
 	void Realm::onMoved(const EntityPtr &entity, const Position &position) {
+		{
+			auto lock = entityIndex.uniqueLock();
+			entityIndex.move(entity->getGID(), position);
+		}
+
 		if (auto tile_entity = tileEntityAt(position))
 			tile_entity->onOverlap(entity);
 	}
@@ -897,10 +1128,10 @@ namespace Game3 {
 		}
 
 		if (isServer()) {
-			if (!isGenerating()) {
-				tileProvider.updateChunk(position.getChunk());
+			// The update counter is bumped even during generation so that the chunk is known to need saving.
+			tileProvider.updateChunk(position.getChunk());
+			if (!isGenerating())
 				getGame().toServer().broadcastTileUpdate(id, layer, position, tile_id);
-			}
 			if (run_helper)
 				setLayerHelper(position.row, position.column, layer, context);
 		} else if (run_helper) {
@@ -921,9 +1152,10 @@ namespace Game3 {
 			fluid = tile;
 		}
 
-		if (isServer() && !isGenerating()) {
+		if (isServer()) {
 			tileProvider.updateChunk(position.getChunk());
-			getGame().toServer().broadcastFluidUpdate(id, position, tile);
+			if (!isGenerating())
+				getGame().toServer().broadcastFluidUpdate(id, position, tile);
 		}
 	}
 
@@ -1111,6 +1343,7 @@ namespace Game3 {
 	}
 
 	Realm::ChunkPackets Realm::getChunkPackets(ChunkPosition chunk_position) {
+		tileProvider.ensureLoaded(chunk_position);
 		ChunkTilesPacket chunk_tiles(*this, chunk_position);
 		std::vector<EntityPacket> entity_packets;
 		std::vector<TileEntityPacket> tile_entity_packets;
@@ -1131,11 +1364,8 @@ namespace Game3 {
 	}
 
 	void Realm::remakePathMap() {
-		const auto &tileset = getTileset();
-		for (auto &[chunk_position, path_chunk]: tileProvider.pathMap)
-			for (int64_t row = 0; row < CHUNK_SIZE; ++row)
-				for (int64_t column = 0; column < CHUNK_SIZE; ++column)
-					path_chunk[row * CHUNK_SIZE + column] = isWalkable(row, column, tileset);
+		for (const ChunkPosition chunk_position: tileProvider.getChunkPositions())
+			remakePathMap(chunk_position);
 	}
 
 	void Realm::remakePathMap(const ChunkRange &range) {
@@ -1145,20 +1375,55 @@ namespace Game3 {
 	}
 
 	void Realm::remakePathMap(ChunkPosition position) {
-		Timer timer{"RemakePathMap"};
+		fillPathChunk(position);
+		pathGraph.invalidate(position);
+		invalidateFlowFields();
+	}
+
+	void Realm::fillPathChunk(ChunkPosition position) {
+		PROFILE_ZONE("RemakePathMap");
 		const auto &tileset = getTileset();
-		auto &path_chunk = tileProvider.getPathChunk(position);
-		auto lock = path_chunk.uniqueLock();
+		// isWalkable reads tiles from the same chunk, so it can't be called while the chunk is locked.
+		std::vector<uint8_t> walkable(CHUNK_SIZE * CHUNK_SIZE);
 		for (int64_t row = 0; row < CHUNK_SIZE; ++row)
 			for (int64_t column = 0; column < CHUNK_SIZE; ++column)
-				path_chunk[row * CHUNK_SIZE + column] = isWalkable(position.y * CHUNK_SIZE + row, position.x * CHUNK_SIZE + column, tileset);
+				walkable[row * CHUNK_SIZE + column] = isWalkable(position.y * CHUNK_SIZE + row, position.x * CHUNK_SIZE + column, tileset);
+		*tileProvider.getPathChunk(position) = std::move(walkable);
 	}
 
 	void Realm::remakePathMap(Position position) {
 		const auto &tileset = getTileset();
-		auto &path_chunk = tileProvider.getPathChunk(position.getChunk());
-		auto lock = path_chunk.uniqueLock();
-		path_chunk[position.row * CHUNK_SIZE + position.column] = isWalkable(position.row, position.column, tileset);
+		const uint8_t walkable = isWalkable(position.row, position.column, tileset);
+		{
+			std::unique_lock<std::shared_mutex> path_lock;
+			uint8_t &path_state = tileProvider.findPathState(position, &path_lock);
+			if (path_state == walkable)
+				return;
+			path_state = walkable;
+		}
+		pathGraph.invalidate(position);
+		invalidateFlowFields();
+	}
+
+	void Realm::invalidateFlowFields() {
+		auto lock = flowFields.uniqueLock();
+		std::erase_if(flowFields, [](const auto &pair) {
+			if (std::shared_ptr<FlowField> field = pair.second.lock()) {
+				field->invalidate();
+				return false;
+			}
+			return true;
+		});
+	}
+
+	std::shared_ptr<FlowField> Realm::getFlowField(GlobalID gid) {
+		auto lock = flowFields.uniqueLock();
+		std::weak_ptr<FlowField> &weak_field = flowFields[gid];
+		if (std::shared_ptr<FlowField> field = weak_field.lock())
+			return field;
+		auto field = std::make_shared<FlowField>();
+		weak_field = field;
+		return field;
 	}
 
 	void Realm::markGenerated(const ChunkRange &range) {
@@ -1292,6 +1557,11 @@ namespace Game3 {
 	}
 
 	void Realm::detach(const EntityPtr &entity, ChunkPosition chunk_position) {
+		{
+			auto lock = entityIndex.uniqueLock();
+			entityIndex.remove(entity->getGID());
+		}
+
 		auto lock = entitiesByChunk.uniqueLock();
 
 		if (auto iter = entitiesByChunk.find(chunk_position); iter != entitiesByChunk.end()) {
@@ -1312,6 +1582,11 @@ namespace Game3 {
 	}
 
 	void Realm::attach(const EntityPtr &entity) {
+		{
+			auto lock = entityIndex.uniqueLock();
+			entityIndex.insert(entity->getGID(), entity->getPosition());
+		}
+
 		auto lock = entitiesByChunk.uniqueLock();
 		const auto chunk_position = entity->getChunk();
 
@@ -1376,12 +1651,19 @@ namespace Game3 {
 		try {
 			const auto [chunk_tiles, entity_packets, tile_entity_packets] = getChunkPackets(chunk_position);
 
+			// Encode everything once rather than once per client.
+			Game &game = getGame();
+			std::vector<FramedPacket> framed;
+			framed.reserve(1 + entity_packets.size() + tile_entity_packets.size());
+			framed.push_back(framePacket(game, chunk_tiles));
+			for (const auto &packet: entity_packets)
+				framed.push_back(framePacket(game, packet));
+			for (const auto &packet: tile_entity_packets)
+				framed.push_back(framePacket(game, packet));
+
 			for (const auto &client: clients) {
 				client->getPlayer()->notifyOfRealm(*this);
-				client->send(chunk_tiles);
-				for (const auto &packet: entity_packets)
-					client->send(packet);
-				for (const auto &packet: tile_entity_packets)
+				for (const FramedPacket &packet: framed)
 					client->send(packet);
 			}
 		} catch (const std::out_of_range &) {
@@ -1416,6 +1698,54 @@ namespace Game3 {
 		visibleChunks = std::move(new_visible_chunks);
 	}
 
+	size_t Realm::evictInactiveChunks(std::chrono::seconds timeout) {
+		assert(isServer());
+
+		GameDB &database = getGame().toServer().database;
+		if (!database.isOpen())
+			return 0;
+
+		const auto now = std::chrono::steady_clock::now();
+
+		std::unordered_set<ChunkPosition> needed;
+		{
+			auto lock = visibleChunks.sharedLock();
+			needed = visibleChunks.getBase();
+		}
+		{
+			auto lock = chunkRequests.sharedLock();
+			for (const auto &[chunk_position, clients]: chunkRequests)
+				needed.insert(chunk_position);
+		}
+
+		size_t evicted = 0;
+
+		for (const ChunkPosition chunk_position: tileProvider.getChunkPositions()) {
+			// Chunks that are still being generated have nothing stored to be paged back in from.
+			if (needed.contains(chunk_position) || !generatedChunks.contains(chunk_position) || generationPipeline.isPending(chunk_position) || chunkPrefetcher.isPending(chunk_position)) {
+				chunkLastNeeded[chunk_position] = now;
+				continue;
+			}
+
+			auto [iter, inserted] = chunkLastNeeded.try_emplace(chunk_position, now);
+			if (inserted || now - iter->second < timeout)
+				continue;
+
+			// Dirty chunks are left for the autosave thread to write so that the tick thread doesn't wait on the database.
+			// They'll be evicted on a later pass once they've been saved.
+			if (tileProvider.isDirty(chunk_position))
+				continue;
+
+			tileProvider.evict(chunk_position);
+			// It's stored now, so it can be paged back in even if an earlier load found nothing.
+			chunkPrefetcher.reset(chunk_position);
+			chunkLastNeeded.erase(iter);
+			++evicted;
+		}
+
+		return evicted;
+	}
+
 	void Realm::queueReupload() {
 		assert(getSide() == Side::Client);
 		if (!reuploadPending.exchange(true)) {
@@ -1441,11 +1771,12 @@ namespace Game3 {
 
 			if (info->autotileSet->omni) {
 				const TileID empty = tileset.getEmptyID();
+				const std::optional<Tileset::CategoryIndex> no_omni = tileset.getCategoryIndex("base:category/no_omni");
 				march_result = march4([&](int8_t march_row_offset, int8_t march_column_offset) -> bool {
 					const Position march_position = position + Position(march_row_offset, march_column_offset);
 					for (const Layer omni_layer: {Layer::Submerged, Layer::Objects}) {
 						const TileID march_tile = tileProvider.copyTile(omni_layer, march_position, TileProvider::TileMode::ReturnEmpty);
-						if (march_tile != empty && !tileset.isInCategory(march_tile, "base:category/no_omni"))
+						if (march_tile != empty && !(no_omni && tileset.isInCategory(march_tile, *no_omni)))
 							return true;
 					}
 					return false;
@@ -1475,7 +1806,7 @@ namespace Game3 {
 		if (!player)
 			return;
 
-		Timer timer("RemakeStaticLightingTexture");
+		PROFILE_ZONE("RemakeStaticLightingTexture");
 		Canvas &canvas = client_game.canvas;
 		GL::Texture &texture = canvas.staticLightingTexture;
 		client_game.activateContext();
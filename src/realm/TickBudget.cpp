@@ -0,0 +1,47 @@
+#include "game/ServerGame.h"
+#include "realm/TickBudget.h"
+
+#include <string>
+
+namespace Game3 {
+	std::string_view toString(TickPhase phase) {
+		switch (phase) {
+			case TickPhase::EntityRemoval:         return "EntityRemoval";
+			case TickPhase::EntityDestruction:     return "EntityDestruction";
+			case TickPhase::TileEntityRemoval:     return "TileEntityRemoval";
+			case TickPhase::TileEntityDestruction: return "TileEntityDestruction";
+			case TickPhase::PlayerRemoval:         return "PlayerRemoval";
+			case TickPhase::General:               return "General";
+			case TickPhase::RandomTicks:           return "RandomTicks";
+			default:
+				return "invalid";
+		}
+	}
+
+	std::ostream & operator<<(std::ostream &os, TickPhase phase) {
+		return os << toString(phase);
+	}
+
+	TickBudgets::TickBudgets() {
+		for (const TickPhase phase: ALL_TICK_PHASES)
+			set(phase, getDefault(phase));
+	}
+
+	std::chrono::steady_clock::time_point TickBudgets::getDeadline(TickPhase phase) const {
+		const std::chrono::microseconds budget = get(phase);
+		if (budget.count() < 0)
+			return std::chrono::steady_clock::time_point::max();
+		return std::chrono::steady_clock::now() + budget;
+	}
+
+	void TickBudgets::update(const ServerGame &game) {
+		for (const TickPhase phase: ALL_TICK_PHASES) {
+			const auto rule = game.getRule("tickBudget" + std::string(toString(phase)));
+			set(phase, rule? std::chrono::microseconds(*rule) : getDefault(phase));
+		}
+	}
+
+	std::chrono::microseconds TickBudgets::getDefault(TickPhase phase) {
+		return phase == TickPhase::RandomTicks? DEFAULT_RANDOM_TICK_BUDGET : DEFAULT_QUEUE_BUDGET;
+	}
+}
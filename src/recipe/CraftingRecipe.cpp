@@ -44,23 +44,23 @@ namespace Game3 {
 		// How we do this depends on the number of outputs as well as whether the input and output inventory are the same.
 
 		if (inventory_in == inventory_out) {
-			// If they're the same, we need to copy the inventory early to check for
-			// removability and insertability, regardless of the number of outputs.
-			std::unique_ptr<Inventory> copy = inventory_in->copy();
+			// If they're the same, we need to remove the inputs before checking whether the outputs fit,
+			// regardless of the number of outputs. The transaction undoes the removal if they don't.
+			auto transaction = inventory_in->transaction();
 			for (const CraftingRequirement &requirement: input)
-				copy->remove(requirement);
+				inventory_in->remove(requirement);
 
 			for (const ItemStack &stack: output)
-				if (copy->add(stack).has_value())
+				if (inventory_in->add(stack).has_value())
 					return false;
 
-			inventory_in->replace(std::move(*copy));
+			transaction.commit();
 			leftovers.emplace();
 			return true;
 		}
 
 		if (output.size() == 1) {
-			// If there's just one output, we can check whether it's insertable without having to copy the output inventory.
+			// If there's just one output, we can check whether it's insertable without having to start a transaction.
 			if (!inventory_out->canInsert(output[0]))
 				return false;
 
@@ -73,18 +73,18 @@ namespace Game3 {
 		}
 
 		// At this point the input and output inventories are different and there are multiple outputs.
-		// Make a copy of the output inventory and try to insert all the outputs in it.
-		// If that succeeds, proceed to remove the ingredients from the input inventory and replace
-		// the output inventory with the copy.
-		auto out_copy = inventory_out->copy();
+		// Try to insert all the outputs in the output inventory inside a transaction.
+		// If that succeeds, proceed to remove the ingredients from the input inventory and commit.
+		// Only the output inventory gets a transaction: both could be spans of the same inventory.
+		auto transaction = inventory_out->transaction();
 		for (const ItemStack &stack: output)
-			if (out_copy->add(stack).has_value())
+			if (inventory_out->add(stack).has_value())
 				return false;
 
 		for (const CraftingRequirement &requirement: input)
 			inventory_in->remove(requirement);
 
-		inventory_out->replace(std::move(*out_copy));
+		transaction.commit();
 		leftovers.emplace();
 		return true;
 	}
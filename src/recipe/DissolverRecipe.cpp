@@ -14,7 +14,7 @@ namespace Game3 {
 			if (chemical.item->identifier != "base:item/chemical")
 				return 4; // Count non-chemicals as four atoms.
 
-			const auto counts = Chemskr::count(chemical.data.at("formula"));
+			const auto counts = Chemskr::count(chemical.data.at<std::string>("formula"));
 			return std::accumulate(counts.begin(), counts.end(), 0, [](size_t total, const auto &pair) {
 				return total + pair.second;
 			});
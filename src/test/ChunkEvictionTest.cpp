@@ -0,0 +1,72 @@
+#include "Log.h"
+#include "data/ChunkSet.h"
+#include "game/TileProvider.h"
+
+#include <map>
+#include <optional>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t UPDATE_COUNT = 5;
+
+		/** Evicts a chunk that a client has an up-to-date copy of, pages it back in with page_in and checks that the
+		 *  client's next request (made with its old threshold) would still be answered. */
+		template <typename F>
+		bool checkReload(const char *description, F &&page_in) {
+			const ChunkPosition chunk_position{1, 2};
+			std::map<ChunkPosition, ChunkSet> database;
+
+			TileProvider provider;
+			provider.chunkLoader = [&](ChunkPosition requested) -> std::optional<ChunkSet> {
+				if (auto iter = database.find(requested); iter != database.end())
+					return iter->second;
+				return std::nullopt;
+			};
+
+			provider.ensureAllChunks(chunk_position);
+			for (size_t i = 0; i < UPDATE_COUNT; ++i)
+				provider.updateChunk(chunk_position);
+
+			// What a client holding the current copy asks for.
+			const uint64_t old_counter = provider.getUpdateCounter(chunk_position);
+			const uint64_t threshold = old_counter + 1;
+
+			if (!provider.isUpToDate(chunk_position, threshold)) {
+				ERROR(description << ": a client with the current copy would be sent the chunk again");
+				return false;
+			}
+
+			database.emplace(chunk_position, provider.getChunkSet(chunk_position));
+			provider.markSaved(chunk_position, old_counter);
+			provider.evict(chunk_position);
+
+			page_in(provider, chunk_position, database.at(chunk_position));
+
+			const uint64_t new_counter = provider.getUpdateCounter(chunk_position);
+			if (new_counter <= old_counter) {
+				ERROR(description << ": update counter went from " << old_counter << " to " << new_counter << " across an eviction");
+				return false;
+			}
+
+			if (provider.isUpToDate(chunk_position, threshold)) {
+				ERROR(description << ": a request with the pre-eviction threshold wouldn't be answered");
+				return false;
+			}
+
+			return true;
+		}
+	}
+
+	void chunkEvictionTest() {
+		bool ok = checkReload("Synchronous page-in", [](TileProvider &provider, ChunkPosition chunk_position, const ChunkSet &) {
+			(void) provider.tryTile(Layer::Terrain, Position(chunk_position.y * CHUNK_SIZE, chunk_position.x * CHUNK_SIZE));
+		});
+
+		ok = checkReload("Prefetched load", [](TileProvider &provider, ChunkPosition chunk_position, const ChunkSet &chunk_set) {
+			provider.storeLoaded(chunk_position, chunk_set);
+		}) && ok;
+
+		if (ok)
+			SUCCESS("Chunk update counters survive eviction.");
+	}
+}
@@ -0,0 +1,203 @@
+#include "Constants.h"
+#include "Log.h"
+#include "game/Chunk.h"
+#include "game/TileProvider.h"
+#include "types/Types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+		constexpr size_t READS_PER_THREAD = 2'000'000;
+		/** How long the writer waits between writes. Terrain is read far more often than it's written. */
+		constexpr std::chrono::microseconds WRITE_INTERVAL{20};
+		/** The width and height, in chunks, of the area read through a TileProvider. */
+		constexpr int32_t PROVIDER_CHUNKS = 4;
+
+		/** The representation chunks used before: every read takes the chunk's shared lock. */
+		using LockingChunk = Lockable<std::vector<TileID>>;
+
+		/** Every value written to index i is congruent to i modulo CHUNK_AREA, so readers can tell whether they saw garbage. */
+		TileID valueFor(size_t index, size_t generation) {
+			return static_cast<TileID>(index + generation * CHUNK_AREA);
+		}
+
+		TileID read(const LockingChunk &chunk, size_t index) {
+			auto lock = chunk.sharedLock();
+			return chunk[index];
+		}
+
+		TileID read(const TileChunk &chunk, size_t index) {
+			return chunk.load(index);
+		}
+
+		void write(LockingChunk &chunk, size_t index, TileID value) {
+			chunk[index] = value;
+		}
+
+		void write(TileChunk &chunk, size_t index, TileID value) {
+			chunk.store(index, value);
+		}
+
+		struct Result {
+			double nanosPerRead = 0.;
+			size_t writes = 0;
+			size_t bad = 0;
+		};
+
+		/** Runs reader_count threads doing random single-tile reads while one thread keeps overwriting rows of the chunk. */
+		template <typename C>
+		Result run(size_t reader_count) {
+			C chunk;
+			chunk.resize(CHUNK_AREA);
+			for (size_t index = 0; index < CHUNK_AREA; ++index)
+				chunk[index] = valueFor(index, 0);
+
+			std::atomic_size_t readers_done = 0;
+			std::atomic_size_t bad = 0;
+			size_t writes = 0;
+
+			std::thread writer([&] {
+				std::default_random_engine rng(42);
+				while (readers_done < reader_count) {
+					const size_t row = rng() % CHUNK_SIZE;
+					{
+						auto lock = chunk.uniqueLock();
+						++writes;
+						for (size_t column = 0; column < CHUNK_SIZE; ++column)
+							write(chunk, row * CHUNK_SIZE + column, valueFor(row * CHUNK_SIZE + column, writes));
+					}
+					std::this_thread::sleep_for(WRITE_INTERVAL);
+				}
+			});
+
+			const auto start = std::chrono::steady_clock::now();
+
+			std::vector<std::thread> readers;
+			for (size_t thread_index = 0; thread_index < reader_count; ++thread_index) {
+				readers.emplace_back([&, thread_index] {
+					std::default_random_engine rng(thread_index);
+					size_t local_bad = 0;
+					for (size_t i = 0; i < READS_PER_THREAD; ++i) {
+						const size_t index = rng() % CHUNK_AREA;
+						local_bad += read(chunk, index) % CHUNK_AREA != index;
+					}
+					bad += local_bad;
+					++readers_done;
+				});
+			}
+
+			for (std::thread &reader: readers)
+				reader.join();
+
+			const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			writer.join();
+
+			return {elapsed.count() / READS_PER_THREAD, writes, bad};
+		}
+
+		/** Like run, but reads go through TileProvider::copyTile, which also has to find and lock the chunk's record,
+		 *  and the writer overwrites rows of random chunks through chunk handles. */
+		Result runProvider(size_t reader_count) {
+			TileProvider provider;
+
+			for (int32_t y = 0; y < PROVIDER_CHUNKS; ++y) {
+				for (int32_t x = 0; x < PROVIDER_CHUNKS; ++x) {
+					const ChunkPosition chunk_position{x, y};
+					provider.ensureAllChunks(chunk_position);
+					std::vector<TileID> tiles(CHUNK_AREA);
+					for (size_t index = 0; index < CHUNK_AREA; ++index)
+						tiles[index] = valueFor(index, 0);
+					*provider.getTileChunk(Layer::Terrain, chunk_position) = std::move(tiles);
+				}
+			}
+
+			std::atomic_size_t readers_done = 0;
+			std::atomic_size_t bad = 0;
+			size_t writes = 0;
+
+			std::thread writer([&] {
+				std::default_random_engine rng(42);
+				while (readers_done < reader_count) {
+					const ChunkPosition chunk_position{static_cast<int32_t>(rng() % PROVIDER_CHUNKS), static_cast<int32_t>(rng() % PROVIDER_CHUNKS)};
+					const size_t row = rng() % CHUNK_SIZE;
+					{
+						auto chunk = provider.getTileChunk(Layer::Terrain, chunk_position);
+						auto lock = chunk->uniqueLock();
+						++writes;
+						for (size_t column = 0; column < CHUNK_SIZE; ++column)
+							chunk->store(row * CHUNK_SIZE + column, valueFor(row * CHUNK_SIZE + column, writes));
+					}
+					std::this_thread::sleep_for(WRITE_INTERVAL);
+				}
+			});
+
+			const auto start = std::chrono::steady_clock::now();
+
+			std::vector<std::thread> readers;
+			for (size_t thread_index = 0; thread_index < reader_count; ++thread_index) {
+				readers.emplace_back([&, thread_index] {
+					std::default_random_engine rng(thread_index);
+					size_t local_bad = 0;
+					for (size_t i = 0; i < READS_PER_THREAD; ++i) {
+						const Index row = rng() % (PROVIDER_CHUNKS * CHUNK_SIZE);
+						const Index column = rng() % (PROVIDER_CHUNKS * CHUNK_SIZE);
+						const size_t index = TileProvider::remainder(row) * CHUNK_SIZE + TileProvider::remainder(column);
+						local_bad += provider.copyTile(Layer::Terrain, Position(row, column)) % CHUNK_AREA != index;
+					}
+					bad += local_bad;
+					++readers_done;
+				});
+			}
+
+			for (std::thread &reader: readers)
+				reader.join();
+
+			const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+			writer.join();
+
+			return {elapsed.count() / READS_PER_THREAD, writes, bad};
+		}
+	}
+
+	void chunkReadBenchmark() {
+		const size_t max_readers = std::max<size_t>(4, std::thread::hardware_concurrency());
+		bool consistent = true;
+
+		for (size_t reader_count = 1; reader_count <= max_readers; reader_count *= 2) {
+			const Result locking = run<LockingChunk>(reader_count);
+			const Result optimistic = run<TileChunk>(reader_count);
+			const Result provider = runProvider(reader_count);
+
+			INFO(reader_count << " reader(s): shared lock " << locking.nanosPerRead << " ns/read (" << locking.writes << " writes), optimistic "
+				<< optimistic.nanosPerRead << " ns/read (" << optimistic.writes << " writes), TileProvider::copyTile "
+				<< provider.nanosPerRead << " ns/read (" << provider.writes << " writes)");
+
+			if (locking.bad != 0 || optimistic.bad != 0 || provider.bad != 0) {
+				ERROR("Readers saw " << locking.bad << ", " << optimistic.bad << " and " << provider.bad << " bad values");
+				consistent = false;
+			}
+		}
+
+		TileChunk chunk;
+		chunk.resize(CHUNK_AREA);
+		{
+			auto outer = chunk.uniqueLock();
+			auto inner = chunk.uniqueLock();
+		}
+
+		if (chunk.getVersion() != 1) {
+			ERROR("Nested writes should count as one write, not " << chunk.getVersion());
+			consistent = false;
+		}
+
+		if (consistent)
+			SUCCESS("Optimistic chunk reads stayed consistent.");
+	}
+}
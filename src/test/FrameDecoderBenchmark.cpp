@@ -0,0 +1,170 @@
+#include "Log.h"
+#include "net/FrameDecoder.h"
+#include "util/Timer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		struct TestFrame {
+			PacketID id;
+			std::vector<uint8_t> payload;
+		};
+
+		std::vector<TestFrame> makeFrames(std::default_random_engine &rng, size_t count, size_t max_payload_size) {
+			std::uniform_int_distribution<uint16_t> id_distribution(0, 200);
+			std::uniform_int_distribution<size_t> size_distribution(0, max_payload_size);
+			std::uniform_int_distribution<uint16_t> byte_distribution(0, 255);
+
+			std::vector<TestFrame> frames;
+			frames.reserve(count);
+
+			for (size_t i = 0; i < count; ++i) {
+				TestFrame &frame = frames.emplace_back(TestFrame{id_distribution(rng), {}});
+				frame.payload.resize(size_distribution(rng));
+				for (uint8_t &byte: frame.payload)
+					byte = static_cast<uint8_t>(byte_distribution(rng));
+			}
+
+			return frames;
+		}
+
+		std::vector<uint8_t> serialize(const std::vector<TestFrame> &frames) {
+			std::vector<uint8_t> stream;
+			for (const TestFrame &frame: frames) {
+				const uint32_t size = frame.payload.size();
+				stream.push_back(frame.id & 0xff);
+				stream.push_back(frame.id >> 8);
+				for (int shift = 0; shift < 32; shift += 8)
+					stream.push_back((size >> shift) & 0xff);
+				stream.insert(stream.end(), frame.payload.begin(), frame.payload.end());
+			}
+			return stream;
+		}
+
+		/** Feeds the stream to a decoder in reads of random sizes and checks that every frame comes back out intact. */
+		bool fuzzOnce(std::default_random_engine &rng, size_t max_read_size) {
+			const std::vector<TestFrame> frames = makeFrames(rng, 500, 2048);
+			const std::vector<uint8_t> stream = serialize(frames);
+			std::uniform_int_distribution<size_t> read_distribution(1, max_read_size);
+
+			FrameDecoder decoder(2048);
+			size_t next_frame = 0;
+			bool matches = true;
+
+			auto handler = [&](PacketID id, std::span<const uint8_t> payload) {
+				if (frames.size() <= next_frame || frames[next_frame].id != id || !std::equal(payload.begin(), payload.end(), frames[next_frame].payload.begin(), frames[next_frame].payload.end()))
+					matches = false;
+				++next_frame;
+				return true;
+			};
+
+			for (size_t offset = 0; offset < stream.size();) {
+				const size_t read_size = std::min(read_distribution(rng), stream.size() - offset);
+				if (!decoder.feed(std::span(stream).subspan(offset, read_size), handler))
+					return false;
+				offset += read_size;
+			}
+
+			return matches && next_frame == frames.size() && decoder.getBufferedSize() == 0;
+		}
+
+		/** The parser RemoteClient used before FrameDecoder, minus the packet decoding, for comparison. */
+		size_t legacyParse(std::string_view string, std::vector<uint8_t> &header_bytes, std::vector<uint8_t> &receive_buffer, bool &in_data, uint32_t &payload_size) {
+			std::stringstream ss;
+			for (const uint8_t byte: string)
+				ss << ' ' << std::hex << std::setfill('0') << std::setw(2) << std::right << static_cast<uint16_t>(byte) << std::dec;
+			auto str = std::string(string);
+			while (!str.empty() && (str.back() == '\r' || str.back() == '\n'))
+				str.pop_back();
+
+			header_bytes.insert(header_bytes.end(), string.begin(), string.end());
+			size_t parsed = 0;
+
+			for (;;) {
+				if (!in_data) {
+					receive_buffer.clear();
+					if (header_bytes.size() < 6)
+						return parsed;
+					payload_size = header_bytes[2] | (static_cast<uint32_t>(header_bytes[3]) << 8) | (static_cast<uint32_t>(header_bytes[4]) << 16) | (static_cast<uint32_t>(header_bytes[5]) << 24);
+					header_bytes.erase(header_bytes.begin(), header_bytes.begin() + 6);
+					in_data = true;
+				}
+
+				const size_t to_append = std::min<size_t>(payload_size - receive_buffer.size(), header_bytes.size());
+				receive_buffer.insert(receive_buffer.end(), header_bytes.begin(), header_bytes.begin() + to_append);
+				header_bytes.erase(header_bytes.begin(), header_bytes.begin() + to_append);
+
+				if (payload_size != receive_buffer.size())
+					return parsed;
+
+				++parsed;
+				in_data = false;
+			}
+		}
+	}
+
+	void frameDecoderBenchmark() {
+		std::default_random_engine rng(42);
+
+		size_t failures = 0;
+		for (size_t i = 0; i < 200; ++i)
+			if (!fuzzOnce(rng, i % 2 == 0? 16 : 4096))
+				++failures;
+
+		if (failures == 0)
+			SUCCESS("Fuzzing found no mismatched frames.");
+		else
+			ERROR("Fuzzing found " << failures << " mismatched stream(s).");
+
+		{
+			FrameDecoder decoder(16);
+			const std::vector<uint8_t> oversized = serialize({TestFrame{1, std::vector<uint8_t>(17)}});
+			if (decoder.feed(oversized, [](PacketID, std::span<const uint8_t>) { return true; }))
+				ERROR("Oversized payload was accepted.");
+			else
+				SUCCESS("Oversized payload was rejected.");
+		}
+
+		// Small packets read in 1024-byte chunks, the server's default read size, to show the per-read overhead.
+		const std::vector<uint8_t> stream = serialize(makeFrames(rng, 200'000, 64));
+		constexpr size_t READ_SIZE = 1024;
+
+		{
+			FrameDecoder decoder(64);
+			size_t parsed = 0;
+			Timer timer{"FrameDecoder"};
+			for (size_t offset = 0; offset < stream.size(); offset += READ_SIZE) {
+				decoder.feed(std::span(stream).subspan(offset, std::min(READ_SIZE, stream.size() - offset)), [&](PacketID, std::span<const uint8_t>) {
+					++parsed;
+					return true;
+				});
+			}
+			timer.stop();
+			INFO("FrameDecoder parsed " << parsed << " frames from " << stream.size() << " bytes.");
+		}
+
+		{
+			std::vector<uint8_t> header_bytes;
+			std::vector<uint8_t> receive_buffer;
+			bool in_data = false;
+			uint32_t payload_size = 0;
+			size_t parsed = 0;
+			Timer timer{"LegacyParser"};
+			for (size_t offset = 0; offset < stream.size(); offset += READ_SIZE) {
+				const size_t size = std::min(READ_SIZE, stream.size() - offset);
+				parsed += legacyParse(std::string_view(reinterpret_cast<const char *>(stream.data() + offset), size), header_bytes, receive_buffer, in_data, payload_size);
+			}
+			timer.stop();
+			INFO("Legacy parser parsed " << parsed << " frames from " << stream.size() << " bytes.");
+		}
+
+		Timer::summary();
+	}
+}
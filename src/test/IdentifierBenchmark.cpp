@@ -0,0 +1,203 @@
+#include "Log.h"
+#include "data/Identifier.h"
+#include "net/Buffer.h"
+#include "registry/Registry.h"
+#include "util/Timer.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t ITEM_COUNT = 2'000;
+		constexpr size_t LOOKUP_COUNT = 2'000'000;
+
+		/** The representation Identifier used before interning: two strings compared and hashed by content. */
+		struct StringIdentifier {
+			std::string space;
+			std::string name;
+
+			StringIdentifier(std::string_view combined) {
+				const size_t colon = combined.find(':');
+				space = std::string(combined.substr(0, colon));
+				name  = std::string(combined.substr(colon + 1));
+			}
+
+			bool operator==(const StringIdentifier &other) const {
+				return space == other.space && name == other.name;
+			}
+
+			bool operator<(const StringIdentifier &other) const {
+				if (space != other.space)
+					return space < other.space;
+				return name < other.name;
+			}
+		};
+
+		struct StringIdentifierHash {
+			size_t operator()(const StringIdentifier &identifier) const {
+				return std::hash<std::string>()(identifier.space + ':' + identifier.name);
+			}
+		};
+
+		struct StandIn: NamedRegisterable {
+			size_t value;
+			StandIn(Identifier identifier_, size_t value_): NamedRegisterable(std::move(identifier_)), value(value_) {}
+		};
+
+		class StandInRegistry: public NamedRegistry<StandIn> {
+			public:
+				StandInRegistry(): NamedRegistry(Identifier("base", "registry/stand_in")) {}
+		};
+
+		/** Checks that interned identifiers behave like the string-based ones did. */
+		bool checkIdentifiers() {
+			const Identifier combined = "base:item/tools/pickaxe"_id;
+			const Identifier split("base", "item/tools/pickaxe");
+
+			if (combined != split || combined.getHandle() != split.getHandle() || combined.str() != "base:item/tools/pickaxe")
+				return false;
+
+			if (combined.getSpace() != "base" || combined.getPath() != "item/tools" || combined.getPathStart() != "item" || combined.getPostPath() != "pickaxe")
+				return false;
+
+			if (!(combined == "base:item/tools/pickaxe") || combined == "base:item/tools" || !combined.inSpace("base"))
+				return false;
+
+			if (!Identifier().empty() || Identifier().str() != ":" || Identifier("", "") != Identifier())
+				return false;
+
+			try {
+				(void) Identifier("base:").empty();
+				return false;
+			} catch (const std::runtime_error &) {}
+
+			// Ordering is by space first, which differs from ordering the combined strings.
+			if (!(Identifier("a", "x") < Identifier("a-b", "x")) || Identifier("a-b", "x") < Identifier("a", "x"))
+				return false;
+
+			nlohmann::json json = combined;
+			if (json.get<std::string>() != "base:item/tools/pickaxe" || json.get<Identifier>() != combined)
+				return false;
+
+			Buffer buffer;
+			buffer << combined;
+			Identifier popped;
+			buffer >> popped;
+			if (popped != combined)
+				return false;
+
+			// Decoding mustn't intern identifiers that haven't been seen before.
+			const size_t interned = Identifier::getInternedCount();
+			buffer << std::string("test:never_interned");
+			try {
+				buffer >> popped;
+				return false;
+			} catch (const std::invalid_argument &) {}
+
+			return Identifier::getInternedCount() == interned && !Identifier::find("test:never_interned");
+		}
+	}
+
+	void identifierBenchmark() {
+		if (checkIdentifiers())
+			SUCCESS("Interned identifiers behave like string identifiers.");
+		else
+			ERROR("Interned identifiers don't behave like string identifiers.");
+
+		std::vector<std::string> names;
+		names.reserve(ITEM_COUNT);
+		for (size_t i = 0; i < ITEM_COUNT; ++i)
+			names.push_back("base:item/generated/item_" + std::to_string(i));
+
+		std::map<StringIdentifier, std::shared_ptr<StandIn>> string_registry;
+		StandInRegistry registry;
+		std::unordered_set<StringIdentifier, StringIdentifierHash> string_set;
+		std::unordered_set<Identifier> interned_set;
+
+		for (size_t i = 0; i < ITEM_COUNT; ++i) {
+			auto item = registry.add(Identifier(names[i]), std::make_shared<StandIn>(Identifier(names[i]), i));
+			string_registry.emplace(StringIdentifier(names[i]), item);
+			string_set.emplace(names[i]);
+			interned_set.emplace(names[i]);
+		}
+
+		std::default_random_engine rng(1729);
+		std::vector<size_t> indices;
+		indices.reserve(LOOKUP_COUNT);
+		for (size_t i = 0; i < LOOKUP_COUNT; ++i)
+			indices.push_back(rng() % ITEM_COUNT);
+
+		std::vector<StringIdentifier> string_keys;
+		std::vector<Identifier> interned_keys;
+		for (const std::string &name: names) {
+			string_keys.emplace_back(name);
+			interned_keys.emplace_back(name);
+		}
+
+		size_t string_sum = 0;
+		size_t interned_sum = 0;
+
+		{
+			Timer timer{"StringIdentifier map lookup"};
+			for (const size_t index: indices)
+				string_sum += string_registry.at(string_keys[index])->value;
+		}
+
+		{
+			Timer timer{"Identifier registry lookup"};
+			for (const size_t index: indices)
+				interned_sum += registry.at(interned_keys[index])->value;
+		}
+
+		{
+			Timer timer{"StringIdentifier set contains"};
+			for (const size_t index: indices)
+				string_sum += string_set.contains(string_keys[index]);
+		}
+
+		{
+			Timer timer{"Identifier set contains"};
+			for (const size_t index: indices)
+				interned_sum += interned_set.contains(interned_keys[index]);
+		}
+
+		// Lookups that construct their key from a string every time, like "..."_id in a loop.
+		{
+			Timer timer{"StringIdentifier construct + lookup"};
+			for (size_t i = 0; i < LOOKUP_COUNT / 4; ++i)
+				string_sum += string_registry.at(StringIdentifier(names[indices[i]]))->value;
+		}
+
+		{
+			Timer timer{"Identifier construct + lookup"};
+			for (size_t i = 0; i < LOOKUP_COUNT / 4; ++i)
+				interned_sum += registry.at(Identifier(names[indices[i]]))->value;
+		}
+
+		if (string_sum != interned_sum)
+			ERROR("Lookups disagree: " << string_sum << " vs. " << interned_sum);
+
+		std::vector<StringIdentifier> sorted_strings(string_keys);
+		std::vector<Identifier> sorted_interned(interned_keys);
+		std::sort(sorted_strings.begin(), sorted_strings.end());
+		std::sort(sorted_interned.begin(), sorted_interned.end());
+		for (size_t i = 0; i < ITEM_COUNT; ++i) {
+			if (sorted_interned[i].str() != sorted_strings[i].space + ':' + sorted_strings[i].name) {
+				ERROR("Identifiers sort differently from string identifiers");
+				break;
+			}
+		}
+
+		INFO(Identifier::getInternedCount() << " identifiers interned");
+
+		Timer::summary();
+	}
+}
@@ -0,0 +1,211 @@
+#include "Log.h"
+#include "game/Game.h"
+#include "game/InventorySpan.h"
+#include "game/ServerInventory.h"
+#include "item/Item.h"
+#include "util/Timer.h"
+
+#include <memory>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr Slot SLOT_COUNT = 1'000;
+		constexpr Slot INPUT_COUNT = SLOT_COUNT / 2;
+		constexpr size_t OPERATION_COUNT = 5'000;
+
+		struct Conversion {
+			std::vector<ItemStack> from;
+			std::vector<ItemStack> to;
+			/** Whether there's enough energy once the items have been moved. */
+			bool affordable = true;
+		};
+
+		/** Removes the inputs from one inventory and adds the outputs to another, like a machine does. */
+		bool convert(Inventory &input, Inventory &output, const Conversion &conversion) {
+			for (const ItemStack &stack: conversion.from)
+				if (input.remove(stack) < stack.count)
+					return false;
+
+			for (const ItemStack &stack: conversion.to)
+				if (output.add(stack))
+					return false;
+
+			return conversion.affordable;
+		}
+
+		/** The way machines used to do it: convert a copy of the whole inventory, then replace the original with it. */
+		bool convertCopy(const std::shared_ptr<Inventory> &inventory, const Conversion &conversion, bool use_spans) {
+			std::shared_ptr<Inventory> inventory_copy = inventory->copy();
+			auto suppressor = inventory_copy->suppress();
+
+			if (use_spans) {
+				auto input_span  = std::make_shared<InventorySpan>(inventory_copy, 0, INPUT_COUNT - 1);
+				auto output_span = std::make_shared<InventorySpan>(inventory_copy, INPUT_COUNT, SLOT_COUNT - 1);
+				if (!convert(*input_span, *output_span, conversion))
+					return false;
+			} else if (!convert(*inventory_copy, *inventory_copy, conversion)) {
+				return false;
+			}
+
+			suppressor.cancel();
+			inventory->replace(std::move(*inventory_copy));
+			return true;
+		}
+
+		bool convertTransaction(const std::shared_ptr<Inventory> &inventory, const Conversion &conversion, bool use_spans) {
+			auto transaction = inventory->transaction();
+
+			if (use_spans) {
+				auto input_span  = std::make_shared<InventorySpan>(inventory, 0, INPUT_COUNT - 1);
+				auto output_span = std::make_shared<InventorySpan>(inventory, INPUT_COUNT, SLOT_COUNT - 1);
+				if (!convert(*input_span, *output_span, conversion))
+					return false;
+			} else if (!convert(*inventory, *inventory, conversion)) {
+				return false;
+			}
+
+			transaction.commit();
+			return true;
+		}
+
+		/** Fills the input half with alternating ore and coal and the output half partly with bars. */
+		std::shared_ptr<ServerInventory> makeInventory(const Game &game) {
+			StorageInventory::Storage storage;
+			for (Slot slot = 0; slot < INPUT_COUNT; ++slot)
+				storage.emplace(slot, ItemStack(game, slot % 2 == 0? "base:item/iron_ore" : "base:item/coal", 64));
+			for (Slot slot = INPUT_COUNT; slot < SLOT_COUNT; slot += 4)
+				storage.emplace(slot, ItemStack(game, "base:item/iron_bar", 32));
+			return std::make_shared<ServerInventory>(nullptr, SLOT_COUNT, 0, 0, std::move(storage));
+		}
+
+		/** Alternates between smelting and unsmelting so that the inventory stays the same size. */
+		size_t run(const std::shared_ptr<Inventory> &inventory, const std::vector<Conversion> &conversions, bool use_spans, bool use_transactions) {
+			size_t successes = 0;
+			for (size_t i = 0; i < OPERATION_COUNT; ++i) {
+				const Conversion &conversion = conversions[i % conversions.size()];
+				if (use_transactions)
+					successes += convertTransaction(inventory, conversion, use_spans);
+				else
+					successes += convertCopy(inventory, conversion, use_spans);
+			}
+			return successes;
+		}
+
+		bool sameStorage(const Inventory &left, const Inventory &right) {
+			const StorageInventory::Storage &left_storage = dynamic_cast<const StorageInventory &>(left).getStorage();
+			const StorageInventory::Storage &right_storage = dynamic_cast<const StorageInventory &>(right).getStorage();
+			return left_storage == right_storage;
+		}
+
+		bool checkTransactions(const Game &game) {
+			std::shared_ptr<Inventory> inventory = makeInventory(game);
+			const auto original = makeInventory(game);
+
+			{
+				// Removes an ore, then fails to fit a bar in a new slot. Nothing should change.
+				auto full = std::make_shared<ServerInventory>(nullptr, 2, 0, 0, StorageInventory::Storage{
+					{0, ItemStack(game, "base:item/iron_ore", 2)},
+					{1, ItemStack(game, "base:item/coal", 64)},
+				});
+				const ServerInventory full_original = *full;
+				if (convertTransaction(full, {{ItemStack(game, "base:item/iron_ore", 1)}, {ItemStack(game, "base:item/iron_bar", 1)}}, false))
+					return false;
+				if (!sameStorage(*full, full_original) || full->inTransaction())
+					return false;
+			}
+
+			{
+				// Emptying a slot erases it; rolling back has to bring it back.
+				auto transaction = inventory->transaction();
+				inventory->remove(ItemStack(game, "base:item/iron_ore", 64), 0);
+				inventory->swap(2, 3);
+				inventory->add(ItemStack(game, "base:item/wood", 1));
+			}
+
+			if (!sameStorage(*inventory, *original) || inventory->inTransaction())
+				return false;
+
+			try {
+				auto transaction = inventory->transaction();
+				auto nested = inventory->transaction();
+				return false;
+			} catch (const std::logic_error &) {}
+
+			try {
+				auto transaction = inventory->transaction();
+				inventory->replace(*original);
+				return false;
+			} catch (const std::logic_error &) {}
+
+			{
+				auto transaction = inventory->transaction();
+				inventory->remove(ItemStack(game, "base:item/iron_ore", 64), 0);
+				transaction.commit();
+			}
+
+			return inventory->count(ItemStack(game, "base:item/iron_ore")) + 64 == original->count(ItemStack(game, "base:item/iron_ore"));
+		}
+	}
+
+	void inventoryTransactionBenchmark() {
+		auto game = Game::create(Side::Client, nullptr);
+
+		if (checkTransactions(*game))
+			SUCCESS("Inventory transactions roll back and commit correctly.");
+		else
+			ERROR("Inventory transactions don't roll back or commit correctly.");
+
+		const std::vector<Conversion> conversions{
+			{{ItemStack(*game, "base:item/iron_ore", 1), ItemStack(*game, "base:item/coal", 1)}, {ItemStack(*game, "base:item/iron_bar", 1)}},
+			{{ItemStack(*game, "base:item/iron_bar", 1)}, {ItemStack(*game, "base:item/iron_ore", 1), ItemStack(*game, "base:item/coal", 1)}},
+		};
+
+		// Like a reactor that runs out of energy after moving the items, which has to be rolled back every time.
+		const std::vector<Conversion> failures{
+			{conversions[0].from, conversions[0].to, false},
+		};
+
+		for (const bool use_spans: {false, true}) {
+			const char *pattern = use_spans? " (spans, like the combiner and autocrafter)" : " (like the chemical reactor)";
+			auto copied = makeInventory(*game);
+			auto transacted = makeInventory(*game);
+			size_t copy_successes{};
+			size_t transaction_successes{};
+
+			{
+				Timer timer{std::string("Copy + replace") + pattern};
+				copy_successes = run(copied, conversions, use_spans, false);
+			}
+
+			{
+				Timer timer{std::string("Transaction") + pattern};
+				transaction_successes = run(transacted, conversions, use_spans, true);
+			}
+
+			if (copy_successes != transaction_successes || !sameStorage(*copied, *transacted))
+				ERROR("Copies and transactions disagree" << pattern);
+		}
+
+		{
+			auto copied = makeInventory(*game);
+			auto transacted = makeInventory(*game);
+			const auto original = makeInventory(*game);
+
+			{
+				Timer timer{"Copy + discard (failed operations)"};
+				run(copied, failures, false, false);
+			}
+
+			{
+				Timer timer{"Transaction + rollback (failed operations)"};
+				run(transacted, failures, false, true);
+			}
+
+			if (!sameStorage(*copied, *original) || !sameStorage(*transacted, *original))
+				ERROR("Failed operations changed the inventory");
+		}
+
+		Timer::summary();
+	}
+}
@@ -0,0 +1,137 @@
+#include "Log.h"
+#include "data/Identifier.h"
+#include "item/ItemData.h"
+#include "net/Buffer.h"
+#include "util/Timer.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t SLOT_COUNT = 1'000;
+		constexpr size_t SCAN_COUNT = 5'000;
+
+		const std::vector<std::string> FORMULAS{
+			"H2O", "NaCl", "C6H12O6", "C12H22O11", "Ca5(PO4)3OH", "CaCO3", "H2SO4", "NaOH", "KMnO4", "C2H5OH", "Fe2O3", "SiO2",
+		};
+
+		/** A slot of a chemical-heavy inventory, with the data in both representations. */
+		struct Slot {
+			Identifier item;
+			nlohmann::json json;
+			ItemData data;
+		};
+
+		bool checkItemData() {
+			const nlohmann::json json = nlohmann::json::parse(R"({"durability":[3,10],"formula":"H2O","extra":{"list":[1.5,"x"]},"flag":true,"big":18446744073709551615})");
+			const ItemData data(json);
+
+			if (data.toJSON() != json || ItemData(data.toJSON()) != data || data.getHash() != ItemData(json).getHash())
+				return false;
+
+			if (data.at<ItemData::IntegerPair>("durability") != ItemData::IntegerPair(3, 10) || data.at<std::string>("formula") != "H2O")
+				return false;
+
+			if (data.get<std::string>("durability") != nullptr || data.contains("missing") || !data.contains("extra"))
+				return false;
+
+			if (ItemData{{"formula", std::string("H2O")}} != ItemData(nlohmann::json{{"formula", "H2O"}}))
+				return false;
+
+			ItemData changed = data;
+			changed.set("durability", ItemData::IntegerPair(2, 10));
+			if (changed == data || (changed < data) == (data < changed))
+				return false;
+
+			changed.set("durability", ItemData::IntegerPair(3, 10));
+			if (changed != data)
+				return false;
+
+			if (!ItemData(nlohmann::json()).empty() || !ItemData().toJSON().is_null())
+				return false;
+
+			Buffer buffer;
+			buffer << data;
+			ItemData popped;
+			buffer >> popped;
+			return popped == data;
+		}
+	}
+
+	void itemDataBenchmark() {
+		if (checkItemData())
+			SUCCESS("ItemData behaves like JSON item data.");
+		else
+			ERROR("ItemData doesn't behave like JSON item data.");
+
+		const Identifier chemical = "base:item/chemical"_id;
+		std::default_random_engine rng(1729);
+		std::vector<Slot> slots;
+		slots.reserve(SLOT_COUNT);
+
+		for (size_t i = 0; i < SLOT_COUNT; ++i) {
+			const std::string &formula = FORMULAS[rng() % FORMULAS.size()];
+			nlohmann::json json{{"formula", formula}};
+			ItemData data(json);
+			slots.push_back({chemical, std::move(json), std::move(data)});
+		}
+
+		std::vector<size_t> queries;
+		queries.reserve(SCAN_COUNT);
+		for (size_t i = 0; i < SCAN_COUNT; ++i)
+			queries.push_back(rng() % FORMULAS.size());
+
+		size_t json_count = 0;
+		size_t data_count = 0;
+
+		// Like ChemicalReactor::react: build the stack's data from a formula, then count matching slots.
+		{
+			Timer timer{"JSON data: build + scan"};
+			for (const size_t query: queries) {
+				const nlohmann::json json{{"formula", FORMULAS[query]}};
+				for (const Slot &slot: slots)
+					json_count += slot.item == chemical && slot.json == json;
+			}
+		}
+
+		{
+			Timer timer{"ItemData: build + scan"};
+			for (const size_t query: queries) {
+				const ItemData data{{"formula", FORMULAS[query]}};
+				for (const Slot &slot: slots)
+					data_count += slot.item == chemical && slot.data == data;
+			}
+		}
+
+		if (json_count != data_count)
+			ERROR("Scans disagree: " << json_count << " vs. " << data_count);
+
+		{
+			Timer timer{"JSON data: copy"};
+			std::vector<nlohmann::json> copies;
+			copies.reserve(SLOT_COUNT);
+			for (size_t i = 0; i < SCAN_COUNT / 10; ++i) {
+				copies.clear();
+				for (const Slot &slot: slots)
+					copies.push_back(slot.json);
+			}
+		}
+
+		{
+			Timer timer{"ItemData: copy"};
+			std::vector<ItemData> copies;
+			copies.reserve(SLOT_COUNT);
+			for (size_t i = 0; i < SCAN_COUNT / 10; ++i) {
+				copies.clear();
+				for (const Slot &slot: slots)
+					copies.push_back(slot.data);
+			}
+		}
+
+		Timer::summary();
+	}
+}
@@ -0,0 +1,236 @@
+#include "Log.h"
+#include "algorithm/AStar.h"
+#include "algorithm/FlowField.h"
+#include "algorithm/PathGraph.h"
+#include "algorithm/PathfindingPool.h"
+#include "game/ServerGame.h"
+#include "realm/Overworld.h"
+#include "threading/Waiter.h"
+#include "util/Timer.h"
+#include "worldgen/Overworld.h"
+
+#include <list>
+#include <random>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t SEED = 1621;
+		constexpr size_t PAIR_COUNT = 2'000;
+
+		std::vector<std::pair<Position, Position>> choosePairs(const Realm &realm, std::default_random_engine &rng, Index min, Index max, Index max_distance) {
+			std::uniform_int_distribution<Index> coordinate(min, max);
+			std::uniform_int_distribution<Index> offset(-max_distance, max_distance);
+
+			auto passable = [&](const Position &position) {
+				const auto state = realm.tileProvider.copyPathState(position);
+				return state && *state != 0;
+			};
+
+			std::vector<std::pair<Position, Position>> pairs;
+			pairs.reserve(PAIR_COUNT);
+
+			while (pairs.size() < PAIR_COUNT) {
+				const Position from(coordinate(rng), coordinate(rng));
+				const Position to(from.row + offset(rng), from.column + offset(rng));
+				if (from != to && min <= to.row && to.row <= max && min <= to.column && to.column <= max && passable(from) && passable(to))
+					pairs.emplace_back(from, to);
+			}
+
+			return pairs;
+		}
+
+		void compare(const RealmPtr &realm, const std::string &label, const std::vector<std::pair<Position, Position>> &pairs, size_t loop_max) {
+			std::vector<Position> path;
+			size_t simple_found = 0;
+			size_t simple_length = 0;
+			size_t grid_found = 0;
+			size_t grid_length = 0;
+
+			{
+				Timer timer{"simpleAStar " + label};
+				for (const auto &[from, to]: pairs) {
+					if (simpleAStar(realm, from, to, path, loop_max)) {
+						++simple_found;
+						simple_length += path.size();
+					}
+				}
+			}
+
+			{
+				Timer timer{"gridAStar " + label};
+				for (const auto &[from, to]: pairs) {
+					if (gridAStar(realm, from, to, path, loop_max)) {
+						++grid_found;
+						grid_length += path.size();
+					}
+				}
+			}
+
+			INFO(label << ": simpleAStar found " << simple_found << " paths (total length " << simple_length << "), "
+				"gridAStar found " << grid_found << " paths (total length " << grid_length << ')');
+		}
+
+		/** Finds routes over the realm's path graph, first with an empty cache and then with a warm one, and refines every
+		 *  leg with gridAStar the way an entity would while walking the route. */
+		void compareHierarchical(const RealmPtr &realm, const std::vector<std::pair<Position, Position>> &pairs) {
+			std::vector<Position> waypoints;
+			std::vector<Position> path;
+			size_t found = 0;
+			size_t length = 0;
+			size_t broken_legs = 0;
+
+			realm->pathGraph.clear();
+
+			{
+				Timer timer{"PathGraph cold"};
+				for (const auto &[from, to]: pairs)
+					realm->pathGraph.findWaypoints(from, to, waypoints);
+			}
+
+			{
+				Timer timer{"PathGraph warm"};
+				for (const auto &[from, to]: pairs)
+					realm->pathGraph.findWaypoints(from, to, waypoints);
+			}
+
+			{
+				Timer timer{"PathGraph refined"};
+				for (const auto &[from, to]: pairs) {
+					if (!realm->pathGraph.findWaypoints(from, to, waypoints))
+						continue;
+
+					++found;
+					Position leg_start = from;
+					for (const Position &waypoint: waypoints) {
+						if (leg_start != waypoint) {
+							if (gridAStar(realm, leg_start, waypoint, path, PathfindingPool::LEG_LOOP_MAX))
+								length += path.size() - 1;
+							else
+								++broken_legs;
+						}
+						leg_start = waypoint;
+					}
+				}
+			}
+
+			INFO("hierarchical: found " << found << " routes (total steps " << length << ", " << broken_legs << " unrefinable legs)");
+		}
+
+		/** Submits the pairs to a pathfinding pool the way a crowd of monsters would, with each request repeated a few times
+		 *  as if several monsters were headed for the same spot. */
+		void poolRequests(const RealmPtr &realm, const std::vector<std::pair<Position, Position>> &pairs, size_t repeats) {
+			PathfindingPool pool(4);
+			pool.start();
+
+			Waiter waiter(pairs.size() * repeats);
+			std::atomic_size_t found = 0;
+
+			{
+				Timer timer{"PathfindingPool"};
+				for (const auto &[from, to]: pairs) {
+					for (size_t i = 0; i < repeats; ++i) {
+						pool.request(realm, from, to, 1'000, [&](const std::shared_ptr<const PathSearch> &search) {
+							if (search->result == PathResult::Success)
+								++found;
+							--waiter;
+						});
+					}
+				}
+				waiter.wait();
+			}
+
+			pool.join();
+			INFO("pool: " << found << " of " << pairs.size() * repeats << " requests found paths with " << pool.getSearchCount() << " searches (" << pool.getSharedCount() << " shared)");
+		}
+
+		/** Has a crowd of chasers converge on a goal that moves a step at a time, finding paths for all of them after every
+		 *  step, first with a search each and then with a shared flow field. */
+		void compareFlowField(const RealmPtr &realm, std::default_random_engine &rng, Index min, Index max) {
+			constexpr size_t CHASER_COUNT = 40;
+			constexpr size_t STEPS = 200;
+
+			auto passable = [&](const Position &position) {
+				const auto state = realm->tileProvider.copyPathState(position);
+				return state && *state != 0;
+			};
+
+			std::uniform_int_distribution<Index> coordinate(min + FlowField::DEFAULT_RADIUS, max - FlowField::DEFAULT_RADIUS);
+			std::uniform_int_distribution<Index> offset(-16, 16);
+
+			Position goal;
+			do
+				goal = {coordinate(rng), coordinate(rng)};
+			while (!passable(goal));
+
+			std::vector<Position> chasers;
+			while (chasers.size() < CHASER_COUNT)
+				if (Position chaser(goal.row + offset(rng), goal.column + offset(rng)); chaser != goal && passable(chaser))
+					chasers.push_back(chaser);
+
+			// A random walk for the goal to follow, like a player wandering around.
+			std::vector<Position> goals{goal};
+			while (goals.size() < STEPS) {
+				const Position next = goals.back() + ALL_DIRECTIONS[rng() % ALL_DIRECTIONS.size()];
+				if (passable(next))
+					goals.push_back(next);
+			}
+
+			std::vector<Position> path;
+			size_t searched = 0;
+			size_t flowed = 0;
+
+			{
+				Timer timer{"Chasers gridAStar"};
+				for (const Position &step: goals)
+					for (const Position &chaser: chasers)
+						if (gridAStar(realm, chaser, step, path, 256))
+							++searched;
+			}
+
+			{
+				FlowField field;
+				std::list<Direction> directions;
+				Timer timer{"Chasers FlowField"};
+				for (const Position &step: goals) {
+					for (const Position &chaser: chasers) {
+						directions.clear();
+						if (field.getPath(realm->tileProvider, step, chaser, directions))
+							++flowed;
+					}
+				}
+			}
+
+			INFO("chasers: gridAStar found " << searched << " paths, flow field found " << flowed);
+		}
+	}
+
+	void pathfindingBenchmark() {
+		auto game = std::dynamic_pointer_cast<ServerGame>(Game::create(Side::Server, std::make_pair(std::shared_ptr<Server>(), size_t(1))));
+		RealmPtr realm = Realm::create<Overworld>(*game, 1, Overworld::ID(), "base:tileset/monomap", SEED);
+		realm->outdoors = true;
+
+		{
+			Timer timer{"GenerateOverworld"};
+			WorldGen::generateOverworld(realm, SEED, {}, {{-2, -2}, {2, 2}}, true);
+		}
+
+		game->addRealm(realm->id, realm);
+
+		std::default_random_engine rng(SEED);
+		const Index min = -2 * CHUNK_SIZE;
+		const Index max = 3 * CHUNK_SIZE - 1;
+
+		// Short trips like monsters chasing players and workers walking to nearby resources.
+		const auto short_pairs = choosePairs(*realm, rng, min, max, 24);
+		compare(realm, "short", short_pairs, 1'000);
+		poolRequests(realm, short_pairs, 4);
+		compareFlowField(realm, rng, min, max);
+		// Longer trips that cross several chunks.
+		const auto long_pairs = choosePairs(*realm, rng, min, max, 128);
+		compare(realm, "long", long_pairs, 20'000);
+		compareHierarchical(realm, long_pairs);
+
+		Timer::summary();
+	}
+}
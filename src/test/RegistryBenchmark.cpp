@@ -0,0 +1,117 @@
+#include "Log.h"
+#include "registry/Registries.h"
+#include "util/Timer.h"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t LOOKUP_COUNT = 10'000'000;
+
+		/** Registries have no slot unless they declare one, like registries added by data-driven code. */
+		struct UnslottedRegistry: NamedRegistry<NamedRegisterable> {
+			static Identifier ID() { return {"base", "registry/unslotted"}; }
+			UnslottedRegistry(): NamedRegistry(ID()) {}
+		};
+
+		void fill(RegistryRegistry &registries) {
+			registries.clear();
+			registries.add<ItemRegistry>();
+			registries.add<TextureRegistry>();
+			registries.add<TilesetRegistry>();
+			registries.add<OreRegistry>();
+			registries.add<RealmTypeRegistry>();
+			registries.add<PacketFactoryRegistry>();
+			registries.add<FluidRegistry>();
+			registries.add<TileRegistry>();
+			registries.add<SoundRegistry>();
+			registries.add<UnslottedRegistry>();
+		}
+
+		bool checkSlots(RegistryRegistry &registries) {
+			const RegistryRegistry &const_registries = registries;
+
+			if (&registries.get<TileRegistry>() != registries.at(TileRegistry::ID()).get())
+				return false;
+
+			if (&const_registries.get<const FluidRegistry>() != registries.at(FluidRegistry::ID()).get())
+				return false;
+
+			if (&registries.get<UnslottedRegistry>() != registries.at(UnslottedRegistry::ID()).get())
+				return false;
+
+			try {
+				registries.add<ItemRegistry>();
+				return false;
+			} catch (const std::runtime_error &) {}
+
+			registries.clear();
+
+			try {
+				(void) registries.get<ItemRegistry>();
+				return false;
+			} catch (const std::out_of_range &) {}
+
+			fill(registries);
+			return true;
+		}
+
+		size_t sizeByIdentifier(RegistryRegistry &registries, size_t which) {
+			switch (which) {
+				case 0:  return registries.NamedRegistry::get<ItemRegistry>().size();
+				case 1:  return registries.NamedRegistry::get<TileRegistry>().size();
+				case 2:  return registries.NamedRegistry::get<FluidRegistry>().size();
+				default: return registries.NamedRegistry::get<RealmTypeRegistry>().size();
+			}
+		}
+
+		size_t sizeBySlot(RegistryRegistry &registries, size_t which) {
+			switch (which) {
+				case 0:  return registries.get<ItemRegistry>().size();
+				case 1:  return registries.get<TileRegistry>().size();
+				case 2:  return registries.get<FluidRegistry>().size();
+				default: return registries.get<RealmTypeRegistry>().size();
+			}
+		}
+	}
+
+	void registryBenchmark() {
+		RegistryRegistry registries;
+		fill(registries);
+
+		if (checkSlots(registries))
+			SUCCESS("Registry slots agree with identifier lookups.");
+		else
+			ERROR("Registry slots disagree with identifier lookups.");
+
+		registries.get<RealmTypeRegistry>().add("base:realm/overworld"_id);
+
+		std::default_random_engine rng(1729);
+		std::vector<uint8_t> choices;
+		choices.reserve(LOOKUP_COUNT);
+		for (size_t i = 0; i < LOOKUP_COUNT; ++i)
+			choices.push_back(rng() % 4);
+
+		size_t identifier_sum = 0;
+		size_t slot_sum = 0;
+
+		{
+			Timer timer{"Registry lookup by identifier"};
+			for (const uint8_t which: choices)
+				identifier_sum += sizeByIdentifier(registries, which);
+		}
+
+		{
+			Timer timer{"Registry lookup by slot"};
+			for (const uint8_t which: choices)
+				slot_sum += sizeBySlot(registries, which);
+		}
+
+		if (identifier_sum != slot_sum)
+			ERROR("Lookups disagree: " << identifier_sum << " vs. " << slot_sum);
+
+		Timer::summary();
+	}
+}
@@ -0,0 +1,138 @@
+#include "Log.h"
+#include "game/Game.h"
+#include "net/Buffer.h"
+#include "net/FramedPacket.h"
+#include "net/GenericClient.h"
+#include "packet/ErrorPacket.h"
+#include "packet/TileUpdatePacket.h"
+#include "util/Endian.h"
+#include "util/Timer.h"
+
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t CLIENT_COUNT = 50;
+		constexpr size_t ROUNDS = 2'000;
+		/** How many packets each client buffers before its buffer is flushed, like a tick's worth of updates. */
+		constexpr size_t PACKETS_PER_FLUSH = 32;
+
+		/** Stands in for a client on the other end of a loopback socket. Writing copies everything into the receive buffer once,
+		 *  the way the kernel would copy it into a socket buffer. */
+		struct StandInClient {
+			std::vector<uint8_t> received;
+			size_t bytesCopied = 0;
+
+			void receive(std::span<const uint8_t> bytes) {
+				received.insert(received.end(), bytes.begin(), bytes.end());
+			}
+		};
+
+		/** The send path from before packets were framed once: every recipient encodes the packet, builds a string,
+		 *  appends the string to its send buffer and copies the buffer again when flushing it. */
+		struct LegacySender {
+			StandInClient client;
+			std::string sendBuffer;
+
+			void send(Game &game, const Packet &packet) {
+				Buffer buffer;
+				packet.encode(game, buffer);
+				const auto size = toLittle(static_cast<uint32_t>(buffer.size()));
+				const auto packet_id = toLittle(packet.getID());
+				std::span span = buffer.getSpan();
+				std::string to_send;
+				to_send.reserve(span.size_bytes() + sizeof(packet_id) + sizeof(size));
+				to_send.append(reinterpret_cast<const char *>(&packet_id), sizeof(packet_id));
+				to_send.append(reinterpret_cast<const char *>(&size), sizeof(size));
+				to_send.append(span.begin(), span.end());
+				client.bytesCopied += to_send.size();
+				sendBuffer.append(to_send);
+				client.bytesCopied += to_send.size();
+			}
+
+			void flush() {
+				std::string moved = std::move(sendBuffer);
+				sendBuffer.clear();
+				client.bytesCopied += moved.size();
+				client.receive(std::span(reinterpret_cast<const uint8_t *>(moved.data()), moved.size()));
+				client.received.clear();
+			}
+		};
+
+		/** The current send path: packets are framed once and every recipient queues the same bytes, which are written out
+		 *  with one vectored write per flush. */
+		struct FramedSender {
+			StandInClient client;
+			std::vector<FramedPacket> sendBuffer;
+
+			void send(const FramedPacket &framed) {
+				sendBuffer.push_back(framed);
+			}
+
+			void flush() {
+				for (size_t start = 0; start < sendBuffer.size(); start += GenericClient::MAX_WRITE_BATCH) {
+					const size_t end = std::min(sendBuffer.size(), start + GenericClient::MAX_WRITE_BATCH);
+					for (size_t i = start; i < end; ++i) {
+						client.bytesCopied += sendBuffer[i]->size();
+						client.receive(*sendBuffer[i]);
+					}
+				}
+				sendBuffer.clear();
+				client.received.clear();
+			}
+		};
+
+		template <typename S, typename F>
+		size_t runSenders(const std::string &name, std::vector<S> &senders, F &&send_one) {
+			Timer timer{name};
+			for (size_t round = 1; round <= ROUNDS; ++round) {
+				send_one();
+				if (round % PACKETS_PER_FLUSH == 0)
+					for (S &sender: senders)
+						sender.flush();
+			}
+			for (S &sender: senders)
+				sender.flush();
+			timer.stop();
+
+			size_t copied = 0;
+			for (const S &sender: senders)
+				copied += sender.client.bytesCopied;
+			return copied;
+		}
+
+		void benchmarkPacket(Game &game, const std::string &label, const Packet &packet) {
+			std::vector<LegacySender> legacy(CLIENT_COUNT);
+			std::vector<FramedSender> framed(CLIENT_COUNT);
+			size_t framed_bytes = 0;
+
+			const size_t legacy_copied = runSenders("Legacy " + label, legacy, [&] {
+				for (LegacySender &sender: legacy)
+					sender.send(game, packet);
+			});
+
+			const size_t framed_copied = runSenders("Framed " + label, framed, [&] {
+				const FramedPacket encoded = framePacket(game, packet);
+				framed_bytes += encoded->size();
+				for (FramedSender &sender: framed)
+					sender.send(encoded);
+			});
+
+			const size_t delivered = framed_bytes * CLIENT_COUNT;
+			INFO(label << ": legacy copied " << legacy_copied << " bytes (" << double(legacy_copied) / delivered << " per delivered byte), "
+				"framed copied " << framed_copied << " bytes (" << double(framed_copied) / delivered << " per delivered byte)");
+		}
+	}
+
+	void sendBenchmark() {
+		auto game = Game::create(Side::Client, nullptr);
+
+		benchmarkPacket(*game, "TileUpdatePacket", TileUpdatePacket(1, Layer::Terrain, Position(12, 34), 56));
+		benchmarkPacket(*game, "ErrorPacket (4 KiB)", ErrorPacket(std::string(4096, 'x')));
+
+		Timer::summary();
+	}
+}
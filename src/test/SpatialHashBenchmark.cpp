@@ -0,0 +1,264 @@
+#include "Log.h"
+#include "container/SpatialHash.h"
+#include "threading/Lockable.h"
+#include "types/ChunkPosition.h"
+#include "util/Timer.h"
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t ENTITY_COUNT = 5'000;
+		constexpr size_t QUERY_COUNT = 100'000;
+		/** Entities are spread over a square this many tiles wide, about 16 chunks' worth. */
+		constexpr Index WORLD_SIZE = 4 * CHUNK_SIZE;
+
+		struct StandInEntity {
+			GlobalID gid;
+			Lockable<Position> position;
+
+			StandInEntity(GlobalID gid_, const Position &position_):
+				gid(gid_), position(position_) {}
+		};
+
+		using StandInPtr = std::shared_ptr<StandInEntity>;
+
+		/** The layout Realm used before the spatial index: a locked set of shared pointers per chunk. */
+		struct ChunkSets {
+			Lockable<std::unordered_map<ChunkPosition, std::shared_ptr<Lockable<std::set<StandInPtr>>>>> byChunk;
+
+			void attach(const StandInPtr &entity) {
+				auto &set = byChunk[entity->position.copyBase().getChunk()];
+				if (!set)
+					set = std::make_shared<Lockable<std::set<StandInPtr>>>();
+				set->insert(entity);
+			}
+
+			void detach(const StandInPtr &entity, ChunkPosition chunk_position) {
+				if (auto iter = byChunk.find(chunk_position); iter != byChunk.end())
+					iter->second->erase(entity);
+			}
+
+			std::vector<StandInPtr> findSquare(const Position &position, uint64_t radius) const {
+				std::vector<StandInPtr> out;
+				const Position offset(radius - 1, radius - 1);
+				ChunkRange((position - offset).getChunk(), (position + offset).getChunk()).iterate([&](ChunkPosition chunk_position) {
+					std::shared_ptr<Lockable<std::set<StandInPtr>>> set;
+					{
+						auto lock = byChunk.sharedLock();
+						if (auto iter = byChunk.find(chunk_position); iter != byChunk.end())
+							set = iter->second;
+					}
+					if (!set)
+						return;
+					auto lock = set->sharedLock();
+					for (const StandInPtr &entity: *set)
+						if (entity->position.copyBase().maximumAxisDistance(position) < radius)
+							out.push_back(entity);
+				});
+				return out;
+			}
+		};
+
+		Position randomPosition(std::default_random_engine &rng) {
+			std::uniform_int_distribution<Index> coordinate(-WORLD_SIZE / 2, WORLD_SIZE / 2 - 1);
+			return {coordinate(rng), coordinate(rng)};
+		}
+
+		/** Compares every query kind against a brute force scan. */
+		bool checkQueries(std::default_random_engine &rng) {
+			std::vector<std::pair<GlobalID, Position>> entities;
+			SpatialHash index;
+
+			for (GlobalID gid = 0; gid < 2'000; ++gid) {
+				entities.emplace_back(gid, randomPosition(rng));
+				index.insert(gid, entities.back().second);
+			}
+
+			// Move and remove some entities to exercise the bookkeeping.
+			for (size_t i = 0; i < 1'000; ++i) {
+				auto &[gid, position] = entities[rng() % entities.size()];
+				position = randomPosition(rng);
+				index.move(gid, position);
+			}
+
+			for (size_t i = 0; i < 200; ++i) {
+				const size_t removed = rng() % entities.size();
+				index.remove(entities[removed].first);
+				entities.erase(entities.begin() + removed);
+			}
+
+			if (index.size() != entities.size())
+				return false;
+
+			for (size_t i = 0; i < 500; ++i) {
+				const Position center = randomPosition(rng);
+				const uint64_t radius = rng() % 24;
+				const Direction direction = ALL_DIRECTIONS[rng() % ALL_DIRECTIONS.size()];
+				const Position step = toPosition(direction);
+
+				std::vector<GlobalID> expected_square, expected_circle, found_square, found_circle;
+				std::vector<std::pair<uint64_t, GlobalID>> expected_ray;
+				std::vector<GlobalID> found_ray;
+
+				for (const auto &[gid, position]: entities) {
+					if (position.maximumAxisDistance(center) < radius)
+						expected_square.push_back(gid);
+					if (position.distance(center) <= radius)
+						expected_circle.push_back(gid);
+					for (uint64_t distance = 1; distance <= radius; ++distance)
+						if (center + step * distance == position)
+							expected_ray.emplace_back(distance, gid);
+				}
+
+				index.visitSquare(center, radius, [&](GlobalID gid, const Position &) { found_square.push_back(gid); return false; });
+				index.visitCircle(center, radius, [&](GlobalID gid, const Position &) { found_circle.push_back(gid); return false; });
+				index.visitRay(center, direction, radius, [&](GlobalID gid, const Position &) { found_ray.push_back(gid); return false; });
+
+				std::sort(expected_square.begin(), expected_square.end());
+				std::sort(found_square.begin(), found_square.end());
+				std::sort(expected_circle.begin(), expected_circle.end());
+				std::sort(found_circle.begin(), found_circle.end());
+				std::sort(expected_ray.begin(), expected_ray.end());
+
+				if (expected_square != found_square || expected_circle != found_circle || expected_ray.size() != found_ray.size())
+					return false;
+
+				// Rays visit nearest first; entities on the same tile can come in any order.
+				for (size_t j = 0; j < found_ray.size(); ++j) {
+					const auto found = std::find_if(expected_ray.begin(), expected_ray.end(), [&](const auto &pair) { return pair.second == found_ray[j]; });
+					if (found == expected_ray.end() || found->first != expected_ray[j].first)
+						return false;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	void spatialHashBenchmark() {
+		std::default_random_engine rng(1729);
+
+		if (checkQueries(rng))
+			SUCCESS("Spatial hash queries match brute force.");
+		else
+			ERROR("Spatial hash queries don't match brute force.");
+
+		std::vector<StandInPtr> entities;
+		entities.reserve(ENTITY_COUNT);
+		for (GlobalID gid = 0; gid < ENTITY_COUNT; ++gid)
+			entities.push_back(std::make_shared<StandInEntity>(gid, randomPosition(rng)));
+
+		std::vector<Position> centers;
+		centers.reserve(QUERY_COUNT);
+		for (size_t i = 0; i < QUERY_COUNT; ++i)
+			centers.push_back(randomPosition(rng));
+
+		// Steps taken by random entities, as when monsters and animals walk around.
+		std::vector<std::pair<size_t, Direction>> moves;
+		moves.reserve(QUERY_COUNT);
+		for (size_t i = 0; i < QUERY_COUNT; ++i)
+			moves.emplace_back(rng() % ENTITY_COUNT, ALL_DIRECTIONS[rng() % ALL_DIRECTIONS.size()]);
+
+		ChunkSets chunk_sets;
+		Lockable<SpatialHash> index;
+
+		{
+			Timer timer{"ChunkSets insert"};
+			for (const StandInPtr &entity: entities)
+				chunk_sets.attach(entity);
+		}
+
+		{
+			Timer timer{"SpatialHash insert"};
+			for (const StandInPtr &entity: entities)
+				index.insert(entity->gid, entity->position);
+		}
+
+		size_t chunk_found = 0;
+		size_t index_found = 0;
+		size_t index_circle_found = 0;
+		size_t index_ray_found = 0;
+
+		// Monster search radius.
+		constexpr uint64_t RADIUS = 8;
+
+		{
+			Timer timer{"ChunkSets square"};
+			for (const Position &center: centers)
+				chunk_found += chunk_sets.findSquare(center, RADIUS).size();
+		}
+
+		{
+			Timer timer{"SpatialHash square"};
+			for (const Position &center: centers) {
+				auto lock = index.sharedLock();
+				index.visitSquare(center, RADIUS, [&](GlobalID, const Position &) {
+					++index_found;
+					return false;
+				});
+			}
+		}
+
+		{
+			Timer timer{"SpatialHash circle"};
+			for (const Position &center: centers) {
+				auto lock = index.sharedLock();
+				index.visitCircle(center, RADIUS, [&](GlobalID, const Position &) {
+					++index_circle_found;
+					return false;
+				});
+			}
+		}
+
+		{
+			Timer timer{"SpatialHash ray"};
+			for (size_t i = 0; i < centers.size(); ++i) {
+				auto lock = index.sharedLock();
+				index.visitRay(centers[i], ALL_DIRECTIONS[i % ALL_DIRECTIONS.size()], 2 * RADIUS, [&](GlobalID, const Position &) {
+					++index_ray_found;
+					return false;
+				});
+			}
+		}
+
+		std::vector<Position> index_positions;
+		index_positions.reserve(entities.size());
+		for (const StandInPtr &entity: entities)
+			index_positions.push_back(entity->position.copyBase());
+
+		{
+			Timer timer{"ChunkSets move"};
+			for (const auto &[entity_index, direction]: moves) {
+				StandInEntity &entity = *entities[entity_index];
+				const Position old_position = entity.position.copyBase();
+				const Position new_position = old_position + direction;
+				entity.position = new_position;
+				if (old_position.getChunk() != new_position.getChunk()) {
+					chunk_sets.detach(entities[entity_index], old_position.getChunk());
+					chunk_sets.attach(entities[entity_index]);
+				}
+			}
+		}
+
+		{
+			Timer timer{"SpatialHash move"};
+			for (const auto &[entity_index, direction]: moves) {
+				Position &position = index_positions[entity_index];
+				position += direction;
+				auto lock = index.uniqueLock();
+				index.move(entities[entity_index]->gid, position);
+			}
+		}
+
+		INFO("Square queries found " << chunk_found << " (chunk sets) and " << index_found << " (spatial hash) entities; "
+			"circles found " << index_circle_found << ", rays found " << index_ray_found);
+
+		Timer::summary();
+	}
+}
@@ -0,0 +1,69 @@
+#include "Log.h"
+#include "game/TickScheduler.h"
+#include "util/Histogram.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Game3 {
+	namespace {
+		using namespace std::chrono_literals;
+
+		constexpr size_t TICK_COUNT = 200;
+		/** Every this many ticks, one tick stalls for several periods. */
+		constexpr size_t STALL_INTERVAL = 50;
+
+		/** Runs ticks that take a fifth of the period, with an occasional long stall, and returns the scheduler's stats. */
+		TickScheduler::Stats runScheduler(TickScheduler &scheduler, std::chrono::nanoseconds stall) {
+			std::atomic_bool running = true;
+			size_t ticks = 0;
+
+			scheduler.run(running, [&] {
+				if (++ticks % STALL_INTERVAL == 0)
+					std::this_thread::sleep_for(stall);
+				else
+					std::this_thread::sleep_for(scheduler.getPeriod() / 5);
+
+				if (ticks == TICK_COUNT)
+					running = false;
+			});
+
+			return scheduler.getStats();
+		}
+	}
+
+	void tickSchedulerTest() {
+		constexpr auto period = 5ms;
+		// Long enough to miss the next four deadlines. When dropping, one tick runs late and the other three are dropped.
+		constexpr auto stall = 4 * period + period / 2;
+
+		TickScheduler catching_up(period, 8);
+		const auto start = std::chrono::steady_clock::now();
+		const TickScheduler::Stats caught_up = runScheduler(catching_up, stall);
+		const std::chrono::duration<double> caught_up_time = std::chrono::steady_clock::now() - start;
+
+		TickScheduler dropping(period, 0);
+		const TickScheduler::Stats dropped = runScheduler(dropping, stall);
+
+		printHistogram(catching_up.getHistogram());
+
+		INFO("Catching up: " << caught_up.ticks << " ticks in " << caught_up_time.count() << "s, TPS " << caught_up.tps << ", MSPT " << caught_up.mspt
+			<< " (max " << caught_up.maxMspt << "), " << caught_up.overruns << " overruns, " << caught_up.dropped << " dropped");
+		INFO("Dropping: " << dropped.ticks << " ticks, TPS " << dropped.tps << ", MSPT " << dropped.mspt << " (max " << dropped.maxMspt << "), "
+			<< dropped.overruns << " overruns, " << dropped.dropped << " dropped");
+
+		const size_t stalls = TICK_COUNT / STALL_INTERVAL;
+
+		// Catching up keeps the schedule, so the whole run takes about as long as TICK_COUNT periods.
+		if (caught_up.dropped == 0 && caught_up.overruns == stalls && caught_up_time < TICK_COUNT * period * 1.1)
+			SUCCESS("Catch-up scheduling stayed on schedule.");
+		else
+			ERROR("Catch-up scheduling fell behind.");
+
+		if (dropped.dropped == 3 * stalls && dropped.overruns == stalls)
+			SUCCESS("Drop scheduling dropped the missed ticks.");
+		else
+			ERROR("Drop scheduling dropped " << dropped.dropped << " ticks instead of " << 3 * stalls);
+	}
+}
@@ -0,0 +1,210 @@
+#include "Log.h"
+#include "container/WeakSet.h"
+#include "util/Timer.h"
+
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace Game3 {
+	namespace {
+		constexpr size_t OBJECT_COUNT = 2'000;
+		constexpr size_t OPERATION_COUNT = 1'000'000;
+
+		struct StandIn {
+			size_t value;
+			StandIn(size_t value_): value(value_) {}
+		};
+
+		struct StandInSubclass: StandIn {
+			using StandIn::StandIn;
+		};
+
+		/** The ordering WeakSet used before: both operands are locked at every comparison. */
+		template <typename T>
+		struct LockingCompare {
+			bool operator()(std::weak_ptr<T> left, std::weak_ptr<T> right) const {
+				auto llock = left.lock();
+				auto rlock = right.lock();
+				if (!rlock)
+					return false;
+				if (!llock)
+					return true;
+				return llock.get() < rlock.get();
+			}
+		};
+
+		template <typename T>
+		using LockingSet = std::set<std::weak_ptr<T>, LockingCompare<T>>;
+
+		/** Exercises lookups, erasure, expiry, address reuse and subclass pointers. */
+		bool checkSet() {
+			WeakSet<StandIn> set;
+			std::vector<std::shared_ptr<StandIn>> objects;
+
+			for (size_t i = 0; i < 100; ++i) {
+				objects.push_back(std::make_shared<StandIn>(i));
+				if (!set.insert(objects.back()))
+					return false;
+			}
+
+			if (set.insert(objects.front()) || set.size() != 100)
+				return false;
+
+			for (size_t i = 0; i < 100; i += 2)
+				if (set.erase(std::weak_ptr(objects[i])) != 1)
+					return false;
+
+			for (size_t i = 0; i < 100; ++i)
+				if (set.contains(objects[i]) != (i % 2 == 1))
+					return false;
+
+			// Expired entries stay until swept, and can still be erased by their weak pointer.
+			std::weak_ptr<StandIn> expired = objects[1];
+			objects[1].reset();
+			objects[3].reset();
+			if (set.size() != 50 || set.erase(expired) != 1 || set.sweep() != 1 || set.size() != 48)
+				return false;
+
+			const auto subclass = std::make_shared<StandInSubclass>(100);
+			if (!set.insert(subclass) || !set.contains(std::weak_ptr(subclass)) || set.erase(subclass) != 1)
+				return false;
+
+			size_t visited = 0;
+			for (const auto &weak: set)
+				visited += weak.lock() != nullptr;
+
+			if (visited != 48 || set.eraseIf([](const auto &weak) { return weak.lock()->value < 50; }) != 23 || set.size() != 25)
+				return false;
+
+			// A new object at an expired object's address mustn't be mistaken for the old one.
+			for (size_t attempt = 0; attempt < 100; ++attempt) {
+				WeakSet<StandIn> reuse_set;
+				auto first = std::make_shared<StandIn>(0);
+				const void *address = first.get();
+				std::weak_ptr<StandIn> weak_first = first;
+				reuse_set.insert(first);
+				first.reset();
+
+				auto second = std::make_shared<StandIn>(1);
+				if (second.get() != address)
+					continue;
+
+				if (reuse_set.contains(second) || !reuse_set.insert(second) || reuse_set.size() != 1 || !reuse_set.contains(second))
+					return false;
+				return reuse_set.erase(weak_first) == 0;
+			}
+
+			return true;
+		}
+
+		template <typename S>
+		size_t run(S &set, const std::vector<std::shared_ptr<StandIn>> &objects, const std::vector<size_t> &operations) {
+			size_t found = 0;
+
+			for (size_t i = 0; i < operations.size(); ++i) {
+				const std::shared_ptr<StandIn> &object = objects[operations[i]];
+				switch (i % 4) {
+					case 0:
+						set.insert(object);
+						break;
+					case 1:
+						found += set.contains(object);
+						break;
+					case 2:
+						found += set.contains(std::weak_ptr(object));
+						break;
+					default:
+						set.erase(object);
+						break;
+				}
+			}
+
+			return found;
+		}
+
+		template <typename S>
+		size_t iterate(const S &set, size_t passes) {
+			size_t live = 0;
+			for (size_t pass = 0; pass < passes; ++pass)
+				for (const auto &weak: set)
+					if (auto locked = weak.lock())
+						live += locked->value != 0;
+			return live;
+		}
+	}
+
+	void weakSetBenchmark() {
+		if (checkSet())
+			SUCCESS("WeakSet behaves like a set.");
+		else
+			ERROR("WeakSet doesn't behave like a set.");
+
+		std::default_random_engine rng(1729);
+
+		std::vector<std::shared_ptr<StandIn>> objects;
+		objects.reserve(OBJECT_COUNT);
+		for (size_t i = 0; i < OBJECT_COUNT; ++i)
+			objects.push_back(std::make_shared<StandIn>(i));
+
+		std::vector<size_t> operations;
+		operations.reserve(OPERATION_COUNT);
+		for (size_t i = 0; i < OPERATION_COUNT; ++i)
+			operations.push_back(rng() % OBJECT_COUNT);
+
+		LockingSet<StandIn> locking_set;
+		WeakSet<StandIn> weak_set;
+		size_t locking_found = 0;
+		size_t weak_found = 0;
+
+		{
+			Timer timer{"LockingSet mixed"};
+			locking_found = run(locking_set, objects, operations);
+		}
+
+		{
+			Timer timer{"WeakSet mixed"};
+			weak_found = run(weak_set, objects, operations);
+		}
+
+		if (locking_found != weak_found || locking_set.size() != weak_set.size())
+			ERROR("Mixed operations disagree: " << locking_found << " vs. " << weak_found << " found, " << locking_set.size() << " vs. " << weak_set.size() << " left");
+
+		for (const auto &object: objects) {
+			locking_set.insert(object);
+			weak_set.insert(object);
+		}
+
+		size_t locking_live = 0;
+		size_t weak_live = 0;
+
+		{
+			Timer timer{"LockingSet iterate"};
+			locking_live = iterate(locking_set, 200);
+		}
+
+		{
+			Timer timer{"WeakSet iterate"};
+			weak_live = iterate(weak_set, 200);
+		}
+
+		// Let half the objects expire, as when entities despawn, then keep inserting fresh ones.
+		for (size_t i = 0; i < OBJECT_COUNT; i += 2)
+			objects[i] = std::make_shared<StandIn>(i);
+
+		{
+			Timer timer{"LockingSet churn"};
+			locking_found = run(locking_set, objects, operations);
+		}
+
+		{
+			Timer timer{"WeakSet churn"};
+			weak_found = run(weak_set, objects, operations);
+		}
+
+		INFO("Iteration saw " << locking_live << " and " << weak_live << " live entries; after churn the sets hold " << locking_set.size() << " and " << weak_set.size() << " entries");
+
+		Timer::summary();
+	}
+}
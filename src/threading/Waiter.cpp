@@ -1,12 +1,18 @@
 #include "threading/Waiter.h"
 
+#include <stdexcept>
+#include <utility>
+
 namespace Game3 {
 	Waiter::Waiter(size_t remaining_) noexcept:
 		remaining(remaining_) {}
 
 	Waiter & Waiter::operator--() noexcept {
-		if (--remaining == 0)
+		if (--remaining == 0) {
+			// Hold the mutex so the notification can't slip in between wait()'s predicate check and its sleep.
+			std::unique_lock lock(mutex);
 			condition.notify_all();
+		}
 		return *this;
 	}
 
@@ -22,5 +28,23 @@ namespace Game3 {
 	void Waiter::reset(size_t new_remaining) {
 		if (remaining.exchange(new_remaining) != 0)
 			throw std::runtime_error("Reset an unfinished Waiter");
+		std::unique_lock lock(mutex);
+		exception = nullptr;
+	}
+
+	void Waiter::fail(std::exception_ptr new_exception) noexcept {
+		std::unique_lock lock(mutex);
+		if (!exception)
+			exception = std::move(new_exception);
+	}
+
+	void Waiter::rethrow() {
+		std::exception_ptr to_throw;
+		{
+			std::unique_lock lock(mutex);
+			to_throw = std::exchange(exception, nullptr);
+		}
+		if (to_throw)
+			std::rethrow_exception(to_throw);
 	}
 }
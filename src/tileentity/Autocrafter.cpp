@@ -269,7 +269,7 @@ namespace Game3 {
 
 		{
 			auto energetic_lock = EnergeticTileEntity::observers.uniqueLock();
-			std::erase_if(EnergeticTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+			EnergeticTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 				if (auto player = weak_player.lock()) {
 					player->send(energy_packet);
 					return false;
@@ -280,7 +280,7 @@ namespace Game3 {
 		}
 
 		auto inventoried_lock = InventoriedTileEntity::observers.uniqueLock();
-		std::erase_if(InventoriedTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		InventoriedTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -319,6 +319,7 @@ namespace Game3 {
 			return;
 
 		InventoryPtr inventory = getInventory(0);
+		auto inventory_lock = inventory->uniqueLock();
 		const ItemCount input_capacity = INPUT_CAPACITY;
 		auto input_span = std::make_shared<InventorySpan>(inventory, 0, input_capacity - 1);
 		auto output_span = std::make_shared<InventorySpan>(inventory, input_capacity, input_capacity + OUTPUT_CAPACITY - 1);
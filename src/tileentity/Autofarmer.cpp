@@ -122,7 +122,7 @@ namespace Game3 {
 
 		auto energetic_lock = EnergeticTileEntity::observers.uniqueLock();
 
-		std::erase_if(EnergeticTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		EnergeticTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -133,7 +133,7 @@ namespace Game3 {
 
 		auto inventoried_lock = InventoriedTileEntity::observers.uniqueLock();
 
-		std::erase_if(InventoriedTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		InventoriedTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				if (!EnergeticTileEntity::observers.contains(player))
 					player->send(packet);
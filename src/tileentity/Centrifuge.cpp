@@ -115,7 +115,7 @@ namespace Game3 {
 
 		auto inventoried_lock = InventoriedTileEntity::observers.uniqueLock();
 
-		std::erase_if(InventoriedTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		InventoriedTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -126,7 +126,7 @@ namespace Game3 {
 
 		auto fluid_holding_lock = FluidHoldingTileEntity::observers.uniqueLock();
 
-		std::erase_if(FluidHoldingTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		FluidHoldingTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				if (!InventoriedTileEntity::observers.contains(player))
 					player->send(packet);
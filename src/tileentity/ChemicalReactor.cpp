@@ -157,7 +157,7 @@ namespace Game3 {
 
 		{
 			auto energetic_lock = EnergeticTileEntity::observers.uniqueLock();
-			std::erase_if(EnergeticTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+			EnergeticTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 				if (auto player = weak_player.lock()) {
 					player->send(energy_packet);
 					return false;
@@ -169,7 +169,7 @@ namespace Game3 {
 
 		auto inventoried_lock = InventoriedTileEntity::observers.uniqueLock();
 
-		std::erase_if(InventoriedTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		InventoriedTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -237,13 +237,12 @@ namespace Game3 {
 		fillReactants();
 		fillProducts();
 
-		auto shared_inventory_lock = inventory->sharedLock();
+		auto inventory_lock = inventory->uniqueLock();
 
 		Game &game = getGame();
 		auto &item_registry = game.registry<ItemRegistry>();
 		std::shared_ptr<Item> chemical_item = item_registry["base:item/chemical"_id];
-		std::unique_ptr<Inventory> inventory_copy = inventory->copy();
-		inventory_copy->weakOwner = {};
+		auto transaction = inventory->transaction();
 
 		{
 			auto reactant_lock = reactants.sharedLock();
@@ -257,14 +256,14 @@ namespace Game3 {
 			};
 
 			for (const auto &[reactant, count]: reactants) {
-				stacks.emplace_back(game, chemical_item, count, nlohmann::json{{"formula", reactant}});
-				const ItemCount in_inventory = inventory_copy->count(stacks.back(), slot_predicate);
+				stacks.emplace_back(game, chemical_item, count, ItemData{{"formula", reactant}});
+				const ItemCount in_inventory = inventory->count(stacks.back(), slot_predicate);
 				if (in_inventory < count)
 					return false;
 			}
 
 			for (const ItemStack &stack: stacks) {
-				const ItemCount removed = inventory_copy->remove(stack, predicate);
+				const ItemCount removed = inventory->remove(stack, predicate);
 				if (stack.count != removed)
 					throw std::runtime_error("Couldn't remove stack from ChemicalReactor (" + std::to_string(stack.count) + " in stack != " + std::to_string(removed) + " removed)");
 			}
@@ -277,12 +276,10 @@ namespace Game3 {
 			};
 
 			for (const auto &[product, count]: products)
-				if (auto leftover = inventory_copy->add(ItemStack(game, chemical_item, count, nlohmann::json{{"formula", product}}), predicate))
+				if (auto leftover = inventory->add(ItemStack(game, chemical_item, count, ItemData{{"formula", product}}), predicate))
 					return false;
 		}
 
-		shared_inventory_lock.unlock();
-
 		{
 			auto equation_lock = equation.uniqueLock();
 			auto energy_lock = energyContainer->uniqueLock();
@@ -292,13 +289,7 @@ namespace Game3 {
 			EnergeticTileEntity::queueBroadcast();
 		}
 
-		// Silly.
-		auto storage_inventory = std::dynamic_pointer_cast<StorageInventory>(inventory);
-		assert(storage_inventory);
-		inventory_copy->weakOwner = shared_from_this();
-		*storage_inventory = std::move(dynamic_cast<StorageInventory &>(*inventory_copy));
-		inventory->notifyOwner();
-
+		transaction.commit();
 		return true;
 	}
 
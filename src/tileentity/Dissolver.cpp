@@ -136,7 +136,7 @@ namespace Game3 {
 
 		{
 			auto energetic_lock = EnergeticTileEntity::observers.uniqueLock();
-			std::erase_if(EnergeticTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+			EnergeticTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 				if (auto player = weak_player.lock()) {
 					player->send(energy_packet);
 					return false;
@@ -147,7 +147,7 @@ namespace Game3 {
 		}
 
 		auto inventoried_lock = InventoriedTileEntity::observers.uniqueLock();
-		std::erase_if(InventoriedTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		InventoriedTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -195,13 +195,12 @@ namespace Game3 {
 		if (!recipe)
 			return false;
 
-		std::shared_ptr<Inventory> inventory_copy = inventory->copy();
-		auto suppressor = inventory_copy->suppress();
+		auto transaction = inventory->transaction();
 
 		std::optional<std::vector<ItemStack>> leftovers;
 
-		auto input_span  = std::make_shared<InventorySpan>(inventory_copy, 0, INPUT_CAPACITY - 1);
-		auto output_span = std::make_shared<InventorySpan>(inventory_copy, INPUT_CAPACITY, INPUT_CAPACITY + OUTPUT_CAPACITY - 1);
+		auto input_span  = std::make_shared<InventorySpan>(inventory, 0, INPUT_CAPACITY - 1);
+		auto output_span = std::make_shared<InventorySpan>(inventory, INPUT_CAPACITY, INPUT_CAPACITY + OUTPUT_CAPACITY - 1);
 
 		size_t atom_count{};
 
@@ -216,13 +215,7 @@ namespace Game3 {
 			EnergeticTileEntity::queueBroadcast();
 		}
 
-		// Silly.
-		auto storage_inventory = std::dynamic_pointer_cast<StorageInventory>(inventory);
-		assert(storage_inventory);
-		inventory_copy->weakOwner = shared_from_this();
-		suppressor.cancel();
-		*storage_inventory = std::move(dynamic_cast<StorageInventory &>(*inventory_copy));
-		inventory->notifyOwner();
+		transaction.commit();
 
 		return true;
 	}
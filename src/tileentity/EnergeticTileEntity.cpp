@@ -113,7 +113,7 @@ namespace Game3 {
 		assert(getSide() == Side::Server);
 		auto lock = observers.uniqueLock();
 
-		std::erase_if(observers, [&](const std::weak_ptr<Player> &weak_player) {
+		observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -149,7 +149,7 @@ namespace Game3 {
 
 		auto energetic_lock = EnergeticTileEntity::observers.uniqueLock();
 
-		std::erase_if(EnergeticTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		EnergeticTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				player->send(packet);
 				return false;
@@ -160,7 +160,7 @@ namespace Game3 {
 
 		auto fluid_holding_lock = FluidHoldingTileEntity::observers.uniqueLock();
 
-		std::erase_if(FluidHoldingTileEntity::observers, [&](const std::weak_ptr<Player> &weak_player) {
+		FluidHoldingTileEntity::observers.eraseIf([&](const std::weak_ptr<Player> &weak_player) {
 			if (auto player = weak_player.lock()) {
 				if (!EnergeticTileEntity::observers.contains(player))
 					player->send(packet);
@@ -836,11 +836,11 @@ namespace Game3 {
 				case GDK_KEY_t:
 					if (Modifiers(modifiers).ctrl) {
 						RealmPtr realm = game->player->getRealm();
-						const auto &chunk = realm->tileProvider.getTileChunk(Layer::Terrain, game->player->getChunk());
-						auto lock = chunk.sharedLock();
+						const auto chunk = std::as_const(realm->tileProvider).getTileChunk(Layer::Terrain, game->player->getChunk());
+						auto lock = chunk->sharedLock();
 						for (size_t row = 0; row < CHUNK_SIZE; ++row) {
 							for (size_t column = 0; column < CHUNK_SIZE; ++column)
-								std::cout << std::setw(4) << std::right << chunk.at(row * CHUNK_SIZE + column);
+								std::cout << std::setw(4) << std::right << chunk->at(row * CHUNK_SIZE + column);
 							std::cout << '\n';
 						}
 					} else {
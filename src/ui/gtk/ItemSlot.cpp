@@ -93,8 +93,8 @@ namespace Game3 {
 			tooltip += " \u00d7 " + std::to_string(stack.count);
 
 		if (stack.hasDurability()) {
-			const nlohmann::json &durability = stack.data.at("durability");
-			tooltip += "\n(" + std::to_string(durability.at(0).get<Durability>()) + '/' + std::to_string(durability.at(1).get<Durability>()) + ')';
+			const auto [durability, max_durability] = stack.data.at<ItemData::IntegerPair>("durability");
+			tooltip += "\n(" + std::to_string(durability) + '/' + std::to_string(max_durability) + ')';
 			addDurabilityBar(stack.getDurabilityFraction());
 		} else if (durabilityVisible) {
 			durabilityVisible = false;
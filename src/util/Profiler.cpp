@@ -0,0 +1,313 @@
+#include "util/Profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace Game3 {
+	namespace {
+		struct Node {
+			uint32_t parent = Profiler::ROOT_NODE;
+			ProfileZoneID zone = 0;
+		};
+
+		/** Only written by the thread that owns it, so updates don't need read-modify-write operations. */
+		struct Slot {
+			std::atomic<uint64_t> nanos{0};
+			std::atomic<uint64_t> count{0};
+		};
+
+		struct ThreadProfile {
+			uint32_t current = Profiler::ROOT_NODE;
+			/** Maps (parent node << 32 | zone) to a node so the global node table is only consulted once per path. */
+			std::unordered_map<uint64_t, uint32_t> children;
+			std::array<Slot, Profiler::MAX_NODES> slots;
+		};
+
+		struct Registry {
+			std::shared_mutex namesMutex;
+			std::deque<std::string> names;
+			std::map<std::string, ProfileZoneID, std::less<>> zoneIDs;
+
+			std::mutex nodesMutex;
+			std::array<Node, Profiler::MAX_NODES> nodes;
+			std::atomic<uint32_t> nodeCount{1};
+			std::unordered_map<uint64_t, uint32_t> nodeIDs;
+
+			std::mutex threadsMutex;
+			std::vector<ThreadProfile *> threads;
+			/** Totals from threads that have exited. */
+			Profiler::Snapshot retired = Profiler::Snapshot(Profiler::MAX_NODES);
+
+			std::mutex baselineMutex;
+			Profiler::Snapshot baseline;
+
+			ProfileZoneID internName(std::string_view name) {
+				{
+					std::shared_lock lock(namesMutex);
+					if (auto iter = zoneIDs.find(name); iter != zoneIDs.end())
+						return iter->second;
+				}
+
+				std::unique_lock lock(namesMutex);
+				if (auto iter = zoneIDs.find(name); iter != zoneIDs.end())
+					return iter->second;
+
+				const auto id = static_cast<ProfileZoneID>(names.size());
+				names.emplace_back(name);
+				zoneIDs.emplace(names.back(), id);
+				return id;
+			}
+
+			uint32_t internNode(uint32_t parent, ProfileZoneID zone) {
+				const uint64_t key = (static_cast<uint64_t>(parent) << 32) | zone;
+				std::unique_lock lock(nodesMutex);
+
+				if (auto iter = nodeIDs.find(key); iter != nodeIDs.end())
+					return iter->second;
+
+				const uint32_t id = nodeCount.load(std::memory_order_relaxed);
+				if (id == Profiler::OVERFLOW_NODE)
+					return Profiler::OVERFLOW_NODE;
+
+				nodes[id] = {parent, zone};
+				nodeCount.store(id + 1, std::memory_order_release);
+				nodeIDs.emplace(key, id);
+				return id;
+			}
+
+			Registry() {
+				internName("[root]");
+				nodes[Profiler::OVERFLOW_NODE] = {Profiler::ROOT_NODE, internName("[overflow]")};
+			}
+		};
+
+		/** Never destroyed, so threads that outlive static destruction can still record. */
+		Registry & getRegistry() {
+			static Registry *registry = new Registry;
+			return *registry;
+		}
+
+		struct ThreadProfileHolder {
+			std::unique_ptr<ThreadProfile> profile = std::make_unique<ThreadProfile>();
+
+			ThreadProfileHolder() {
+				Registry &registry = getRegistry();
+				std::unique_lock lock(registry.threadsMutex);
+				registry.threads.push_back(profile.get());
+			}
+
+			~ThreadProfileHolder() {
+				Registry &registry = getRegistry();
+				std::unique_lock lock(registry.threadsMutex);
+				std::erase(registry.threads, profile.get());
+				for (uint32_t node = 0; node < Profiler::MAX_NODES; ++node) {
+					registry.retired[node].time += std::chrono::nanoseconds(profile->slots[node].nanos.load(std::memory_order_relaxed));
+					registry.retired[node].count += profile->slots[node].count.load(std::memory_order_relaxed);
+				}
+			}
+		};
+
+		ThreadProfile & getThreadProfile() {
+			thread_local ThreadProfileHolder holder;
+			return *holder.profile;
+		}
+
+		Profiler::Sample difference(const Profiler::Snapshot &now, const Profiler::Snapshot &before, uint32_t node) {
+			if (before.size() <= node)
+				return now[node];
+			return {now[node].time - before[node].time, now[node].count - before[node].count};
+		}
+	}
+
+	ProfileZoneID Profiler::intern(std::string_view name) {
+		return getRegistry().internName(name);
+	}
+
+	std::string Profiler::getName(ProfileZoneID zone) {
+		Registry &registry = getRegistry();
+		std::shared_lock lock(registry.namesMutex);
+		return zone < registry.names.size()? registry.names[zone] : "[unknown]";
+	}
+
+	uint32_t Profiler::enter(ProfileZoneID zone, uint32_t &parent) {
+		ThreadProfile &profile = getThreadProfile();
+		parent = profile.current;
+
+		const uint64_t key = (static_cast<uint64_t>(parent) << 32) | zone;
+		auto iter = profile.children.find(key);
+		if (iter == profile.children.end())
+			iter = profile.children.emplace(key, getRegistry().internNode(parent, zone)).first;
+
+		profile.current = iter->second;
+		return iter->second;
+	}
+
+	void Profiler::leave(uint32_t node, uint32_t parent, std::chrono::nanoseconds time) {
+		ThreadProfile &profile = getThreadProfile();
+		Slot &slot = profile.slots[node];
+		slot.nanos.store(slot.nanos.load(std::memory_order_relaxed) + time.count(), std::memory_order_relaxed);
+		slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+		if (profile.current == node)
+			profile.current = parent;
+	}
+
+	Profiler::Snapshot Profiler::snapshot() {
+		Registry &registry = getRegistry();
+		std::unique_lock lock(registry.threadsMutex);
+		Snapshot out = registry.retired;
+
+		for (const ThreadProfile *profile: registry.threads) {
+			for (uint32_t node = 0; node < MAX_NODES; ++node) {
+				out[node].time += std::chrono::nanoseconds(profile->slots[node].nanos.load(std::memory_order_relaxed));
+				out[node].count += profile->slots[node].count.load(std::memory_order_relaxed);
+			}
+		}
+
+		return out;
+	}
+
+	std::vector<Profiler::Entry> Profiler::report(const Snapshot &now, const Snapshot &before) {
+		Registry &registry = getRegistry();
+		const uint32_t node_count = registry.nodeCount.load(std::memory_order_acquire);
+
+		std::vector<Node> nodes(registry.nodes.begin(), registry.nodes.begin() + node_count);
+		nodes.push_back(registry.nodes[OVERFLOW_NODE]);
+		auto node_id = [&](size_t index) {
+			return index < node_count? static_cast<uint32_t>(index) : OVERFLOW_NODE;
+		};
+
+		// A child's ID is always greater than its parent's, so walking backward marks ancestors after their descendants.
+		std::vector<bool> included(nodes.size(), false);
+		for (size_t index = nodes.size(); 1 < index--;) {
+			if (difference(now, before, node_id(index)).count != 0)
+				included[index] = true;
+			if (included[index] && nodes[index].parent != ROOT_NODE)
+				included[nodes[index].parent] = true;
+		}
+
+		std::vector<std::vector<size_t>> children(nodes.size());
+		for (size_t index = 1; index < nodes.size(); ++index)
+			if (included[index])
+				children[nodes[index].parent].push_back(index);
+
+		for (std::vector<size_t> &siblings: children) {
+			std::sort(siblings.begin(), siblings.end(), [&](size_t left, size_t right) {
+				return difference(now, before, node_id(left)).time > difference(now, before, node_id(right)).time;
+			});
+		}
+
+		std::vector<Entry> out;
+
+		auto visit = [&](auto &self, size_t index, const std::string &parent_path, size_t depth) -> void {
+			const Node &node = nodes[index];
+			std::string path = parent_path.empty()? getName(node.zone) : parent_path + '/' + getName(node.zone);
+			out.push_back({node.zone, path, depth, difference(now, before, node_id(index))});
+			for (const size_t child: children[index])
+				self(self, child, path, depth + 1);
+		};
+
+		for (const size_t index: children[ROOT_NODE])
+			visit(visit, index, {}, 0);
+
+		return out;
+	}
+
+	Profiler::Sample Profiler::total(ProfileZoneID zone, const Snapshot &now, const Snapshot &before) {
+		Registry &registry = getRegistry();
+		const uint32_t node_count = registry.nodeCount.load(std::memory_order_acquire);
+		Sample out;
+
+		for (uint32_t node = 1; node < node_count; ++node) {
+			if (registry.nodes[node].zone == zone) {
+				const Sample sample = difference(now, before, node);
+				out.time += sample.time;
+				out.count += sample.count;
+			}
+		}
+
+		return out;
+	}
+
+	void Profiler::summary(double threshold) {
+		Snapshot baseline;
+		{
+			Registry &registry = getRegistry();
+			std::unique_lock lock(registry.baselineMutex);
+			baseline = registry.baseline;
+		}
+
+		const std::vector<Entry> entries = report(snapshot(), baseline);
+		if (entries.empty())
+			return;
+
+		std::cerr << "Profiler summary:\n";
+
+		auto get_name = [](const Entry &entry) {
+			return getName(entry.zone);
+		};
+
+		size_t max_length = 0;
+		for (const Entry &entry: entries)
+			max_length = std::max(max_length, 2 * entry.depth + get_name(entry).size());
+
+		for (const Entry &entry: entries) {
+			const double nanos = entry.sample.time.count();
+			if (nanos / 1e9 < threshold)
+				continue;
+
+			const std::string name = get_name(entry);
+			const size_t indent = 2 * entry.depth;
+			std::cerr << "    " << std::string(indent, ' ') << "\e[1m" << name << std::string(max_length - indent - name.size(), ' ')
+			          << "\e[22m took \e[32m" << (nanos / 1e9) << "\e[39m seconds";
+			if (1 < entry.sample.count)
+				std::cerr << " (average: \e[33m" << (nanos / double(entry.sample.count) / 1e9) << "\e[39m over \e[1m"
+				          << entry.sample.count << "\e[22m instances)";
+			std::cerr << '\n';
+		}
+	}
+
+	void Profiler::clear() {
+		Snapshot now = snapshot();
+		Registry &registry = getRegistry();
+		std::unique_lock lock(registry.baselineMutex);
+		registry.baseline = std::move(now);
+	}
+
+	ProfileZone::ProfileZone(ProfileZoneID zone_):
+		zone(zone_),
+		node(Profiler::enter(zone_, parent)),
+		start(std::chrono::steady_clock::now()) {}
+
+	ProfileZone::~ProfileZone() {
+		stop();
+	}
+
+	std::chrono::nanoseconds ProfileZone::difference() const {
+		return std::chrono::steady_clock::now() - start;
+	}
+
+	void ProfileZone::stop() {
+		if (!stopped) {
+			Profiler::leave(node, parent, difference());
+			stopped = true;
+		}
+	}
+
+	void ProfileZone::restart() {
+		if (stopped) {
+			node = Profiler::enter(zone, parent);
+			stopped = false;
+		}
+
+		start = std::chrono::steady_clock::now();
+	}
+}
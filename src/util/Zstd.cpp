@@ -102,9 +102,13 @@ namespace Game3 {
 	}
 
 	std::vector<uint8_t> compress(std::span<const uint8_t> span) {
+		return compress(span, ZSTD_maxCLevel());
+	}
+
+	std::vector<uint8_t> compress(std::span<const uint8_t> span, int level) {
 		const auto buffer_size = ZSTD_compressBound(span.size_bytes());
 		auto buffer = std::vector<uint8_t>(buffer_size);
-		auto result = ZSTD_compress(&buffer[0], buffer_size, span.data(), span.size_bytes(), ZSTD_maxCLevel());
+		auto result = ZSTD_compress(&buffer[0], buffer_size, span.data(), span.size_bytes(), level);
 		if (ZSTD_isError(result))
 			throw std::runtime_error("Couldn't compress data");
 		buffer.resize(result);
@@ -0,0 +1,95 @@
+#include "Log.h"
+#include "game/Game.h"
+#include "realm/Realm.h"
+#include "worldgen/GenerationPipeline.h"
+#include "worldgen/WorldGen.h"
+
+#include <nlohmann/json.hpp>
+
+namespace Game3 {
+	namespace {
+		int64_t getDistance(ChunkPosition chunk_position, const std::vector<ChunkPosition> &focuses) {
+			int64_t out = INT64_MAX;
+			for (const ChunkPosition focus: focuses) {
+				const int64_t x_distance = std::abs(int64_t(chunk_position.x) - focus.x);
+				const int64_t y_distance = std::abs(int64_t(chunk_position.y) - focus.y);
+				out = std::min(out, std::max(x_distance, y_distance));
+			}
+			return out;
+		}
+	}
+
+	GenerationPipeline::GenerationPipeline(Realm &realm_):
+		realm(realm_) {}
+
+	void GenerationPipeline::request(ChunkPosition chunk_position) {
+		if (!inFlight.contains(chunk_position))
+			waiting.insert(chunk_position);
+	}
+
+	bool GenerationPipeline::isPending(ChunkPosition chunk_position) const {
+		return waiting.contains(chunk_position) || inFlight.contains(chunk_position);
+	}
+
+	std::vector<GenerationPipeline::Result> GenerationPipeline::tick(const std::vector<ChunkPosition> &focuses) {
+		std::vector<Result> out;
+
+		for (Result &result: finished.steal()) {
+			inFlight.erase(result.first);
+			out.push_back(std::move(result));
+		}
+
+		while (inFlight.size() < MAX_IN_FLIGHT && !waiting.empty()) {
+			auto best = waiting.begin();
+
+			if (!focuses.empty()) {
+				int64_t best_distance = INT64_MAX;
+				for (auto iter = waiting.begin(); iter != waiting.end(); ++iter) {
+					if (const int64_t distance = getDistance(*iter, focuses); distance < best_distance) {
+						best_distance = distance;
+						best = iter;
+					}
+				}
+			}
+
+			const ChunkPosition chunk_position = *best;
+			waiting.erase(best);
+			start(chunk_position);
+		}
+
+		return out;
+	}
+
+	void GenerationPipeline::start(ChunkPosition chunk_position) {
+		// Serialize the realm's metadata here rather than in the job because it reads state owned by the tick thread.
+		auto json = std::make_shared<nlohmann::json>();
+		realm.toJSON(*json, false);
+
+		inFlight.insert(chunk_position);
+		WorldGen::backgroundPool.start();
+
+		WorldGen::backgroundPool.add([weak_game = std::weak_ptr(realm.getGame().shared_from_this()), weak_realm = realm.weak_from_this(), json, chunk_position](ThreadPool &, size_t) {
+			GamePtr game = weak_game.lock();
+			if (!game)
+				return;
+
+			std::shared_ptr<Realm> scratch;
+
+			try {
+				scratch = Realm::fromJSON(*game, *json, false);
+				// Tile entities are spawned once they're moved into the live realm, not here.
+				scratch->scratch = true;
+				// The scratch realm only needs the chunk being generated, so it shouldn't page anything in from the database.
+				scratch->tileProvider.chunkLoader = {};
+				scratch->tileProvider.ensureAllChunks(chunk_position);
+				scratch->generateChunk(chunk_position);
+			} catch (const std::exception &err) {
+				ERROR("Couldn't generate chunk " << chunk_position << " in the background: " << err.what());
+				scratch.reset();
+			}
+
+			if (std::shared_ptr<Realm> realm = weak_realm.lock())
+				realm->generationPipeline.finished.emplace(chunk_position, std::move(scratch));
+		});
+	}
+}
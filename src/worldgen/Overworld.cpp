@@ -36,11 +36,8 @@ namespace Game3::WorldGen {
 		for (auto y = range.topLeft.y; y <= range.bottomRight.y; ++y) {
 			for (auto x = range.topLeft.x; x <= range.bottomRight.x; ++x) {
 				provider.ensureAllChunks(ChunkPosition{x, y});
-				for (const Layer layer: allLayers) {
-					TileChunk &chunk = provider.getTileChunk(layer, ChunkPosition{x, y});
-					auto lock = chunk.uniqueLock();
-					chunk.assign(chunk.size(), tileset.getEmptyID());
-				}
+				for (const Layer layer: allLayers)
+					*provider.getTileChunk(layer, ChunkPosition{x, y}) = std::vector<TileID>(CHUNK_SIZE * CHUNK_SIZE, tileset.getEmptyID());
 			}
 		}
 
@@ -5,6 +5,7 @@
 namespace Game3 {
 	namespace WorldGen {
 		ThreadPool pool{5};
+		ThreadPool backgroundPool{2};
 	}
 
 	void from_json(const nlohmann::json &json, WorldGenParams &params) {